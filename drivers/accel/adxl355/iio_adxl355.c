@@ -973,9 +973,11 @@ static int adxl355_iio_update_channels(void* dev, uint32_t mask)
 *******************************************************************************/
 static int32_t adxl355_trigger_handler(struct iio_device_data *dev_data)
 {
-	int32_t data_buff[3];
+	int32_t *data_buff;
 	uint32_t x, y, z;
+	uint32_t nb_scans;
 	uint8_t i = 0;
+	int ret;
 
 	struct adxl355_iio_dev *iio_adxl355;
 	struct adxl355_dev *adxl355;
@@ -990,7 +992,15 @@ static int32_t adxl355_trigger_handler(struct iio_device_data *dev_data)
 
 	adxl355 = iio_adxl355->adxl355_dev;
 
-	adxl355_get_raw_xyz(adxl355, &x, &y, &z);
+	ret = adxl355_get_raw_xyz(adxl355, &x, &y, &z);
+	if (ret)
+		return ret;
+
+	/* Build the scan directly in the buffer */
+	ret = iio_buffer_reserve_scans(dev_data->buffer, 1, (void **)&data_buff,
+				       &nb_scans);
+	if (ret)
+		return ret;
 
 	if (dev_data->buffer->active_mask & NO_OS_BIT(0)) {
 		data_buff[0] = no_os_sign_extend32(x, 19);
@@ -1005,7 +1015,7 @@ static int32_t adxl355_trigger_handler(struct iio_device_data *dev_data)
 		i++;
 	}
 
-	return iio_buffer_push_scan(dev_data->buffer, &data_buff[0]);
+	return iio_buffer_commit_scans(dev_data->buffer, 1);
 }
 
 /***************************************************************************//**
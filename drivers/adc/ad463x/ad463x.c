@@ -41,6 +41,7 @@
 #include "no_os_print_log.h"
 #include "no_os_alloc.h"
 #include "no_os_spi.h"
+#include "no_os_unpack.h"
 
 #define AD463x_TEST_DATA 0xAA
 
@@ -451,41 +452,20 @@ int32_t ad463x_read_data_offload(struct ad463x_dev *dev,
 }
 
 /**
- * @brief Parallel Bits Extract
- * @param in0 - fist byte of interleaved data
- * @param in1 - second byte of interleaved data
- * @param out0 - unscrambled byte 0
- * @param out1 - unscrambled byte 1
+ * @brief Assemble a sample from the bytes of its lane
+ * @param dev - ad463x_dev device handler.
+ * @param lane - de-interleaved bytes of the sample, MSB first
+ * @param size - number of bytes of the sample, 4 at most
+ * @return the sample
  */
-static void ad463x_pext(uint8_t in0, uint8_t in1,
-			uint8_t *out0, uint8_t *out1)
+static uint32_t ad463x_lane_sample(struct ad463x_dev *dev,
+				   const uint8_t *lane, uint32_t size)
 {
-	uint8_t high0, high1, low0, low1;
+	uint8_t data[4] = {0};
 
-	high0 = in0;
-	low1 = in1;
-	high1 = high0 << 1;
-	low0 = low1 >> 1;
+	memcpy(data, lane, size);
 
-	high0 &= 0xAA;
-	high1 &= 0xAA;
-	low0 &= 0x55;
-	low1 &= 0x55;
-
-	high0 = (high0 | high0 << 001) & 0xCC;
-	high0 = (high0 | high0 << 002) & 0xF0;
-
-	high1 = (high1 | high1 << 001) & 0xCC;
-	high1 = (high1 | high1 << 002) & 0xF0;
-
-	low0 = (low0 | low0 >> 001) & 0x33;
-	low0 = (low0 | low0 >> 002) & 0x0F;
-
-	low1 = (low1 | low1 >> 001) & 0x33;
-	low1 = (low1 | low1 >> 002) & 0x0F;
-
-	*out0 = high0 | low0;
-	*out1 = high1 | low1;
+	return no_os_get_unaligned_be32(data) >> (32 - dev->real_bits_precision);
 }
 
 /**
@@ -503,22 +483,12 @@ static void ad463x_pext_sample(struct ad463x_dev *dev,
 	uint8_t data[8] = {0};
 	uint8_t ch0[4];
 	uint8_t ch1[4];
-	int shift;
 
 	memcpy(data, buf, size);
-	ad463x_pext(data[0], data[1], &ch0[0], &ch1[0]);
-	ad463x_pext(data[2], data[3], &ch0[1], &ch1[1]);
-	ad463x_pext(data[4], data[5], &ch0[2], &ch1[2]);
-	ad463x_pext(data[6], data[7], &ch0[3], &ch1[3]);
-
-	*ch0_out = no_os_get_unaligned_be32(ch0);
-	*ch1_out = no_os_get_unaligned_be32(ch1);
-
-	shift = 32 - dev->real_bits_precision;
-	if (shift) {
-		*ch1_out >>= shift;
-		*ch0_out >>= shift;
-	}
+	no_os_unpack_deinterleave2(data, 4, ch0, ch1);
+
+	*ch0_out = ad463x_lane_sample(dev, ch0, 4);
+	*ch1_out = ad463x_lane_sample(dev, ch1, 4);
 }
 
 /**
@@ -569,12 +539,16 @@ static int32_t ad463x_read_data_dma(struct ad463x_dev *dev,
 	uint32_t *p_buf = buf;
 	uint8_t tx_buf = 0;
 	uint8_t *rx_buf, *rx_sample;
+	uint8_t *ch0, *ch1;
+	uint32_t rx_len, lane_bytes;
 	int ret, i;
 
 	if (!dev)
 		return -EINVAL;
 
-	rx_buf = no_os_calloc(1, samples * dev->read_bytes_no);
+	/* The second half receives the de-interleaved lanes. */
+	rx_len = samples * dev->read_bytes_no;
+	rx_buf = no_os_calloc(2, rx_len);
 	if (!rx_buf)
 		return -ENOMEM;
 
@@ -594,10 +568,27 @@ static int32_t ad463x_read_data_dma(struct ad463x_dev *dev,
 	if (ret != 0)
 		goto out;
 
-	rx_sample = rx_buf;
+	if (dev->read_bytes_no % 2) {
+		/* Samples don't take whole byte pairs, split them one by one. */
+		rx_sample = rx_buf;
+		for (i = 0; i < samples; i++) {
+			ad463x_pext_sample(dev, rx_sample, dev->read_bytes_no,
+					   p_buf, p_buf + 1);
+			rx_sample += dev->read_bytes_no;
+			p_buf += 2;
+		}
+		goto out;
+	}
+
+	lane_bytes = dev->read_bytes_no / 2;
+	ch0 = rx_buf + rx_len;
+	ch1 = ch0 + rx_len / 2;
+	no_os_unpack_deinterleave2(rx_buf, rx_len / 2, ch0, ch1);
 	for (i = 0; i < samples; i++) {
-		ad463x_pext_sample(dev, rx_sample, 6, p_buf, p_buf + 1);
-		rx_sample += dev->read_bytes_no;
+		p_buf[0] = ad463x_lane_sample(dev, ch0, lane_bytes);
+		p_buf[1] = ad463x_lane_sample(dev, ch1, lane_bytes);
+		ch0 += lane_bytes;
+		ch1 += lane_bytes;
 		p_buf += 2;
 	}
 out:
@@ -41,6 +41,7 @@
 #include "no_os_util.h"
 #include "no_os_crc.h"
 #include "no_os_alloc.h"
+#include "no_os_unpack.h"
 
 #ifdef XILINX_PLATFORM
 #include "no_os_axi_io.h"
@@ -525,60 +526,6 @@ int32_t ad7606_reg_write_mask(struct ad7606_dev *dev,
 	return ad7606_reg_write(dev, addr, reg_data);
 }
 
-/* Internal function to copy the content of a buffer in 18-bit chunks to a 32-bit buffer by
- * extending the chunks to 32-bit size. */
-static int32_t cpy18b32b(uint8_t *psrc, uint32_t srcsz, uint32_t *pdst)
-{
-	unsigned int i, j;
-
-	if (srcsz % 9)
-		return -EINVAL;
-
-	for (i = 0; i < srcsz; i += 9) {
-		j = 4 * (i / 9);
-		pdst[j + 0] = ((uint32_t)(psrc[i + 0] & 0xff) << 10) | ((
-					uint32_t)psrc[i + 1] << 2)
-			      | ((uint32_t)psrc[i + 2] >> 6);
-		pdst[j + 1] = ((uint32_t)(psrc[i + 2] & 0x3f) << 12) | ((
-					uint32_t)psrc[i + 3] << 4)
-			      | ((uint32_t)psrc[i + 4] >> 4);
-		pdst[j + 2] = ((uint32_t)(psrc[i + 4] & 0x0f) << 14) | ((
-					uint32_t)psrc[i + 5] << 6)
-			      | ((uint32_t)psrc[i + 6] >> 2);
-		pdst[j + 3] = ((uint32_t)(psrc[i + 6] & 0x03) << 16) | ((
-					uint32_t)psrc[i + 7] << 8)
-			      | ((uint32_t)psrc[i + 8] >> 0);
-	}
-	return 0;
-}
-
-/* Internal function to copy the content of a buffer in 26-bit chunks to a 32-bit buffer by
- * extending the chunks to 32-bit size. */
-static int32_t cpy26b32b(uint8_t *psrc, uint32_t srcsz, uint32_t *pdst)
-{
-	unsigned int i, j;
-
-	if (srcsz % 13)
-		return -EINVAL;
-
-	for (i = 0; i < srcsz; i += 13) {
-		j = 4 * (i / 13);
-		pdst[j + 0] = ((uint32_t)(psrc[i + 0] & 0xff) << 18) | ((
-					uint32_t)psrc[i + 1] << 10)
-			      | ((uint32_t)psrc[i + 2] << 2) | ((uint32_t)psrc[i + 3] >> 6);
-		pdst[j + 1] = ((uint32_t)(psrc[i + 3] & 0x3f) << 20) | ((
-					uint32_t)psrc[i + 4] << 12)
-			      | ((uint32_t)psrc[i + 5] << 4) | ((uint32_t)psrc[i + 6] >> 4);
-		pdst[j + 2] = ((uint32_t)(psrc[i + 6] & 0x0f) << 22) | ((
-					uint32_t)psrc[i + 7] << 14)
-			      | ((uint32_t)psrc[i + 8] << 6) | ((uint32_t)psrc[i + 9] >> 2);
-		pdst[j + 3] = ((uint32_t)(psrc[i + 9] & 0x03) << 24) | ((
-					uint32_t)psrc[i + 10] << 16)
-			      | ((uint32_t)psrc[i + 11] << 8) | ((uint32_t)psrc[i + 12] >> 0);
-	}
-	return 0;
-}
-
 /***************************************************************************//**
  * @brief Toggle the CONVST pin to start a conversion.
  *
@@ -638,7 +585,7 @@ int32_t ad7606_convst(struct ad7606_dev *dev)
 int32_t ad7606_spi_data_read(struct ad7606_dev *dev, uint32_t *data)
 {
 	uint32_t sz;
-	int32_t ret, i;
+	int32_t ret;
 	uint16_t crc, icrc;
 	uint8_t bits = ad7606_chip_info_tbl[dev->device_id].bits;
 	uint8_t sbits = dev->config.status_header ? 8 : 0;
@@ -676,24 +623,27 @@ int32_t ad7606_spi_data_read(struct ad7606_dev *dev, uint32_t *data)
 
 	switch (bits) {
 	case 18:
-		if (dev->config.status_header)
-			ret = cpy26b32b(dev->data, sz, data);
-		else
-			ret = cpy18b32b(dev->data, sz, data);
+		/* Groups of 4 samples always take a whole number of bytes */
+		if (dev->config.status_header) {
+			if (sz % 13)
+				return -EINVAL;
+			ret = no_os_unpack(dev->data, data, sz * 8 / 26, 26,
+					   NO_OS_UNPACK_BE);
+		} else {
+			if (sz % 9)
+				return -EINVAL;
+			ret = no_os_unpack(dev->data, data, sz * 8 / 18, 18,
+					   NO_OS_UNPACK_BE);
+		}
 		if (ret < 0)
 			return ret;
 		break;
 	case 16:
-		for (i = 0; i < nchannels; i++) {
-			if (dev->config.status_header) {
-				data[i] = (uint32_t)dev->data[i * 3] << 16;
-				data[i] |= (uint32_t)dev->data[i * 3 + 1] << 8;
-				data[i] |= (uint32_t)dev->data[i * 3 + 2];
-			} else {
-				data[i] = (uint32_t)dev->data[i * 2] << 8;
-				data[i] |= (uint32_t)dev->data[i * 2 + 1];
-			}
-		}
+		ret = no_os_unpack(dev->data, data, nchannels,
+				   dev->config.status_header ? 24 : 16,
+				   NO_OS_UNPACK_BE);
+		if (ret < 0)
+			return ret;
 		break;
 	default:
 		ret = -ENOTSUP;
@@ -36,6 +36,7 @@
 #include "stdbool.h"
 #include <string.h>
 #include "ad77681.h"
+#include "no_os_crc8.h"
 #include "no_os_error.h"
 #include "no_os_delay.h"
 #include "no_os_alloc.h"
@@ -51,21 +52,7 @@ uint8_t ad77681_compute_crc8(uint8_t *data,
 			     uint8_t data_size,
 			     uint8_t init_val)
 {
-	uint8_t i;
-	uint8_t crc = init_val;
-
-	while (data_size) {
-		for (i = 0x80; i != 0; i >>= 1) {
-			if (((crc & 0x80) != 0) != ((*data & i) != 0)) {
-				crc <<= 1;
-				crc ^= AD77681_CRC8_POLY;
-			} else
-				crc <<= 1;
-		}
-		data++;
-		data_size--;
-	}
-	return crc;
+	return no_os_crc8_poly07(data, data_size, init_val);
 }
 
 /**
@@ -34,6 +34,7 @@
 #include <inttypes.h>
 #include "no_os_spi.h"
 #include <stdlib.h>
+#include <stdbool.h>
 #include "no_os_error.h"
 #include "no_os_mutex.h"
 #include "no_os_alloc.h"
@@ -149,6 +150,314 @@ void no_os_spibus_remove(uint32_t bus_number)
 	}
 }
 
+/**
+ * @brief Try to take ownership of the bus.
+ * @param bus - The SPI bus descriptor.
+ * @return true if the caller now owns the bus.
+ */
+static bool no_os_spibus_claim(struct no_os_spibus_desc *bus)
+{
+	return !__atomic_exchange_n(&bus->busy, true, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Move the submitted transactions to their priority class queue and
+ * pick the next one. Higher classes go first. Inside a class, the oldest
+ * transaction of a slave other than the last served one is picked, so
+ * slaves sharing the bus alternate. Must be called by the bus owner.
+ * @param bus - The SPI bus descriptor.
+ * @return The next transaction or NULL if none is waiting.
+ */
+static struct no_os_spi_xfer *no_os_spibus_next(struct no_os_spibus_desc *bus)
+{
+	struct no_os_spi_xfer *list;
+	struct no_os_spi_xfer *rev;
+	struct no_os_spi_xfer *xfer;
+	struct no_os_spi_xfer *prev;
+	uint32_t i;
+
+	/* The intake is a stack, reverse it to keep the submission order */
+	list = __atomic_exchange_n(&bus->intake, NULL, __ATOMIC_ACQUIRE);
+	rev = NULL;
+	while (list) {
+		xfer = list;
+		list = list->next;
+		xfer->next = rev;
+		rev = xfer;
+	}
+	while (rev) {
+		xfer = rev;
+		rev = rev->next;
+		xfer->next = NULL;
+		if (bus->queue_tail[xfer->prio])
+			bus->queue_tail[xfer->prio]->next = xfer;
+		else
+			bus->queue_head[xfer->prio] = xfer;
+		bus->queue_tail[xfer->prio] = xfer;
+	}
+
+	for (i = 0; i < NO_OS_SPI_PRIO_CNT; i++) {
+		if (!bus->queue_head[i])
+			continue;
+
+		prev = NULL;
+		xfer = bus->queue_head[i];
+		while (xfer && xfer->desc == bus->last_desc) {
+			prev = xfer;
+			xfer = xfer->next;
+		}
+		if (!xfer) {
+			prev = NULL;
+			xfer = bus->queue_head[i];
+		}
+
+		if (prev)
+			prev->next = xfer->next;
+		else
+			bus->queue_head[i] = xfer->next;
+		if (bus->queue_tail[i] == xfer)
+			bus->queue_tail[i] = prev;
+		xfer->next = NULL;
+
+		return xfer;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Send a list of messages and wait for the completion. The caller
+ * must own the bus.
+ * @param desc - The SPI descriptor.
+ * @param msgs - Array of messages.
+ * @param len - Number of messages in the array.
+ * @return 0 in case of success, negativ error code otherwise.
+ */
+static int32_t no_os_spi_transfer_sync(struct no_os_spi_desc *desc,
+				       struct no_os_spi_msg *msgs,
+				       uint32_t len)
+{
+	int32_t  ret = 0;
+	uint32_t i;
+
+	if (desc->platform_ops->transfer)
+		return desc->platform_ops->transfer(desc, msgs, len);
+
+	if (!desc->platform_ops->write_and_read)
+		return -ENOSYS;
+
+	for (i = 0; i < len; i++) {
+		if (msgs[i].rx_buff != msgs[i].tx_buff || !msgs[i].tx_buff)
+			return -EINVAL;
+		ret = desc->platform_ops->write_and_read(desc, msgs[i].rx_buff,
+				msgs[i].bytes_number);
+		if (NO_OS_IS_ERR_VALUE(ret))
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Mark a transaction as done and invoke its callback.
+ * @param xfer - The transaction.
+ * @param status - Result of the transaction.
+ */
+static void no_os_spi_xfer_complete(struct no_os_spi_xfer *xfer,
+				    int32_t status)
+{
+	void (*callback)(struct no_os_spi_xfer *xfer) = xfer->callback;
+
+	xfer->status = status;
+	/* The owner may reuse xfer as soon as done is seen */
+	__atomic_store_n(&xfer->done, true, __ATOMIC_RELEASE);
+	if (callback)
+		callback(xfer);
+}
+
+static void no_os_spibus_run(struct no_os_spibus_desc *bus);
+
+/**
+ * @brief Completion callback of a transaction started on the DMA. Continues
+ * with the next queued transaction.
+ * @param ctx - The SPI bus descriptor.
+ */
+static void no_os_spibus_dma_done(void *ctx)
+{
+	struct no_os_spibus_desc *bus = ctx;
+	struct no_os_spi_xfer *xfer = bus->current;
+
+	bus->current = NULL;
+	no_os_spi_xfer_complete(xfer, 0);
+	no_os_spibus_run(bus);
+}
+
+/**
+ * @brief Run the queued transactions back-to-back, then release the bus.
+ * Returns early when a transaction is started on the DMA, its completion
+ * callback continues the queue. Must be called by the bus owner.
+ * @param bus - The SPI bus descriptor.
+ */
+static void no_os_spibus_run(struct no_os_spibus_desc *bus)
+{
+	const struct no_os_spi_platform_ops *ops;
+	struct no_os_spi_xfer *xfer;
+	int32_t ret;
+
+	while (true) {
+		xfer = no_os_spibus_next(bus);
+		if (!xfer) {
+			__atomic_store_n(&bus->busy, false, __ATOMIC_RELEASE);
+			/* Take back the bus if a transaction came in meanwhile */
+			if (!__atomic_load_n(&bus->intake, __ATOMIC_ACQUIRE) ||
+			    !no_os_spibus_claim(bus))
+				return;
+			continue;
+		}
+
+		bus->last_desc = xfer->desc;
+		if (xfer->handoff) {
+			/* The waiting caller runs the transfer and the queue */
+			__atomic_store_n(&xfer->done, true, __ATOMIC_RELEASE);
+			return;
+		}
+
+		ops = xfer->desc->platform_ops;
+		if (xfer->dma && ops->transfer_dma_async) {
+			bus->current = xfer;
+			ret = ops->transfer_dma_async(xfer->desc, xfer->msgs, xfer->len,
+						      no_os_spibus_dma_done, bus);
+			if (!ret)
+				return;
+			bus->current = NULL;
+			if (ret != -ENOSYS) {
+				no_os_spi_xfer_complete(xfer, ret);
+				continue;
+			}
+		}
+
+		ret = no_os_spi_transfer_sync(xfer->desc, xfer->msgs, xfer->len);
+		no_os_spi_xfer_complete(xfer, ret);
+	}
+}
+
+/**
+ * @brief Add a transaction to the intake list of a bus.
+ * @param bus - The SPI bus descriptor.
+ * @param xfer - The transaction.
+ */
+static void no_os_spibus_push(struct no_os_spibus_desc *bus,
+			      struct no_os_spi_xfer *xfer)
+{
+	xfer->next = __atomic_load_n(&bus->intake, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&bus->intake, &xfer->next, xfer,
+					    true, __ATOMIC_RELEASE,
+					    __ATOMIC_RELAXED))
+		;
+}
+
+/**
+ * @brief Queue a transaction on the bus of its slave. If the bus is idle, the
+ * transaction is started before returning. Otherwise it is started by the
+ * context that owns the bus, usually the DMA completion of the running
+ * transaction. Can be called from interrupt context and from callbacks.
+ * @param xfer - The transaction. desc, msgs, len and prio must be set.
+ * @return 0 in case of success, negativ error code otherwise. The result of
+ * the transfer is reported in xfer->status.
+ */
+int32_t no_os_spi_submit(struct no_os_spi_xfer *xfer)
+{
+	struct no_os_spibus_desc *bus;
+
+	if (!xfer || !xfer->desc || !xfer->desc->platform_ops ||
+	    !xfer->desc->bus || !xfer->msgs || !xfer->len ||
+	    xfer->prio >= NO_OS_SPI_PRIO_CNT)
+		return -EINVAL;
+
+	bus = xfer->desc->bus;
+	xfer->status = 0;
+	xfer->done = false;
+	xfer->handoff = false;
+
+	no_os_spibus_push(bus, xfer);
+	if (no_os_spibus_claim(bus))
+		no_os_spibus_run(bus);
+
+	return 0;
+}
+
+/**
+ * @brief Check if a queued transaction is done.
+ * @param xfer - The transaction.
+ * @return true if the transaction is done and xfer->status is valid.
+ */
+bool no_os_spi_xfer_is_done(struct no_os_spi_xfer *xfer)
+{
+	return __atomic_load_n(&xfer->done, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Check if the caller runs in interrupt context or with interrupts
+ * masked. Either way the owner of the bus can't run while the caller waits.
+ * Only known on Cortex-M cores, other platforms override it.
+ * @return true if the caller must not wait for the bus.
+ */
+__attribute__((weak)) bool no_os_spi_in_irq(void)
+{
+#if defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+	uint32_t primask;
+	uint32_t ipsr;
+
+	__asm volatile("mrs %0, ipsr" : "=r"(ipsr));
+	__asm volatile("mrs %0, primask" : "=r"(primask));
+
+	return ipsr != 0 || primask != 0;
+#else
+	return false;
+#endif
+}
+
+/**
+ * @brief Wait for the bus in the high priority class, then transfer a list of
+ * messages from the caller context. Used by the blocking API when the bus is
+ * owned by the queue.
+ * @param desc - The SPI descriptor.
+ * @param msgs - Array of messages.
+ * @param len - Number of messages in the array.
+ * @return 0 in case of success, -EBUSY in interrupt context, since the owner
+ * of the bus may be the interrupted code, negativ error code otherwise.
+ */
+static int32_t no_os_spi_transfer_queued(struct no_os_spi_desc *desc,
+		struct no_os_spi_msg *msgs,
+		uint32_t len)
+{
+	struct no_os_spibus_desc *bus = desc->bus;
+	struct no_os_spi_xfer xfer = {
+		.desc = desc,
+		.msgs = msgs,
+		.len = len,
+		.prio = NO_OS_SPI_PRIO_HIGH,
+		.handoff = true,
+	};
+	int32_t ret;
+
+	if (no_os_spi_in_irq())
+		return -EBUSY;
+
+	no_os_spibus_push(bus, &xfer);
+	if (no_os_spibus_claim(bus))
+		no_os_spibus_run(bus);
+
+	/* The bus is ours once the queue reaches xfer */
+	while (!no_os_spi_xfer_is_done(&xfer))
+		;
+
+	ret = no_os_spi_transfer_sync(desc, msgs, len);
+	no_os_spibus_run(bus);
+
+	return ret;
+}
+
 /**
  * @brief Write and read data to/from SPI.
  * @param desc - The SPI descriptor.
@@ -160,6 +469,11 @@ int32_t no_os_spi_write_and_read(struct no_os_spi_desc *desc,
 				 uint8_t *data,
 				 uint16_t bytes_number)
 {
+	struct no_os_spi_msg msg = {
+		.tx_buff = data,
+		.rx_buff = data,
+		.bytes_number = bytes_number,
+	};
 	int32_t ret;
 
 	if (!desc || !desc->platform_ops)
@@ -169,7 +483,13 @@ int32_t no_os_spi_write_and_read(struct no_os_spi_desc *desc,
 		return -ENOSYS;
 
 	no_os_mutex_lock(desc->bus->mutex);
-	ret =  desc->platform_ops->write_and_read(desc, data, bytes_number);
+	if (no_os_spibus_claim(desc->bus)) {
+		ret = desc->platform_ops->write_and_read(desc, data, bytes_number);
+		no_os_spibus_run(desc->bus);
+	} else {
+		/* Queued transactions are running, wait for our turn */
+		ret = no_os_spi_transfer_queued(desc, &msg, 1);
+	}
 	no_os_mutex_unlock(desc->bus->mutex);
 
 	return ret;
@@ -186,31 +506,21 @@ int32_t no_os_spi_transfer(struct no_os_spi_desc *desc,
 			   struct no_os_spi_msg *msgs,
 			   uint32_t len)
 {
-	int32_t  ret = 0;
-	uint32_t i;
+	int32_t ret;
 
 	if (!desc || !desc->platform_ops)
 		return -EINVAL;
 
-	if (desc->platform_ops->transfer)
-		return desc->platform_ops->transfer(desc, msgs, len);
-
 	no_os_mutex_lock(desc->bus->mutex);
-
-	for (i = 0; i < len; i++) {
-		if (msgs[i].rx_buff != msgs[i].tx_buff || !msgs[i].tx_buff) {
-			ret = -EINVAL;
-			goto out;
-		}
-		ret = no_os_spi_write_and_read(desc, msgs[i].rx_buff,
-					       msgs[i].bytes_number);
-		if (NO_OS_IS_ERR_VALUE(ret)) {
-			goto out;
-		}
+	if (no_os_spibus_claim(desc->bus)) {
+		ret = no_os_spi_transfer_sync(desc, msgs, len);
+		no_os_spibus_run(desc->bus);
+	} else {
+		/* Queued transactions are running, wait for our turn */
+		ret = no_os_spi_transfer_queued(desc, msgs, len);
 	}
-
-out:
 	no_os_mutex_unlock(desc->bus->mutex);
+
 	return ret;
 }
 
@@ -35,12 +35,37 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include "no_os_axi_io.h"
 #include "no_os_error.h"
 #include "no_os_delay.h"
 #include "no_os_alloc.h"
 #include "axi_dmac.h"
 
+/*******************************************************************************
+ * @brief Handle the interrupts of a transfer that was submitted to the DMAC in
+ *			one go (2D or scatter-gather). Nothing is left to be queued, so
+ *			only the end of transfer is of interest.
+ *
+ * @param dmac - DMAC istance.
+ * @param irq_pending - Interrupt sources read from AXI_DMAC_REG_IRQ_PENDING.
+ *
+ * @return true if the interrupt was handled, false otherwise.
+*******************************************************************************/
+static bool axi_dmac_single_submit_isr(struct axi_dmac *dmac,
+				       uint32_t irq_pending)
+{
+	if (!dmac->single_submit)
+		return false;
+
+	if ((irq_pending & AXI_DMAC_IRQ_EOT) && (dmac->transfer.cyclic != CYCLIC)) {
+		dmac->single_submit = false;
+		dmac->transfer.transfer_done = true;
+	}
+
+	return true;
+}
+
 /*******************************************************************************
  * @brief ISR for dev to mem DMA transfer. It computes the next transfer params,
  *			if any, and sets the transfer structure fields accordingly.
@@ -57,6 +82,9 @@ void axi_dmac_dev_to_mem_isr(void *instance)
 	axi_dmac_read(dmac, AXI_DMAC_REG_IRQ_PENDING, &reg_val);
 	axi_dmac_write(dmac, AXI_DMAC_REG_IRQ_PENDING, reg_val);
 
+	if (axi_dmac_single_submit_isr(dmac, reg_val))
+		return;
+
 	if (reg_val & AXI_DMAC_IRQ_SOT) {
 		if (dmac->remaining_size) {
 			/* See if remaining size is bigger than max transfer size and
@@ -106,6 +134,9 @@ void axi_dmac_mem_to_dev_isr(void *instance)
 	axi_dmac_read(dmac, AXI_DMAC_REG_IRQ_PENDING, &reg_val);
 	axi_dmac_write(dmac, AXI_DMAC_REG_IRQ_PENDING, reg_val);
 
+	if (axi_dmac_single_submit_isr(dmac, reg_val))
+		return;
+
 	if (reg_val & AXI_DMAC_IRQ_SOT) {
 		if ((dmac->transfer.cyclic == CYCLIC) &&
 		    (dmac->next_src_addr >= (dmac->init_addr + dmac->transfer.size - 1))) {
@@ -161,6 +192,9 @@ void axi_dmac_mem_to_mem_isr(void *instance)
 	axi_dmac_read(dmac, AXI_DMAC_REG_IRQ_PENDING, &reg_val);
 	axi_dmac_write(dmac, AXI_DMAC_REG_IRQ_PENDING, reg_val);
 
+	if (axi_dmac_single_submit_isr(dmac, reg_val))
+		return;
+
 	if (reg_val & AXI_DMAC_IRQ_SOT) {
 		if (dmac->remaining_size) {
 			/** See if remaining size is bigger than max transfer size and
@@ -286,6 +320,17 @@ static int32_t axi_dmac_detect_caps(struct axi_dmac *dmac)
 	/* Restore initial value for AXI_DMAC_REG_FLAGS register */
 	axi_dmac_write(dmac, AXI_DMAC_REG_FLAGS, initial_reg_val);
 
+	/* Check if 2D transfers are possible */
+	axi_dmac_write(dmac, AXI_DMAC_REG_Y_LENGTH, 1);
+	axi_dmac_read(dmac, AXI_DMAC_REG_Y_LENGTH, &reg_val);
+	dmac->hw_2d = (reg_val == 1);
+	axi_dmac_write(dmac, AXI_DMAC_REG_Y_LENGTH, 0);
+
+	/* Check if the core was built with scatter-gather support */
+	axi_dmac_write(dmac, AXI_DMAC_REG_SG_ADDRESS, 0xffffffff);
+	axi_dmac_read(dmac, AXI_DMAC_REG_SG_ADDRESS, &reg_val);
+	dmac->hw_sg = (reg_val != 0);
+
 	/* Get maximum burst size and set value. */
 	axi_dmac_write(dmac, AXI_DMAC_REG_X_LENGTH, dmac->max_length);
 	axi_dmac_read(dmac, AXI_DMAC_REG_X_LENGTH, &dmac->max_length);
@@ -334,6 +379,7 @@ int32_t axi_dmac_init(struct axi_dmac **dmac_core,
 	dmac->name = init->name;
 	dmac->base = init->base;
 	dmac->irq_option = init->irq_option;
+	dmac->dcache_flush_range = init->dcache_flush_range;
 
 	int32_t status = axi_dmac_detect_caps(dmac);
 	if (status < 0)
@@ -360,6 +406,7 @@ int32_t axi_dmac_remove(struct axi_dmac *dmac)
 	if (!dmac)
 		return -1;
 
+	no_os_free(dmac->sg_mem);
 	no_os_free(dmac);
 
 	return 0;
@@ -377,15 +424,34 @@ int32_t axi_dmac_transfer_start(struct axi_dmac *dmac,
 				struct axi_dma_transfer *dma_transfer)
 {
 	uint32_t reg_val, burst_size;
+	uint32_t rows;
 
 	if (dma_transfer->size == 0)
 		return 0; /* Nothing to do. */
 
+	rows = dma_transfer->y_length ? dma_transfer->y_length : 1;
+	if (rows > 1) {
+		if (!dmac->hw_2d) {
+			printf("2D transfers not supported!\n");
+			return -1;
+		}
+		/* Each row has to fit in a single burst. */
+		if ((dma_transfer->size - 1) > dmac->max_length) {
+			printf("2D row size exceeds the maximum burst size.\n");
+			return -1;
+		}
+	}
+
 	/* Set current transfer parameters. */
 	dmac->transfer.size = dma_transfer->size;
 	dmac->transfer.cyclic = dma_transfer->cyclic;
 	dmac->transfer.dest_addr = dma_transfer->dest_addr;
 	dmac->transfer.src_addr = dma_transfer->src_addr;
+	dmac->transfer.y_length = rows;
+	dmac->transfer.src_stride = (rows > 1) ? dma_transfer->src_stride : 0;
+	dmac->transfer.dest_stride = (rows > 1) ? dma_transfer->dest_stride : 0;
+	dmac->transfer.transfer_done = false;
+	dmac->single_submit = false;
 
 	dmac->remaining_size = dma_transfer->size;
 	dmac->next_dest_addr = dma_transfer->dest_addr;
@@ -421,9 +487,10 @@ int32_t axi_dmac_transfer_start(struct axi_dmac *dmac,
 		axi_dmac_write(dmac, AXI_DMAC_REG_FLAGS, reg_val);
 	}
 
-	/* Enable DMA if not already enabled. */
+	/* Enable DMA if not already enabled, leaving scatter-gather mode. */
 	axi_dmac_read(dmac, AXI_DMAC_REG_CTRL, &reg_val);
-	if (!(reg_val & AXI_DMAC_CTRL_ENABLE)) {
+	if ((reg_val & (AXI_DMAC_CTRL_ENABLE | AXI_DMAC_CTRL_ENABLE_SG)) !=
+	    AXI_DMAC_CTRL_ENABLE) {
 		axi_dmac_write(dmac, AXI_DMAC_REG_CTRL, 0x0);
 		axi_dmac_write(dmac, AXI_DMAC_REG_CTRL, AXI_DMAC_CTRL_ENABLE);
 		axi_dmac_write(dmac, AXI_DMAC_REG_IRQ_MASK, 0x0);
@@ -437,7 +504,7 @@ int32_t axi_dmac_transfer_start(struct axi_dmac *dmac,
 		case DMA_DEV_TO_MEM:
 			dmac->init_addr = dmac->next_dest_addr;
 			axi_dmac_write(dmac, AXI_DMAC_REG_DEST_ADDRESS, dmac->next_dest_addr);
-			axi_dmac_write(dmac, AXI_DMAC_REG_DEST_STRIDE, 0x0);
+			axi_dmac_write(dmac, AXI_DMAC_REG_DEST_STRIDE, dmac->transfer.dest_stride);
 			if (dmac->transfer.dest_addr % (dmac->width_dst / 8)) {
 				printf("Destination address should be aligned with destination data path width.\n\n");
 				return -1;
@@ -446,7 +513,7 @@ int32_t axi_dmac_transfer_start(struct axi_dmac *dmac,
 		case DMA_MEM_TO_DEV:
 			dmac->init_addr = dmac->next_src_addr;
 			axi_dmac_write(dmac, AXI_DMAC_REG_SRC_ADDRESS, dmac->next_src_addr);
-			axi_dmac_write(dmac, AXI_DMAC_REG_SRC_STRIDE, 0x0);
+			axi_dmac_write(dmac, AXI_DMAC_REG_SRC_STRIDE, dmac->transfer.src_stride);
 			if (dmac->transfer.src_addr % (dmac->width_src / 8)) {
 				printf("Source address should be aligned with source data path width.\n");
 				return -1;
@@ -455,9 +522,9 @@ int32_t axi_dmac_transfer_start(struct axi_dmac *dmac,
 		case DMA_MEM_TO_MEM:
 			dmac->init_addr = dmac->next_src_addr;
 			axi_dmac_write(dmac, AXI_DMAC_REG_DEST_ADDRESS, dmac->next_dest_addr);
-			axi_dmac_write(dmac, AXI_DMAC_REG_DEST_STRIDE, 0x0);
+			axi_dmac_write(dmac, AXI_DMAC_REG_DEST_STRIDE, dmac->transfer.dest_stride);
 			axi_dmac_write(dmac, AXI_DMAC_REG_SRC_ADDRESS, dmac->next_src_addr);
-			axi_dmac_write(dmac, AXI_DMAC_REG_SRC_STRIDE, 0x0);
+			axi_dmac_write(dmac, AXI_DMAC_REG_SRC_STRIDE, dmac->transfer.src_stride);
 			if ((dmac->transfer.dest_addr % (dmac->width_dst / 8))
 			    || (dmac->transfer.src_addr % (dmac->width_src / 8))) {
 				printf("Source and destination addresses should be aligned with data path widths.\n");
@@ -494,9 +561,12 @@ int32_t axi_dmac_transfer_start(struct axi_dmac *dmac,
 		/* Compute remaining size. */
 		dmac->remaining_size = dmac->remaining_size - (burst_size + 1);
 
+		/* A 2D transfer always fits in a single submission. */
+		dmac->single_submit = (rows > 1);
+
 		/* Specify the length of the transfer and trigger transfer. */
 		axi_dmac_write(dmac, AXI_DMAC_REG_X_LENGTH, burst_size);
-		axi_dmac_write(dmac, AXI_DMAC_REG_Y_LENGTH, 0x0);
+		axi_dmac_write(dmac, AXI_DMAC_REG_Y_LENGTH, rows - 1);
 		axi_dmac_write(dmac, AXI_DMAC_REG_TRANSFER_SUBMIT, AXI_DMAC_TRANSFER_SUBMIT);
 	} else {
 		return -1;
@@ -505,6 +575,261 @@ int32_t axi_dmac_transfer_start(struct axi_dmac *dmac,
 	return 0;
 }
 
+/*******************************************************************************
+ * @brief Make room for a chain of scatter-gather descriptors. The chain is only
+ *			reallocated if it's too short.
+ *
+ * @param dmac - DMAC istance.
+ * @param nb_descs - Number of descriptors in the chain.
+ *
+ * @return 0 for success, -1 in case of failure.
+*******************************************************************************/
+static int32_t axi_dmac_sg_alloc(struct axi_dmac *dmac, uint32_t nb_descs)
+{
+	uintptr_t addr;
+
+	if (nb_descs <= dmac->sg_len)
+		return 0;
+
+	no_os_free(dmac->sg_mem);
+	dmac->sg_descs = NULL;
+	dmac->sg_len = 0;
+
+	/* One extra descriptor leaves room for aligning the chain. */
+	dmac->sg_mem = no_os_calloc(nb_descs + 1, sizeof(*dmac->sg_descs));
+	if (!dmac->sg_mem)
+		return -1;
+
+	addr = no_os_align((uintptr_t)dmac->sg_mem, AXI_DMAC_HW_DESC_ALIGN);
+	dmac->sg_descs = (struct axi_dmac_hw_desc *)addr;
+	dmac->sg_len = nb_descs;
+
+	return 0;
+}
+
+/*******************************************************************************
+ * @brief Start a scatter-gather DMA transfer. The transfers are chained in
+ *			memory and handed to the DMAC with a single submission, the core
+ *			fetching each descriptor on its own. The completion is reported
+ *			once, at the end of the last transfer.
+ *
+ * @note Only available if the core was built with scatter-gather support.
+ *		 Each transfer (or each row, for 2D transfers) has to fit in a single
+ *		 burst. The chain is cyclic if the first transfer is cyclic.
+ *
+ * @param dmac - DMAC istance.
+ * @param xfers - Array of transfers to be chained.
+ * @param nb_xfers - Number of transfers.
+ *
+ * @return 0 for success, -1 in case of failure.
+*******************************************************************************/
+int32_t axi_dmac_transfer_sg_start(struct axi_dmac *dmac,
+				   struct axi_dma_transfer *xfers,
+				   uint32_t nb_xfers)
+{
+	struct axi_dmac_hw_desc *hw;
+	uint32_t reg_val, rows, i;
+	uint32_t total_size = 0;
+	bool cyclic;
+
+	if (!nb_xfers)
+		return 0; /* Nothing to do. */
+
+	if (!dmac->hw_sg) {
+		printf("Scatter-gather transfers not supported!\n");
+		return -1;
+	}
+
+	cyclic = (xfers[0].cyclic == CYCLIC);
+	if (cyclic && (!dmac->hw_cyclic || dmac->direction != DMA_MEM_TO_DEV)) {
+		printf("Transfer mode not supported!\n");
+		return -1;
+	}
+
+	axi_dmac_read(dmac, AXI_DMAC_REG_TRANSFER_SUBMIT, &reg_val);
+	if (reg_val & AXI_DMAC_QUEUE_FULL)
+		return -1;
+
+	if (axi_dmac_sg_alloc(dmac, nb_xfers))
+		return -1;
+
+	for (i = 0; i < nb_xfers; i++) {
+		rows = xfers[i].y_length ? xfers[i].y_length : 1;
+		if (!xfers[i].size || ((xfers[i].size - 1) > dmac->max_length)) {
+			printf("Scatter-gather transfer %"PRIu32" has an invalid size.\n", i);
+			return -1;
+		}
+		if ((rows > 1) && !dmac->hw_2d) {
+			printf("2D transfers not supported!\n");
+			return -1;
+		}
+		if (((dmac->direction != DMA_MEM_TO_DEV) &&
+		     (xfers[i].dest_addr % (dmac->width_dst / 8))) ||
+		    ((dmac->direction != DMA_DEV_TO_MEM) &&
+		     (xfers[i].src_addr % (dmac->width_src / 8)))) {
+			printf("Addresses should be aligned with data path widths.\n");
+			return -1;
+		}
+
+		hw = &dmac->sg_descs[i];
+		hw->flags = 0;
+		hw->id = i;
+		hw->dest_addr = xfers[i].dest_addr;
+		hw->src_addr = xfers[i].src_addr;
+		hw->next_sg_addr = (uintptr_t)&dmac->sg_descs[i + 1];
+		hw->x_len = xfers[i].size - 1;
+		hw->y_len = rows - 1;
+		hw->src_stride = (rows > 1) ? xfers[i].src_stride : 0;
+		hw->dst_stride = (rows > 1) ? xfers[i].dest_stride : 0;
+
+		total_size += xfers[i].size * rows;
+	}
+
+	/* The last descriptor raises the interrupt and either ends the chain or,
+	 * for cyclic transfers, links back to the first one. */
+	hw = &dmac->sg_descs[nb_xfers - 1];
+	if (cyclic) {
+		hw->flags = AXI_DMAC_HW_FLAG_IRQ;
+		hw->next_sg_addr = (uintptr_t)dmac->sg_descs;
+	} else {
+		hw->flags = AXI_DMAC_HW_FLAG_LAST | AXI_DMAC_HW_FLAG_IRQ;
+		hw->next_sg_addr = 0;
+	}
+
+	if (dmac->dcache_flush_range)
+		dmac->dcache_flush_range((uintptr_t)dmac->sg_descs,
+					 nb_xfers * sizeof(*dmac->sg_descs));
+
+	dmac->transfer.size = total_size;
+	dmac->transfer.cyclic = xfers[0].cyclic;
+	dmac->transfer.src_addr = xfers[0].src_addr;
+	dmac->transfer.dest_addr = xfers[0].dest_addr;
+	dmac->transfer.y_length = 0;
+	dmac->transfer.transfer_done = false;
+	dmac->remaining_size = 0;
+	dmac->single_submit = true;
+
+	/* The scatter-gather mode is latched when the DMAC gets enabled. */
+	axi_dmac_read(dmac, AXI_DMAC_REG_CTRL, &reg_val);
+	if ((reg_val & (AXI_DMAC_CTRL_ENABLE | AXI_DMAC_CTRL_ENABLE_SG)) !=
+	    (AXI_DMAC_CTRL_ENABLE | AXI_DMAC_CTRL_ENABLE_SG)) {
+		axi_dmac_write(dmac, AXI_DMAC_REG_CTRL, 0x0);
+		axi_dmac_write(dmac, AXI_DMAC_REG_CTRL,
+			       AXI_DMAC_CTRL_ENABLE | AXI_DMAC_CTRL_ENABLE_SG);
+		axi_dmac_write(dmac, AXI_DMAC_REG_IRQ_MASK, 0x0);
+	}
+
+	axi_dmac_write(dmac, AXI_DMAC_REG_FLAGS, cyclic ? DMA_CYCLIC : DMA_LAST);
+	axi_dmac_write(dmac, AXI_DMAC_REG_SG_ADDRESS, (uintptr_t)dmac->sg_descs);
+	axi_dmac_write(dmac, AXI_DMAC_REG_SG_ADDRESS_HIGH, 0x0);
+	axi_dmac_write(dmac, AXI_DMAC_REG_TRANSFER_SUBMIT, AXI_DMAC_TRANSFER_SUBMIT);
+
+	return 0;
+}
+
+/*******************************************************************************
+ * @brief Queue a transfer in the DMAC's transfer queue, without waiting for
+ *			the previous ones to complete. Keeping several transfers queued
+ *			lets the DMAC move from one to the next without gaps.
+ *
+ * @note The transfer has to fit in a single burst (or, for 2D transfers, each
+ *		 row has to) and can't be cyclic. The queued transfers are tracked by
+ *		 their ID, with axi_dmac_transfer_wait_id().
+ *
+ * @param dmac - DMAC istance.
+ * @param dma_transfer - Structure containing transfer details.
+ * @param id - ID assigned by the DMAC to the transfer.
+ *
+ * @return 0 for success, -EBUSY if the transfer queue is full, negative error
+ *		   code otherwise.
+*******************************************************************************/
+int32_t axi_dmac_transfer_queue(struct axi_dmac *dmac,
+				struct axi_dma_transfer *dma_transfer,
+				uint32_t *id)
+{
+	uint32_t reg_val, rows;
+
+	if (!dmac || !dma_transfer || !id)
+		return -EINVAL;
+
+	rows = dma_transfer->y_length ? dma_transfer->y_length : 1;
+	if (!dma_transfer->size || ((dma_transfer->size - 1) > dmac->max_length) ||
+	    (dma_transfer->cyclic == CYCLIC) || ((rows > 1) && !dmac->hw_2d))
+		return -EINVAL;
+
+	if (((dmac->direction != DMA_MEM_TO_DEV) &&
+	     (dma_transfer->dest_addr % (dmac->width_dst / 8))) ||
+	    ((dmac->direction != DMA_DEV_TO_MEM) &&
+	     (dma_transfer->src_addr % (dmac->width_src / 8))))
+		return -EINVAL;
+
+	/* Enable DMA if not already enabled, leaving scatter-gather mode. */
+	axi_dmac_read(dmac, AXI_DMAC_REG_CTRL, &reg_val);
+	if ((reg_val & (AXI_DMAC_CTRL_ENABLE | AXI_DMAC_CTRL_ENABLE_SG)) !=
+	    AXI_DMAC_CTRL_ENABLE) {
+		axi_dmac_write(dmac, AXI_DMAC_REG_CTRL, 0x0);
+		axi_dmac_write(dmac, AXI_DMAC_REG_CTRL, AXI_DMAC_CTRL_ENABLE);
+		axi_dmac_write(dmac, AXI_DMAC_REG_IRQ_MASK, 0x0);
+	}
+
+	axi_dmac_read(dmac, AXI_DMAC_REG_TRANSFER_SUBMIT, &reg_val);
+	if (reg_val & AXI_DMAC_QUEUE_FULL)
+		return -EBUSY;
+
+	axi_dmac_read(dmac, AXI_DMAC_REG_FLAGS, &reg_val);
+	axi_dmac_write(dmac, AXI_DMAC_REG_FLAGS, reg_val & ~DMA_CYCLIC);
+
+	/* Nothing is left for the ISR to chain. */
+	dmac->remaining_size = 0;
+	dmac->single_submit = false;
+
+	axi_dmac_read(dmac, AXI_DMAC_REG_TRANSFER_ID, id);
+
+	if (dmac->direction != DMA_MEM_TO_DEV) {
+		axi_dmac_write(dmac, AXI_DMAC_REG_DEST_ADDRESS, dma_transfer->dest_addr);
+		axi_dmac_write(dmac, AXI_DMAC_REG_DEST_STRIDE,
+			       (rows > 1) ? dma_transfer->dest_stride : 0);
+	}
+	if (dmac->direction != DMA_DEV_TO_MEM) {
+		axi_dmac_write(dmac, AXI_DMAC_REG_SRC_ADDRESS, dma_transfer->src_addr);
+		axi_dmac_write(dmac, AXI_DMAC_REG_SRC_STRIDE,
+			       (rows > 1) ? dma_transfer->src_stride : 0);
+	}
+	axi_dmac_write(dmac, AXI_DMAC_REG_X_LENGTH, dma_transfer->size - 1);
+	axi_dmac_write(dmac, AXI_DMAC_REG_Y_LENGTH, rows - 1);
+	axi_dmac_write(dmac, AXI_DMAC_REG_TRANSFER_SUBMIT, AXI_DMAC_TRANSFER_SUBMIT);
+
+	return 0;
+}
+
+/*******************************************************************************
+ * @brief Wait for a transfer queued with axi_dmac_transfer_queue() to be
+ *			completed.
+ *
+ * @param dmac - DMAC istance.
+ * @param id - ID of the queued transfer.
+ * @param timeout_ms - Number of ms to wait for completion of transfer.
+ *
+ * @return 0 for success, -ETIMEDOUT in case transfer not completed in
+ *		   specified time.
+*******************************************************************************/
+int32_t axi_dmac_transfer_wait_id(struct axi_dmac *dmac, uint32_t id,
+				  uint32_t timeout_ms)
+{
+	uint32_t timeout = 0;
+	uint32_t reg_val;
+
+	axi_dmac_read(dmac, AXI_DMAC_REG_TRANSFER_DONE, &reg_val);
+	while (!(reg_val & NO_OS_BIT(id))) {
+		if (timeout++ == timeout_ms)
+			return -ETIMEDOUT;
+		no_os_mdelay(1);
+		axi_dmac_read(dmac, AXI_DMAC_REG_TRANSFER_DONE, &reg_val);
+	}
+
+	return 0;
+}
+
 /*******************************************************************************
  * @brief Wait for DMA transfer to be completed.
  *
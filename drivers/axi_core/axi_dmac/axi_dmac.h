@@ -52,6 +52,7 @@
 #define AXI_DMAC_CTRL_ENABLE		NO_OS_BIT(0)
 #define AXI_DMAC_CTRL_DISABLE		0u
 #define AXI_DMAC_CTRL_PAUSE			NO_OS_BIT(1)
+#define AXI_DMAC_CTRL_ENABLE_SG		NO_OS_BIT(2)
 
 #define AXI_DMAC_REG_TRANSFER_ID		0x404
 #define AXI_DMAC_REG_TRANSFER_SUBMIT	0x408
@@ -65,6 +66,14 @@
 #define AXI_DMAC_REG_DEST_STRIDE		0x420
 #define AXI_DMAC_REG_SRC_STRIDE			0x424
 #define AXI_DMAC_REG_TRANSFER_DONE		0x428
+#define AXI_DMAC_REG_SG_ADDRESS			0x47c
+#define AXI_DMAC_REG_SG_ADDRESS_HIGH	0x4bc
+
+/* Flags of a scatter-gather hardware descriptor */
+#define AXI_DMAC_HW_FLAG_LAST			NO_OS_BIT(0)
+#define AXI_DMAC_HW_FLAG_IRQ			NO_OS_BIT(1)
+/* The DMAC fetches descriptors in 64 byte bursts */
+#define AXI_DMAC_HW_DESC_ALIGN			64
 
 enum use_irq {
 	IRQ_DISABLED = 0,
@@ -91,11 +100,35 @@ enum cyclic_transfer {
 };
 
 struct axi_dma_transfer {
+	/** Transfer size in bytes. For 2D transfers, the size of a row. */
 	uint32_t size;
 	volatile bool transfer_done;
 	enum cyclic_transfer cyclic;
 	uint32_t src_addr;
 	uint32_t dest_addr;
+	/** Number of rows of a 2D transfer. 0 or 1 for 1D transfers. */
+	uint32_t y_length;
+	/** Distance in bytes between the starts of two source rows (2D only) */
+	uint32_t src_stride;
+	/** Distance in bytes between the starts of two destination rows (2D only) */
+	uint32_t dest_stride;
+};
+
+/**
+ * @struct axi_dmac_hw_desc
+ * @brief Scatter-gather descriptor, as fetched by the DMAC from memory.
+ */
+struct axi_dmac_hw_desc {
+	uint32_t flags;
+	uint32_t id;
+	uint64_t dest_addr;
+	uint64_t src_addr;
+	uint64_t next_sg_addr;
+	uint32_t y_len;
+	uint32_t x_len;
+	uint32_t src_stride;
+	uint32_t dst_stride;
+	uint64_t __pad[2];
 };
 
 struct axi_dmac {
@@ -104,6 +137,8 @@ struct axi_dmac {
 	enum use_irq irq_option;
 	enum dma_direction direction;
 	bool hw_cyclic;
+	bool hw_2d;
+	bool hw_sg;
 	uint32_t max_length;
 	uint32_t width_dst;
 	uint32_t width_src;
@@ -113,12 +148,22 @@ struct axi_dmac {
 	uint32_t remaining_size;
 	uint32_t next_src_addr;
 	uint32_t next_dest_addr;
+	/* The whole transfer was submitted at once (2D or scatter-gather) */
+	volatile bool single_submit;
+	/* Scatter-gather descriptor chain */
+	void *sg_mem;
+	struct axi_dmac_hw_desc *sg_descs;
+	uint32_t sg_len;
+	void (*dcache_flush_range)(uint32_t address, uint32_t bytes_count);
 };
 
 struct axi_dmac_init {
 	const char *name;
 	uint32_t base;
 	enum use_irq irq_option;
+	/** Flush the data cache for the given range. Used on the scatter-gather
+	 *  descriptors before they are handed to the DMAC. May be NULL. */
+	void (*dcache_flush_range)(uint32_t address, uint32_t bytes_count);
 };
 
 void axi_dmac_dev_to_mem_isr(void *instance);
@@ -135,6 +180,14 @@ int32_t axi_dmac_init(struct axi_dmac **adc_core,
 int32_t axi_dmac_remove(struct axi_dmac *dmac);
 int32_t axi_dmac_transfer_start(struct axi_dmac *dmac,
 				struct axi_dma_transfer *dma_transfer);
+int32_t axi_dmac_transfer_sg_start(struct axi_dmac *dmac,
+				   struct axi_dma_transfer *xfers,
+				   uint32_t nb_xfers);
+int32_t axi_dmac_transfer_queue(struct axi_dmac *dmac,
+				struct axi_dma_transfer *dma_transfer,
+				uint32_t *id);
+int32_t axi_dmac_transfer_wait_id(struct axi_dmac *dmac, uint32_t id,
+				  uint32_t timeout_ms);
 int32_t axi_dmac_transfer_wait_completion(struct axi_dmac *dmac,
 		uint32_t timeout_ms);
 void axi_dmac_transfer_stop(struct axi_dmac *dmac);
@@ -0,0 +1,319 @@
+/***************************************************************************//**
+ *   @file   axi_dmac_dma.c
+ *   @brief  AXI-DMAC implementation of the DMA API.
+ *   @author Analog Devices Inc.
+********************************************************************************
+ *   @copyright
+ * Copyright 2024(c) Analog Devices, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Analog Devices, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ANALOG DEVICES, INC. “AS IS” AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL ANALOG DEVICES, INC. BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "no_os_alloc.h"
+#include "no_os_error.h"
+#include "no_os_list.h"
+#include "axi_dmac_dma.h"
+
+/**
+ * @brief Initialize an AXI-DMAC as a single channel DMA controller.
+ * @param desc - Descriptor to be initialized.
+ * @param param - Initialization parameter for the decriptor. The extra field
+ * 		  is a struct axi_dmac_init.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+static int axi_dmac_dma_init(struct no_os_dma_desc **desc,
+			     struct no_os_dma_init_param *param)
+{
+	struct no_os_dma_desc *descriptor;
+	struct axi_dmac *dmac;
+	int ret;
+
+	if (!param->extra || param->num_ch != 1)
+		return -EINVAL;
+
+	descriptor = no_os_calloc(1, sizeof(*descriptor));
+	if (!descriptor)
+		return -ENOMEM;
+
+	descriptor->channels = no_os_calloc(1, sizeof(*descriptor->channels));
+	if (!descriptor->channels) {
+		ret = -ENOMEM;
+		goto free_descriptor;
+	}
+
+	ret = axi_dmac_init(&dmac, param->extra);
+	if (ret) {
+		ret = -ENODEV;
+		goto free_channels;
+	}
+
+	descriptor->id = param->id;
+	descriptor->num_ch = 1;
+	descriptor->extra = dmac;
+	descriptor->channels[0].id = 0;
+	descriptor->channels[0].free = true;
+	descriptor->channels[0].extra = dmac;
+
+	*desc = descriptor;
+
+	return 0;
+
+free_channels:
+	no_os_free(descriptor->channels);
+free_descriptor:
+	no_os_free(descriptor);
+
+	return ret;
+}
+
+/**
+ * @brief Free the resources allocated for a DMA descriptor.
+ * @param desc - Descriptor to be freed.
+ * @return 0
+ */
+static int axi_dmac_dma_remove(struct no_os_dma_desc *desc)
+{
+	axi_dmac_transfer_stop(desc->extra);
+	axi_dmac_remove(desc->extra);
+	no_os_free(desc->channels);
+	no_os_free(desc);
+
+	return 0;
+}
+
+/**
+ * @brief Acquire the DMAC channel.
+ * @param desc - Descriptor for the DMA controller.
+ * @param ch - The index of the acquired channel.
+ * @return 0 if the channel was acquired
+ * 	   -EBUSY if the channel is in use or locked
+ */
+static int axi_dmac_dma_acquire_ch(struct no_os_dma_desc *desc, uint32_t *ch)
+{
+	if (!desc->channels[0].free || desc->channels[0].sync_lock)
+		return -EBUSY;
+
+	desc->channels[0].free = false;
+	*ch = 0;
+
+	return 0;
+}
+
+/**
+ * @brief Release the DMAC channel, stopping any ongoing transfer.
+ * @param desc - Descriptor for the DMA controller.
+ * @param ch - The index of the channel.
+ * @return 0
+ */
+static int axi_dmac_dma_release_ch(struct no_os_dma_desc *desc, uint32_t ch)
+{
+	axi_dmac_transfer_stop(desc->channels[ch].extra);
+	desc->channels[ch].free = true;
+
+	return 0;
+}
+
+/**
+ * @brief Check that a transfer matches the direction the DMAC was built for.
+ * @param dmac - DMAC instance.
+ * @param xfer - Descriptor for the transfer.
+ * @return 0 in case of success, -EINVAL otherwise.
+ */
+static int axi_dmac_dma_check_xfer(struct axi_dmac *dmac,
+				   struct no_os_dma_xfer_desc *xfer)
+{
+	switch (xfer->xfer_type) {
+	case MEM_TO_MEM:
+		return (dmac->direction == DMA_MEM_TO_MEM) ? 0 : -EINVAL;
+	case MEM_TO_DEV:
+		return (dmac->direction == DMA_MEM_TO_DEV) ? 0 : -EINVAL;
+	case DEV_TO_MEM:
+		return (dmac->direction == DMA_DEV_TO_MEM) ? 0 : -EINVAL;
+	default:
+		return -EINVAL;
+	}
+}
+
+/**
+ * @brief Validate the first transfer of a channel. The DMAC registers are only
+ * programmed once the whole list of transfers is known, in
+ * axi_dmac_dma_xfer_start().
+ * @param channel - The DMA channel descriptor.
+ * @param xfer - Descriptor for the transfer.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+static int axi_dmac_dma_config_xfer(struct no_os_dma_ch *channel,
+				    struct no_os_dma_xfer_desc *xfer)
+{
+	return axi_dmac_dma_check_xfer(channel->extra, xfer);
+}
+
+/**
+ * @brief Start the transfers in the channel's list. Several transfers are
+ * chained and submitted at once, which requires a DMAC built with
+ * scatter-gather support.
+ * @param desc - Descriptor for the DMA controller.
+ * @param ch - The DMA channel.
+ * @return 0 in case of success
+ * 	   -ENOTSUP if several transfers are queued on a DMAC without
+ * 	   scatter-gather support
+ * 	   -EIO if the DMAC rejected the transfer
+ * 	   negative error code otherwise
+ */
+static int axi_dmac_dma_xfer_start(struct no_os_dma_desc *desc,
+				   struct no_os_dma_ch *ch)
+{
+	struct axi_dmac *dmac = ch->extra;
+	struct axi_dmac_dma_xfer_2d *xfer_2d;
+	struct no_os_dma_xfer_desc *xfer;
+	struct axi_dma_transfer *xfers;
+	uint32_t nb_xfers, i;
+	int ret;
+
+	no_os_list_get_size(ch->sg_list, &nb_xfers);
+	if (!nb_xfers)
+		return -EINVAL;
+
+	if (nb_xfers > 1 && !dmac->hw_sg)
+		return -ENOTSUP;
+
+	xfers = no_os_calloc(nb_xfers, sizeof(*xfers));
+	if (!xfers)
+		return -ENOMEM;
+
+	for (i = 0; i < nb_xfers; i++) {
+		ret = no_os_list_read_idx(ch->sg_list, (void **)&xfer, i);
+		if (ret)
+			goto free_xfers;
+
+		ret = axi_dmac_dma_check_xfer(dmac, xfer);
+		if (ret)
+			goto free_xfers;
+
+		xfers[i].src_addr = (uintptr_t)xfer->src;
+		xfers[i].dest_addr = (uintptr_t)xfer->dst;
+		xfers[i].size = xfer->length;
+		xfers[i].cyclic = NO;
+
+		xfer_2d = xfer->extra;
+		if (xfer_2d) {
+			xfers[i].y_length = xfer_2d->y_length;
+			xfers[i].src_stride = xfer_2d->src_stride;
+			xfers[i].dest_stride = xfer_2d->dest_stride;
+		}
+	}
+
+	if (nb_xfers == 1)
+		ret = axi_dmac_transfer_start(dmac, xfers);
+	else
+		ret = axi_dmac_transfer_sg_start(dmac, xfers, nb_xfers);
+	if (ret)
+		ret = -EIO;
+
+free_xfers:
+	no_os_free(xfers);
+
+	return ret;
+}
+
+/**
+ * @brief Stop the DMAC.
+ * @param desc - Descriptor for the DMA controller.
+ * @param ch - The DMA channel.
+ * @return 0
+ */
+static int axi_dmac_dma_xfer_abort(struct no_os_dma_desc *desc,
+				   struct no_os_dma_ch *ch)
+{
+	struct axi_dmac *dmac = ch->extra;
+
+	axi_dmac_transfer_stop(dmac);
+	dmac->single_submit = false;
+	ch->free = true;
+
+	return 0;
+}
+
+/**
+ * @brief Whether or not the channel has an ongoing DMA transfer. Once the
+ * transfers complete, they are removed from the channel's list, their
+ * callbacks are invoked and the channel is marked as free.
+ * @param desc - DMA controller descriptor.
+ * @param ch - The channel for which we want to do the checking.
+ * @return true if the channel is busy, false otherwise.
+ */
+static bool axi_dmac_dma_in_progress(struct no_os_dma_desc *desc,
+				     struct no_os_dma_ch *ch)
+{
+	struct no_os_dma_xfer_desc *next_xfer;
+	struct no_os_dma_xfer_desc *xfer;
+	struct axi_dmac *dmac = ch->extra;
+	uint32_t reg_val;
+	bool done;
+
+	if (ch->free)
+		return false;
+
+	if (dmac->irq_option == IRQ_ENABLED) {
+		done = dmac->transfer.transfer_done;
+	} else {
+		axi_dmac_read(dmac, AXI_DMAC_REG_IRQ_PENDING, &reg_val);
+		done = reg_val & AXI_DMAC_IRQ_EOT;
+		if (done)
+			axi_dmac_write(dmac, AXI_DMAC_REG_IRQ_PENDING, reg_val);
+	}
+
+	if (!done)
+		return true;
+
+	while (!no_os_list_get_first(ch->sg_list, (void **)&xfer)) {
+		next_xfer = NULL;
+		no_os_list_read_first(ch->sg_list, (void **)&next_xfer);
+		if (xfer->xfer_complete_cb)
+			xfer->xfer_complete_cb(xfer, next_xfer,
+					       xfer->xfer_complete_ctx);
+	}
+	ch->free = true;
+
+	return false;
+}
+
+/**
+ * @brief AXI-DMAC specific callbacks for the DMA API
+ */
+struct no_os_dma_platform_ops axi_dmac_dma_ops = {
+	.dma_init = axi_dmac_dma_init,
+	.dma_remove = axi_dmac_dma_remove,
+	.dma_acquire_ch = axi_dmac_dma_acquire_ch,
+	.dma_release_ch = axi_dmac_dma_release_ch,
+	.dma_config_xfer = axi_dmac_dma_config_xfer,
+	.dma_xfer_start = axi_dmac_dma_xfer_start,
+	.dma_xfer_abort = axi_dmac_dma_xfer_abort,
+	.dma_ch_in_progress = axi_dmac_dma_in_progress,
+};
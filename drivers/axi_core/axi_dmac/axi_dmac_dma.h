@@ -0,0 +1,65 @@
+/***************************************************************************//**
+ *   @file   axi_dmac_dma.h
+ *   @brief  Header file of the AXI-DMAC implementation of the DMA API.
+ *   @author Analog Devices Inc.
+********************************************************************************
+ *   @copyright
+ * Copyright 2024(c) Analog Devices, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Analog Devices, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ANALOG DEVICES, INC. “AS IS” AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL ANALOG DEVICES, INC. BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef AXI_DMAC_DMA_H_
+#define AXI_DMAC_DMA_H_
+
+#include <stdint.h>
+#include "no_os_dma.h"
+#include "axi_dmac.h"
+
+/**
+ * @struct axi_dmac_dma_xfer_2d
+ * @brief 2D layout of a transfer. Passed through the extra field of
+ * struct no_os_dma_xfer_desc, in which case the length of the transfer is
+ * the size of a row.
+ */
+struct axi_dmac_dma_xfer_2d {
+	/** Number of rows */
+	uint32_t y_length;
+	/** Distance in bytes between the starts of two source rows */
+	uint32_t src_stride;
+	/** Distance in bytes between the starts of two destination rows */
+	uint32_t dest_stride;
+};
+
+/**
+ * @brief AXI-DMAC specific callbacks for the DMA API. The extra field of the
+ * init parameter has to point to a struct axi_dmac_init. Each DMAC has a
+ * single channel, and the struct axi_dmac instance is stored in the extra
+ * field of the DMA descriptor, so that its ISR may be registered.
+ */
+extern struct no_os_dma_platform_ops axi_dmac_dma_ops;
+
+#endif
@@ -371,6 +371,186 @@ int32_t	iio_axi_adc_read_dev(void *dev, void *buff, uint32_t nb_samples)
 	return 0;
 }
 
+/**
+ * @brief Queue the next block of the continuous capture in the DMAC.
+ * @param iio_adc - Instance of the iio_axi_adc
+ * @param buffer - IIO buffer the blocks are part of.
+ * @return 0 in case of success or negative value otherwise.
+ */
+static int iio_axi_adc_queue_block(struct iio_axi_adc_desc *iio_adc,
+				   struct iio_buffer *buffer)
+{
+	struct no_os_circular_buffer *cb = buffer->buf;
+	struct axi_dma_transfer transfer = {
+		.size = buffer->size,
+		.cyclic = NO,
+		.dest_addr = (uintptr_t)iio_adc->capture_next
+	};
+	uint32_t idx;
+	int ret;
+
+	idx = (iio_adc->capture_first + iio_adc->capture_queued) %
+	      IIO_AXI_ADC_MAX_QUEUED_BLOCKS;
+	ret = axi_dmac_transfer_queue(iio_adc->dmac, &transfer,
+				      &iio_adc->capture_ids[idx]);
+	if (ret)
+		return ret;
+
+	iio_adc->capture_queued++;
+	iio_adc->capture_next += buffer->size;
+	if (iio_adc->capture_next >= cb->buff + cb->size)
+		iio_adc->capture_next = cb->buff;
+
+	return 0;
+}
+
+/**
+ * @brief Stop the continuous capture, dropping the queued blocks and
+ * cancelling the reservation of the oldest one, so that the IIO buffer can be
+ * written again.
+ * @param iio_adc - Instance of the iio_axi_adc
+ */
+static void iio_axi_adc_capture_stop(struct iio_axi_adc_desc *iio_adc)
+{
+	if (!iio_adc->capture_running)
+		return;
+
+	axi_dmac_transfer_stop(iio_adc->dmac);
+	if (iio_adc->capture_block) {
+		no_os_cb_end_async_write_partial(iio_adc->capture_buffer->buf, 0);
+		iio_adc->capture_block = NULL;
+	}
+	iio_adc->capture_running = false;
+	iio_adc->capture_queued = 0;
+}
+
+/**
+ * @brief Start the continuous capture, queueing consecutive blocks of the IIO
+ * buffer in the DMAC. One block of the buffer is always left out, being the
+ * one handed to the client.
+ * @param iio_adc - Instance of the iio_axi_adc
+ * @param buffer - IIO buffer to capture into.
+ * @return 0 in case of success, -EINVAL if the buffer is too small to keep
+ * two blocks queued, negative value otherwise.
+ */
+static int iio_axi_adc_capture_start(struct iio_axi_adc_desc *iio_adc,
+				     struct iio_buffer *buffer)
+{
+	uint32_t nb_blocks;
+	int ret;
+
+	nb_blocks = buffer->buf->size / buffer->size - 1;
+	nb_blocks = no_os_min(nb_blocks, iio_adc->continuous_blocks);
+	nb_blocks = no_os_min(nb_blocks, IIO_AXI_ADC_MAX_QUEUED_BLOCKS);
+	if (nb_blocks < 2)
+		return -EINVAL;
+
+	/* The oldest block stays reserved until the DMAC fills it. */
+	ret = iio_buffer_get_block(buffer, &iio_adc->capture_block);
+	if (ret)
+		return ret;
+
+	iio_adc->capture_buffer = buffer;
+	iio_adc->capture_running = true;
+	iio_adc->capture_first = 0;
+	iio_adc->capture_queued = 0;
+	iio_adc->capture_next = iio_adc->capture_block;
+
+	while (iio_adc->capture_queued < nb_blocks) {
+		ret = iio_axi_adc_queue_block(iio_adc, buffer);
+		if (ret == -EBUSY && iio_adc->capture_queued >= 2)
+			break; /* The DMAC queue is shorter, which is fine. */
+		if (ret) {
+			iio_axi_adc_capture_stop(iio_adc);
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Submit callback. In continuous capture mode the DMAC always has
+ * blocks queued, so each refill only waits for the oldest one to complete,
+ * hands it to the IIO buffer and queues a new one in its place.
+ * @param dev_data - IIO device data, holding the iio_axi_adc and its buffer.
+ * @return 0 in case of success or negative value otherwise.
+ */
+static int32_t iio_axi_adc_submit(struct iio_device_data *dev_data)
+{
+	struct iio_axi_adc_desc *iio_adc = dev_data->dev;
+	struct iio_buffer *buffer = dev_data->buffer;
+	void *block;
+	int ret;
+
+	if (!iio_adc->capture_running) {
+		ret = iio_axi_adc_capture_start(iio_adc, buffer);
+		if (ret == -EINVAL) {
+			/* Not enough room for queueing, capture one block. */
+			ret = iio_buffer_get_block(buffer, &block);
+			if (ret)
+				return ret;
+
+			ret = iio_axi_adc_read_dev(iio_adc, block, buffer->samples);
+			if (ret) {
+				no_os_cb_end_async_write_partial(buffer->buf, 0);
+				return ret;
+			}
+
+			return iio_buffer_block_done(buffer);
+		}
+		if (ret)
+			return ret;
+	}
+
+	ret = axi_dmac_transfer_wait_id(iio_adc->dmac,
+					iio_adc->capture_ids[iio_adc->capture_first],
+					500);
+	if (ret)
+		goto stop;
+
+	if (iio_adc->dcache_invalidate_range)
+		iio_adc->dcache_invalidate_range((uintptr_t)iio_adc->capture_block,
+						 buffer->size);
+
+	ret = iio_buffer_block_done(buffer);
+	if (ret)
+		goto stop;
+
+	iio_adc->capture_block = NULL;
+	iio_adc->capture_first = (iio_adc->capture_first + 1) %
+				 IIO_AXI_ADC_MAX_QUEUED_BLOCKS;
+	iio_adc->capture_queued--;
+
+	ret = iio_axi_adc_queue_block(iio_adc, buffer);
+	if (ret)
+		goto stop;
+
+	ret = iio_buffer_get_block(buffer, &block);
+	if (ret)
+		goto stop;
+
+	iio_adc->capture_block = block;
+
+	return 0;
+stop:
+	iio_axi_adc_capture_stop(iio_adc);
+
+	return ret;
+}
+
+/**
+ * @brief Stop the continuous capture once the buffer gets disabled.
+ * @param dev - Instance of the iio_axi_adc
+ * @return 0
+ */
+static int32_t iio_axi_adc_post_disable(void *dev)
+{
+	iio_axi_adc_capture_stop(dev);
+
+	return 0;
+}
+
 /**
  * @brief Delete iio_device.
  * @param iio_device - Structure describing a device, channels and attributes.
@@ -438,6 +618,10 @@ static int32_t iio_axi_adc_create_device_descriptor(
 
 	iio_device->pre_enable = iio_axi_adc_prepare_transfer;
 	iio_device->read_dev = iio_axi_adc_read_dev;
+	if (desc->dmac && desc->continuous_blocks) {
+		iio_device->submit = iio_axi_adc_submit;
+		iio_device->post_disable = iio_axi_adc_post_disable;
+	}
 
 	return 0;
 error:
@@ -493,6 +677,7 @@ int32_t iio_axi_adc_init(struct iio_axi_adc_desc **desc,
 	if (init->rx_dmac) {
 		iio_axi_adc_inst->dmac = init->rx_dmac;
 		iio_axi_adc_inst->dcache_invalidate_range = init->dcache_invalidate_range;
+		iio_axi_adc_inst->continuous_blocks = init->continuous_blocks;
 	}
 	iio_axi_adc_inst->get_sampling_frequency = init->get_sampling_frequency;
 
@@ -38,6 +38,9 @@
 #include "axi_adc_core.h"
 #include "axi_dmac.h"
 
+/** Maximum number of DMA blocks queued in continuous capture mode */
+#define IIO_AXI_ADC_MAX_QUEUED_BLOCKS	8
+
 /**
  * @struct iio_axi_adc_desc
  * @brief iio_axi_adc_descriptor
@@ -60,6 +63,22 @@ struct iio_axi_adc_desc {
 	char (*ch_names)[20];
 	/** Custom data format */
 	struct scan_type *scan_type_common;
+	/** Number of DMA blocks kept queued in continuous capture mode */
+	uint32_t continuous_blocks;
+	/** Whether the continuous capture is running */
+	bool capture_running;
+	/** Number of blocks queued in the DMAC */
+	uint32_t capture_queued;
+	/** Ring of the DMAC transfer IDs of the queued blocks */
+	uint32_t capture_ids[IIO_AXI_ADC_MAX_QUEUED_BLOCKS];
+	/** Index of the oldest queued block in capture_ids */
+	uint32_t capture_first;
+	/** Buffer being captured into */
+	struct iio_buffer *capture_buffer;
+	/** Oldest queued block, reserved in the IIO buffer until completed */
+	void *capture_block;
+	/** Address where the next block will be queued */
+	int8_t *capture_next;
 };
 
 /**
@@ -79,6 +98,11 @@ struct iio_axi_adc_init_param {
 	/** Custom data format (unpopulated if not used, set to default)
 	    Common to all channels */
 	struct scan_type *scan_type_common;
+	/** Number of DMA blocks kept queued for a gapless continuous capture.
+	    The IIO buffer has to hold at least one more block than the number
+	    of queued ones. 0 (or less than 2 usable blocks) keeps one-shot
+	    captures, where samples are lost between two refills. */
+	uint32_t continuous_blocks;
 };
 
 /* Init iio. */
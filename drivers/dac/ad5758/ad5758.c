@@ -32,6 +32,7 @@
 *******************************************************************************/
 
 #include "ad5758.h"
+#include "no_os_crc8.h"
 #include "no_os_delay.h"
 #include "no_os_error.h"
 #include "no_os_gpio.h"
@@ -52,23 +53,7 @@
 static uint8_t ad5758_compute_crc8(uint8_t *data,
 				   uint8_t data_size)
 {
-	uint8_t i;
-	uint8_t crc = 0;
-
-	while (data_size) {
-		for (i = 0x80; i != 0; i >>= 1) {
-			if (((crc & 0x80) != 0) != ((*data & i) != 0)) {
-				crc <<= 1;
-				crc ^= AD5758_CRC8_POLY;
-			} else {
-				crc <<= 1;
-			}
-		}
-		data++;
-		data_size--;
-	}
-
-	return crc;
+	return no_os_crc8_poly07(data, data_size, 0);
 }
 
 /**
@@ -38,28 +38,38 @@
 #include "no_os_units.h"
 #include "no_os_alloc.h"
 
+/* Configuration registers kept in the register map cache. RUN, CONFIG1
+ * (software reset) and TEMP_CFG (self clearing TEMP_START) are volatile, as
+ * are all the measurement and status registers outside these ranges. */
+static const struct no_os_regmap_range ade9000_regmap_ranges[] = {
+	{ ADE9000_REG_CONFIG0, ADE9000_REG_CONFIG0, NO_OS_REGMAP_CACHEABLE },
+	{ ADE9000_REG_DICOEFF, ADE9000_REG_DICOEFF, NO_OS_REGMAP_CACHEABLE },
+	{ ADE9000_REG_MASK0, ADE9000_REG_EVENT_MASK, NO_OS_REGMAP_CACHEABLE },
+	{ ADE9000_REG_VLEVEL, ADE9000_REG_VLEVEL, NO_OS_REGMAP_CACHEABLE },
+	{ ADE9000_REG_ACCMODE, ADE9000_REG_CONFIG3, NO_OS_REGMAP_CACHEABLE },
+	{ ADE9000_REG_ZX_LP_SEL, ADE9000_REG_ZX_LP_SEL, NO_OS_REGMAP_CACHEABLE },
+	{ ADE9000_REG_WFB_CFG, ADE9000_REG_WFB_CFG, NO_OS_REGMAP_CACHEABLE },
+	{ ADE9000_REG_CONFIG2, ADE9000_REG_EP_CFG, NO_OS_REGMAP_CACHEABLE },
+	{ ADE9000_REG_EGY_TIME, ADE9000_REG_EGY_TIME, NO_OS_REGMAP_CACHEABLE },
+	{ ADE9000_REG_PGA_GAIN, ADE9000_REG_PGA_GAIN, NO_OS_REGMAP_CACHEABLE },
+};
+
 /**
- * @brief Read device register.
- * @param dev - The device structure.
+ * @brief Read device register over SPI, used by the register map.
+ * @param ctx - The device structure.
  * @param reg_addr - The register address.
  * @param reg_data - The data read from the register.
  * @return 0 in case of success, negative error code otherwise.
  */
-int ade9000_read(struct ade9000_dev *dev, uint16_t reg_addr, uint32_t *reg_data)
+static int ade9000_spi_read(void *ctx, uint32_t reg_addr, uint32_t *reg_data)
 {
+	struct ade9000_dev *dev = ctx;
 	int ret;
-	/* index */
-	int i;
 	/* data buffer large enough for 32 bits reg */
 	uint8_t buff[6] = { 0 };
 	/* register addres */
 	uint32_t addr;
 
-	if (!dev)
-		return -ENODEV;
-	if (!reg_data)
-		return -EINVAL;
-
 	addr = (uint16_t) no_os_field_prep(NO_OS_GENMASK(16, 4), reg_addr);
 	no_os_put_unaligned_be16(addr, &buff);
 	buff[1] = buff[1] | ADE9000_SPI_READ;
@@ -84,20 +94,18 @@ int ade9000_read(struct ade9000_dev *dev, uint16_t reg_addr, uint32_t *reg_data)
 }
 
 /**
- * @brief Write device register.
- * @param dev- The device structure.
+ * @brief Write device register over SPI, used by the register map.
+ * @param ctx - The device structure.
  * @param reg_addr - The register address.
  * @param reg_data - The data to be written.
  * @return 0 in case of success, negative error code otherwise.
  */
-int ade9000_write(struct ade9000_dev *dev, uint16_t reg_addr, uint32_t reg_data)
+static int ade9000_spi_write(void *ctx, uint32_t reg_addr, uint32_t reg_data)
 {
+	struct ade9000_dev *dev = ctx;
 	/* data buffer */
 	uint8_t buff[6] = { 0 };
 
-	if (!dev)
-		return -ENODEV;
-
 	buff[0] = reg_addr >> 4;
 	buff[1] = reg_addr << 4;
 
@@ -112,6 +120,40 @@ int ade9000_write(struct ade9000_dev *dev, uint16_t reg_addr, uint32_t reg_data)
 	return no_os_spi_write_and_read(dev->spi_desc, buff, 6);
 }
 
+/**
+ * @brief Read device register. Configuration registers are served from the
+ * register map cache once known.
+ * @param dev - The device structure.
+ * @param reg_addr - The register address.
+ * @param reg_data - The data read from the register.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int ade9000_read(struct ade9000_dev *dev, uint16_t reg_addr, uint32_t *reg_data)
+{
+	if (!dev)
+		return -ENODEV;
+	if (!reg_data)
+		return -EINVAL;
+
+	return no_os_regmap_read(dev->regmap, reg_addr, reg_data);
+}
+
+/**
+ * @brief Write device register. Writing a configuration register with the
+ * value it already holds doesn't access the bus.
+ * @param dev- The device structure.
+ * @param reg_addr - The register address.
+ * @param reg_data - The data to be written.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int ade9000_write(struct ade9000_dev *dev, uint16_t reg_addr, uint32_t reg_data)
+{
+	if (!dev)
+		return -ENODEV;
+
+	return no_os_regmap_write(dev->regmap, reg_addr, reg_data);
+}
+
 /**
  * @brief Update specific register bits.
  * @param dev - The device structure.
@@ -123,21 +165,10 @@ int ade9000_write(struct ade9000_dev *dev, uint16_t reg_addr, uint32_t reg_data)
 int ade9000_update_bits(struct ade9000_dev *dev, uint16_t reg_addr,
 			uint32_t mask, uint32_t reg_data)
 {
-	int ret;
-	/* register value read */
-	uint32_t data;
-
 	if (!dev)
 		return -ENODEV;
 
-	ret = ade9000_read(dev, reg_addr, &data);
-	if (ret)
-		return ret;
-
-	data &= ~mask;
-	data |= reg_data & mask;
-
-	return ade9000_write(dev, reg_addr, data);
+	return no_os_regmap_update_bits(dev->regmap, reg_addr, mask, reg_data);
 }
 
 /**
@@ -381,6 +412,12 @@ int ade9000_init(struct ade9000_dev **device,
 	struct ade9000_dev *dev;
 	/* chip id read value */
 	uint32_t chip_id;
+	struct no_os_regmap_init_param regmap_param = {
+		.reg_read = ade9000_spi_read,
+		.reg_write = ade9000_spi_write,
+		.ranges = ade9000_regmap_ranges,
+		.nb_ranges = NO_OS_ARRAY_SIZE(ade9000_regmap_ranges),
+	};
 
 	dev = (struct ade9000_dev *)no_os_calloc(1, sizeof(*dev));
 	if (!dev)
@@ -391,33 +428,43 @@ int ade9000_init(struct ade9000_dev **device,
 	if (ret)
 		goto error_dev;
 
+	regmap_param.ctx = dev;
+	ret = no_os_regmap_init(&dev->regmap, &regmap_param);
+	if (ret)
+		goto error_spi;
+
 	ret = ade9000_update_bits(dev, ADE9000_REG_CONFIG1, ADE9000_SWRST,
 				  no_os_field_prep(ADE9000_SWRST, 1));
 	if (ret)
-		goto error_spi;
+		goto error_regmap;
 
 	// wait for device to initialize after software reset
 	// > 46 ms see datasheet.
 	no_os_mdelay(50);
 
+	/* The reset restored the register defaults */
+	no_os_regmap_cache_drop(dev->regmap);
+
 	/* Use a valid register with default value different from 0*/
 	ret = ade9000_read(dev, ADE9000_REG_CONFIG5, &chip_id);
 	if (ret)
-		goto error_spi;
+		goto error_regmap;
 
 	if (chip_id != ADE9000_CHIP_ID)
-		goto error_spi;
+		goto error_regmap;
 
 	/* Enable Temperature Sensor */
 	ret = ade9000_update_bits(dev, ADE9000_REG_TEMP_CFG, ADE9000_TEMP_EN,
 				  no_os_field_prep(ADE9000_TEMP_EN, init_param.temp_en));
 	if (ret)
-		goto error_spi;
+		goto error_regmap;
 
 	*device = dev;
 
 	return 0;
 
+error_regmap:
+	no_os_regmap_remove(dev->regmap);
 error_spi:
 	no_os_spi_remove(dev->spi_desc);
 error_dev:
@@ -504,6 +551,7 @@ int ade9000_remove(struct ade9000_dev *dev)
 	if (ret)
 		return ret;
 
+	no_os_regmap_remove(dev->regmap);
 	no_os_free(dev);
 
 	return 0;
@@ -37,6 +37,7 @@
 #include <stdint.h>
 #include <string.h>
 #include "no_os_util.h"
+#include "no_os_regmap.h"
 #include "no_os_spi.h"
 
 /* SPI commands */
@@ -1374,6 +1375,8 @@ struct ade9000_init_param {
 struct ade9000_dev {
 	/** Device communication descriptor */
 	struct no_os_spi_desc		*spi_desc;
+	/** Register map caching the configuration registers */
+	struct no_os_regmap		*regmap;
 	/** Variable storing the WATT value */
 	uint32_t			watt_val;
 	/** Variable storing the IRMS value */
@@ -39,35 +39,74 @@
 #include "no_os_delay.h"
 
 /***************************************************************************//**
- * @brief Write data to a W5500 register
+ * @brief Move data to or from the W5500 in a single SPI burst
+ *
+ * The 3 bytes header and the data phase are sent as two messages of the same
+ * transaction, so the data is not copied. Long data phases go through DMA if
+ * it was requested and the platform supports it.
  *
  * @param dev   - The device descriptor
  * @param block - The block select bits (common registers, socket registers, etc.)
  * @param addr  - The register address
- * @param data  - The data buffer to write
+ * @param rwb   - W5500_RWB_READ or W5500_RWB_WRITE
+ * @param data  - The data buffer
  * @param len   - The data length
  *
  * @return 0 in case of success, negative error code otherwise
 *******************************************************************************/
-int w5500_reg_write(struct w5500_dev *dev, uint8_t block,
-		    uint16_t addr, const uint8_t *data, uint16_t len)
+static int w5500_burst(struct w5500_dev *dev, uint8_t block, uint16_t addr,
+		       uint8_t rwb, uint8_t *data, uint16_t len)
 {
-	uint8_t spi_tx[3 + len];
+	uint8_t header[3];
+	int ret;
 
-	spi_tx[0] = W5500_BYTE_HIGH(addr);
-	spi_tx[1] = W5500_BYTE_LOW(addr);
-	spi_tx[2] = W5500_BSB(block) | W5500_RWB_WRITE | W5500_OM_VDM;
+	header[0] = W5500_BYTE_HIGH(addr);
+	header[1] = W5500_BYTE_LOW(addr);
+	header[2] = W5500_BSB(block) | rwb | W5500_OM_VDM;
+
+	struct no_os_spi_msg xfer[2] = {
+		{
+			.tx_buff = header,
+			.rx_buff = NULL,
+			.bytes_number = 3,
+		},
+		{
+			/* The W5500 ignores MOSI during the data phase of a read */
+			.tx_buff = data,
+			.rx_buff = rwb == W5500_RWB_READ ? data : NULL,
+			.bytes_number = len,
+			.cs_change = 1,
+		},
+	};
 
-	memcpy(&spi_tx[3], data, len);
+	if (dev->spi_dma && len >= W5500_DMA_MIN_LEN) {
+		ret = no_os_spi_transfer_dma(dev->spi, xfer, 2);
+		if (ret != -ENOSYS)
+			return ret;
 
-	struct no_os_spi_msg xfer = {
-		.tx_buff = spi_tx,
-		.rx_buff = NULL,
-		.bytes_number = 3 + len,
-		.cs_change = 1,
-	};
+		/* No DMA support on this platform */
+		dev->spi_dma = false;
+	}
+
+	return no_os_spi_transfer(dev->spi, xfer, 2);
+}
 
-	return no_os_spi_transfer(dev->spi, &xfer, 1);
+/***************************************************************************//**
+ * @brief Write data to a W5500 register
+ *
+ * @param dev   - The device descriptor
+ * @param block - The block select bits (common registers, socket registers, etc.)
+ * @param addr  - The register address
+ * @param data  - The data buffer to write
+ * @param len   - The data length
+ *
+ * @return 0 in case of success, negative error code otherwise
+*******************************************************************************/
+int w5500_reg_write(struct w5500_dev *dev, uint8_t block,
+		    uint16_t addr, const uint8_t *data, uint16_t len)
+{
+	return w5500_burst(dev, block, addr, W5500_RWB_WRITE, (uint8_t *)data,
+			   len);
 }
 
 /***************************************************************************//**
@@ -84,27 +123,7 @@ int w5500_reg_write(struct w5500_dev *dev, uint8_t block,
 int w5500_reg_read(struct w5500_dev *dev, uint8_t block,
 		   uint16_t addr, uint8_t *data, uint16_t len)
 {
-	uint8_t spi_buffer[3 + len];
-	int ret;
-
-	spi_buffer[0] = W5500_BYTE_HIGH(addr);
-	spi_buffer[1] = W5500_BYTE_LOW(addr);
-	spi_buffer[2] = W5500_BSB(block) | W5500_RWB_READ | W5500_OM_VDM;
-
-	struct no_os_spi_msg xfer = {
-		.tx_buff = spi_buffer,
-		.rx_buff = spi_buffer,
-		.bytes_number = 3 + len,
-		.cs_change = 1,
-	};
-
-	ret = no_os_spi_transfer(dev->spi, &xfer, 1);
-	if (ret)
-		return ret;
-
-	memcpy(data, &spi_buffer[3], len);
-
-	return 0;
+	return w5500_burst(dev, block, addr, W5500_RWB_READ, data, len);
 }
 
 /***************************************************************************//**
@@ -394,6 +413,100 @@ int w5500_socket_clear_interrupt(struct w5500_dev *dev, uint8_t sock_id,
 	return w5500_socket_reg_write(dev, sock_id, W5500_Sn_IR, &flags, 1);
 }
 
+/***************************************************************************//**
+ * @brief Read a socket buffer pointer
+ *
+ * Sn_TX_WR and Sn_RX_RD are only changed by the host, so unlike the size
+ * registers they don't need to be read twice.
+ *
+ * @param dev     - Device descriptor
+ * @param sock_id - Socket number (0-7)
+ * @param reg     - W5500_Sn_TX_WR or W5500_Sn_RX_RD
+ * @param ptr     - Variable to store the pointer
+ *
+ * @return 0 on success, negative error code otherwise
+*******************************************************************************/
+static int w5500_socket_read_ptr(struct w5500_dev *dev, uint8_t sock_id,
+				 uint16_t reg, uint16_t *ptr)
+{
+	uint8_t data[2];
+	int ret;
+
+	ret = w5500_socket_reg_read(dev, sock_id, reg, data, 2);
+	if (ret)
+		return ret;
+
+	*ptr = (data[0] << 8) | data[1];
+
+	return 0;
+}
+
+/***************************************************************************//**
+ * @brief Wait for a socket event on the INTn pin
+ *
+ * The pin is polled instead of the socket registers, so no SPI traffic is
+ * generated while the socket is idle. The caller checks the socket again
+ * once an event came or after W5500_INT_WAIT_US.
+ *
+ * @param dev     - Device descriptor
+ * @param sock_id - Socket number (0-7)
+ * @param flags   - Socket interrupts the caller waits for
+ *
+ * @return 0 on success, -ECONNRESET if the connection was closed or timed out
+ *         (TCP only), other negative error code otherwise
+*******************************************************************************/
+static int w5500_socket_wait_int(struct w5500_dev *dev, uint8_t sock_id,
+				 uint8_t flags)
+{
+	uint32_t timeout = W5500_INT_WAIT_US;
+	uint8_t value;
+	uint8_t ir;
+	int ret;
+
+	/* INTn is active low */
+	do {
+		ret = no_os_gpio_get_value(dev->gpio_int, &value);
+		if (ret)
+			return ret;
+
+		if (value == NO_OS_GPIO_LOW)
+			break;
+
+		no_os_udelay(1);
+	} while (--timeout);
+
+	if (!timeout)
+		return 0;
+
+	ret = w5500_socket_reg_read(dev, sock_id, W5500_Sn_IR, &ir, 1);
+	if (ret)
+		return ret;
+
+	/*
+	 * Every unmasked event is cleared once seen, a stale one would keep the
+	 * pin asserted for all the sockets.
+	 */
+	ir &= flags | W5500_Sn_IMR_MASK;
+	if (!ir) {
+		/* Asserted by another socket, don't spin on the bus. */
+		no_os_mdelay(1);
+		return 0;
+	}
+
+	ret = w5500_socket_clear_interrupt(dev, sock_id, ir);
+	if (ret)
+		return ret;
+
+	/* For UDP a timeout only means that ARP failed for one datagram. */
+	if (dev->sockets[sock_id].protocol == W5500_Sn_MR_UDP)
+		ir &= ~W5500_Sn_IR_TIMEOUT;
+
+	if (ir & (W5500_Sn_IR_DISCON | W5500_Sn_IR_TIMEOUT))
+		return -ECONNRESET;
+
+	return 0;
+}
+
 /***************************************************************************//**
  * @brief Initialize socket data structures
  *
@@ -423,6 +536,7 @@ int w5500_socket_init(struct w5500_dev *dev, uint8_t sock_id)
 {
 	int ret;
 	uint8_t mss_buf[2];
+	uint8_t imr;
 	struct w5500_socket *sock = &dev->sockets[sock_id];
 
 	mss_buf[0] = W5500_BYTE_HIGH(sock->mss);
@@ -451,6 +565,18 @@ int w5500_socket_init(struct w5500_dev *dev, uint8_t sock_id)
 	if (ret)
 		return ret;
 
+	if (dev->gpio_int) {
+		imr = W5500_Sn_IMR_MASK;
+		ret = w5500_socket_reg_write(dev, sock_id, W5500_Sn_IMR, &imr, 1);
+		if (ret)
+			return ret;
+	}
+
+	/* Drop the events left over by the previous user of the socket */
+	ret = w5500_socket_clear_interrupt(dev, sock_id, 0xFF);
+	if (ret)
+		return ret;
+
 	return w5500_socket_command_write(dev, sock_id, W5500_Sn_CR_OPEN);
 }
 
@@ -624,14 +750,20 @@ int w5500_socket_send(struct w5500_dev *dev, uint8_t sock_id, const void *buf,
 			    status != W5500_Sn_SR_MACRAW)
 				return -ECONNRESET;
 
-			no_os_mdelay(1);
+			if (dev->gpio_int) {
+				ret = w5500_socket_wait_int(dev, sock_id,
+							    W5500_Sn_IR_SEND_OK);
+				if (ret)
+					return ret;
+			} else {
+				no_os_mdelay(1);
+			}
 			continue;
 		}
 
 		chunk_size = (len - total_sent) < free_size ? (len - total_sent) : free_size;
 
-		ret = w5500_read_16bit_reg(dev, W5500_SOCKET_REG_BLOCK(sock_id),
-					   W5500_Sn_TX_WR, &wr_ptr);
+		ret = w5500_socket_read_ptr(dev, sock_id, W5500_Sn_TX_WR, &wr_ptr);
 		if (ret)
 			return ret;
 
@@ -709,14 +841,19 @@ int w5500_socket_recv(struct w5500_dev *dev, uint8_t sock_id, void *buf,
 		    status != W5500_Sn_SR_MACRAW)
 			return -ECONNRESET;
 
-		no_os_mdelay(1);
+		if (dev->gpio_int) {
+			ret = w5500_socket_wait_int(dev, sock_id, W5500_Sn_IR_RECV);
+			if (ret)
+				return ret;
+		} else {
+			no_os_mdelay(1);
+		}
 	}
 
 	if (len > rx_size)
 		len = rx_size;
 
-	ret = w5500_read_16bit_reg(dev, W5500_SOCKET_REG_BLOCK(sock_id),
-				   W5500_Sn_RX_RD, &rd_ptr);
+	ret = w5500_socket_read_ptr(dev, sock_id, W5500_Sn_RX_RD, &rd_ptr);
 	if (ret)
 		return ret;
 
@@ -799,11 +936,16 @@ int w5500_socket_sendto(struct w5500_dev *dev, uint8_t sock_id, const void *buf,
 		if (status != W5500_Sn_SR_UDP)
 			return -EPROTOTYPE;
 
-		no_os_mdelay(1);
+		if (dev->gpio_int) {
+			ret = w5500_socket_wait_int(dev, sock_id, W5500_Sn_IR_SEND_OK);
+			if (ret)
+				return ret;
+		} else {
+			no_os_mdelay(1);
+		}
 	}
 
-	ret = w5500_read_16bit_reg(dev, W5500_SOCKET_REG_BLOCK(sock_id),
-				   W5500_Sn_TX_WR, &wr_ptr);
+	ret = w5500_socket_read_ptr(dev, sock_id, W5500_Sn_TX_WR, &wr_ptr);
 	if (ret)
 		return ret;
 
@@ -866,8 +1008,7 @@ int w5500_socket_recvfrom(struct w5500_dev *dev, uint8_t sock_id,
 	if (rx_size < 8)
 		return 0;
 
-	ret = w5500_read_16bit_reg(dev, W5500_SOCKET_REG_BLOCK(sock_id),
-				   W5500_Sn_RX_RD, &rd_ptr);
+	ret = w5500_socket_read_ptr(dev, sock_id, W5500_Sn_RX_RD, &rd_ptr);
 	if (ret)
 		return ret;
 
@@ -1020,12 +1161,19 @@ int w5500_reset(struct w5500_dev *dev)
 *******************************************************************************/
 int w5500_setup(struct w5500_dev *dev)
 {
+	uint8_t simr = 0xFF;
 	int ret;
 
 	ret = w5500_reset(dev);
 	if (ret)
 		return ret;
 
+	if (dev->gpio_int) {
+		ret = w5500_reg_write(dev, W5500_COMMON_REG, W5500_SIMR, &simr, 1);
+		if (ret)
+			return ret;
+	}
+
 	ret = w5500_set_mac(dev, dev->mac_addr);
 	if (ret)
 		return ret;
@@ -1063,6 +1211,12 @@ int w5500_init(struct w5500_dev **device,
 	if (ret)
 		goto free_gpio_reset;
 
+	if (dev->gpio_int) {
+		ret = no_os_gpio_direction_input(dev->gpio_int);
+		if (ret)
+			goto free_gpio_int;
+	}
+
 	ret = no_os_spi_init(&dev->spi, init_param->spi_init);
 	if (ret)
 		goto free_gpio_int;
@@ -1070,6 +1224,7 @@ int w5500_init(struct w5500_dev **device,
 	memcpy(dev->mac_addr, init_param->mac_addr, 6);
 	memcpy(&dev->retry_time, &init_param->retry_time, 1);
 	memcpy(&dev->retry_count, &init_param->retry_count, 1);
+	dev->spi_dma = init_param->spi_dma;
 
 	w5500_sockets_init(dev);
 
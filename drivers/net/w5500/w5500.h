@@ -162,6 +162,10 @@
 #define W5500_Sn_IR_DISCON           NO_OS_BIT(1)    /* Connection termination requested/completed */
 #define W5500_Sn_IR_CON              NO_OS_BIT(0)    /* Connection established */
 
+/* Socket interrupts driving the INTn pin, when it is connected */
+#define W5500_Sn_IMR_MASK            (W5500_Sn_IR_SEND_OK | W5500_Sn_IR_TIMEOUT | \
+				      W5500_Sn_IR_RECV | W5500_Sn_IR_DISCON)
+
 /* Interrupt Register (IR) values */
 #define W5500_IR_CONFLICT            NO_OS_BIT(7)    /* IP address conflict */
 #define W5500_IR_UNREACH             NO_OS_BIT(6)    /* Destination unreachable */
@@ -203,6 +207,12 @@
 /* Maximum socket number */
 #define W5500_MAX_SOCK_NUMBER        7       /* 8 sockets (0-7) */
 
+/* Shortest data phase moved with DMA, register accesses stay on PIO */
+#define W5500_DMA_MIN_LEN            32
+
+/* Time to wait for the INTn pin before checking the socket again */
+#define W5500_INT_WAIT_US            1000
+
 struct w5500_socket_address {
 	uint8_t ip[4];
 	uint8_t port[2];
@@ -219,6 +229,7 @@ struct w5500_dev {
 	struct no_os_gpio_desc *gpio_reset;
 	struct no_os_gpio_desc *gpio_int;
 	struct no_os_spi_desc *spi;
+	bool spi_dma;
 	uint8_t mac_addr[6];
 	uint16_t retry_time;
 	uint8_t retry_count;
@@ -229,6 +240,8 @@ struct w5500_init_param {
 	const struct no_os_gpio_init_param *gpio_reset;
 	const struct no_os_gpio_init_param *gpio_int;
 	const struct no_os_spi_init_param *spi_init;
+	/* Move socket buffer data with no_os_spi_transfer_dma() */
+	bool spi_dma;
 	uint8_t mac_addr[6];
 	uint16_t retry_time;
 	uint8_t retry_count;
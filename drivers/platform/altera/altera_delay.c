@@ -31,6 +31,7 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *******************************************************************************/
 
+#include <sys/alt_alarm.h>
 #include "no_os_delay.h"
 
 /**
@@ -50,3 +51,23 @@ void no_os_mdelay(uint32_t msecs)
 {
 	usleep(msecs * 1000);
 }
+
+/**
+ * @brief Get current time.
+ * @return Current time structure from system start (seconds, microseconds).
+ */
+struct no_os_time no_os_get_time(void)
+{
+	struct no_os_time t = {0, 0};
+	alt_u32 rate = alt_ticks_per_second();
+	alt_u32 ticks = alt_nticks();
+
+	/* No system clock timer in the design. */
+	if (!rate)
+		return t;
+
+	t.s = ticks / rate;
+	t.us = (unsigned long long)(ticks % rate) * 1000000 / rate;
+
+	return t;
+}
@@ -34,17 +34,28 @@
 #include "no_os_error.h"
 #include "no_os_spi.h"
 #include "no_os_alloc.h"
+#include "no_os_util.h"
 #include "linux_spi.h"
 
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <linux/spi/spidev.h>
 
 #warning SPI cs_delay_first and cs_delay_last delays are not supported on the linux platform
 
+/* Number of transfers preallocated if not specified in linux_spi_init_param */
+#define LINUX_SPI_DEFAULT_TRANSFERS	32
+/* Largest number of transfers that fits in the size field of the ioctl */
+#define LINUX_SPI_MAX_TRANSFERS		(_IOC_SIZEMASK / \
+					 sizeof(struct spi_ioc_transfer))
+/* spidev limit for the bytes of one message, if it can't be read from sysfs */
+#define LINUX_SPI_DEFAULT_BUFSIZ	4096
+#define LINUX_SPI_BUFSIZ_PATH		"/sys/module/spidev/parameters/bufsiz"
+
 /**
  * @struct linux_spi_desc
  * @brief Linux platform specific SPI descriptor
@@ -52,8 +63,65 @@
 struct linux_spi_desc {
 	/** /dev/spidev"device_id"."chip_select" file descriptor */
 	int spidev_fd;
+	/** Transfer pool, reused by every SPI_IOC_MESSAGE */
+	struct spi_ioc_transfer *tr;
+	/** Number of transfers in the pool */
+	uint32_t tr_size;
+	/** Number of queued transfers */
+	uint32_t nb_queued;
+	/** Number of bytes in the queued transfers */
+	uint32_t queued_bytes;
+	/** Maximum number of bytes spidev accepts in one message */
+	uint32_t max_bytes;
 };
 
+/**
+ * @brief Read the spidev buffer size, which limits the length of a message.
+ * @return The buffer size in bytes.
+ */
+static uint32_t linux_spi_get_bufsiz(void)
+{
+	unsigned int bufsiz;
+	FILE *f;
+	int ret;
+
+	f = fopen(LINUX_SPI_BUFSIZ_PATH, "r");
+	if (!f)
+		return LINUX_SPI_DEFAULT_BUFSIZ;
+
+	ret = fscanf(f, "%u", &bufsiz);
+	fclose(f);
+	if (ret != 1 || !bufsiz)
+		return LINUX_SPI_DEFAULT_BUFSIZ;
+
+	return bufsiz;
+}
+
+/**
+ * @brief Resize the transfer pool. Must be called with no queued transfers.
+ * @param linux_desc - The Linux SPI descriptor.
+ * @param size - New number of transfers.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+static int32_t linux_spi_pool_resize(struct linux_spi_desc *linux_desc,
+				     uint32_t size)
+{
+	struct spi_ioc_transfer *tr;
+
+	if (!size || size > LINUX_SPI_MAX_TRANSFERS)
+		return -EMSGSIZE;
+
+	tr = (struct spi_ioc_transfer *)no_os_calloc(size, sizeof(*tr));
+	if (!tr)
+		return -ENOMEM;
+
+	no_os_free(linux_desc->tr);
+	linux_desc->tr = tr;
+	linux_desc->tr_size = size;
+
+	return 0;
+}
+
 /**
  * @brief Initialize the SPI communication peripheral.
  * @param desc - The SPI descriptor.
@@ -63,22 +131,36 @@ struct linux_spi_desc {
 int32_t linux_spi_init(struct no_os_spi_desc **desc,
 		       const struct no_os_spi_init_param *param)
 {
+	struct linux_spi_init_param *linux_param;
 	struct linux_spi_desc *linux_desc;
 	struct no_os_spi_desc *descriptor;
+	uint32_t max_transfers;
 	uint8_t bits = 8;
 	char path[64];
 	int ret;
 
-	descriptor = no_os_malloc(sizeof(*descriptor));
+	descriptor = no_os_calloc(1, sizeof(*descriptor));
 	if (!descriptor)
 		return -1;
 
-	linux_desc = (struct linux_spi_desc*) no_os_malloc(sizeof(
-				struct linux_spi_desc));
+	linux_desc = (struct linux_spi_desc*) no_os_calloc(1,
+			sizeof(struct linux_spi_desc));
 	if (!linux_desc)
 		goto free_desc;
 
 	descriptor->extra = linux_desc;
+	descriptor->device_id = param->device_id;
+	descriptor->chip_select = param->chip_select;
+	descriptor->max_speed_hz = param->max_speed_hz;
+	descriptor->mode = param->mode;
+
+	max_transfers = LINUX_SPI_DEFAULT_TRANSFERS;
+	linux_param = param->extra;
+	if (linux_param && linux_param->max_transfers)
+		max_transfers = linux_param->max_transfers;
+	if (linux_spi_pool_resize(linux_desc, max_transfers))
+		goto free_linux_desc;
+	linux_desc->max_bytes = linux_spi_get_bufsiz();
 
 	snprintf(path, sizeof(path), "/dev/spidev%d.%d",
 		 param->device_id, param->chip_select);
@@ -93,27 +175,31 @@ int32_t linux_spi_init(struct no_os_spi_desc **desc,
 		    &param->mode);
 	if (ret == -1) {
 		printf("%s: Can't set SPI mode\n\r", __func__);
-		goto free;
+		goto close_fd;
 	}
 
 	ret = ioctl(linux_desc->spidev_fd, SPI_IOC_WR_BITS_PER_WORD,
 		    &bits);
 	if (ret == -1) {
 		printf("%s: Can't set SPI bits per word\n\r", __func__);
-		goto free;
+		goto close_fd;
 	}
 
 	ret = ioctl(linux_desc->spidev_fd, SPI_IOC_WR_MAX_SPEED_HZ,
 		    &param->max_speed_hz);
 	if (ret == -1) {
 		printf("%s: Can't set SPI max speed hz\n\r", __func__);
-		goto free;
+		goto close_fd;
 	}
 
 	*desc = descriptor;
 
 	return 0;
+close_fd:
+	close(linux_desc->spidev_fd);
 free:
+	no_os_free(linux_desc->tr);
+free_linux_desc:
 	no_os_free(linux_desc);
 free_desc:
 	no_os_free(descriptor);
@@ -122,94 +208,179 @@ free_desc:
 }
 
 /**
- * @brief Write and read data to/from SPI.
+ * @brief Queue a list of messages. The messages are sent, together with the
+ * other queued ones, by linux_spi_flush() or by the next transfer. CS is
+ * deasserted after the last message of each list. Queued messages are sent
+ * before this call returns only if the queue has no room for the new ones,
+ * so the buffers must stay valid until the queue is flushed.
  * @param desc - The SPI descriptor.
- * @param data - The buffer with the transmitted/received data.
- * @param bytes_number - Number of bytes to write/read.
- * @return 0 in case of success, -1 otherwise.
+ * @param msgs - Array of messages.
+ * @param len - Number of messages in the array.
+ * @return 0 in case of success, negative error code otherwise.
  */
-int32_t linux_spi_write_and_read(struct no_os_spi_desc *desc,
-				 uint8_t *data,
-				 uint16_t bytes_number)
+int32_t linux_spi_queue(struct no_os_spi_desc *desc,
+			struct no_os_spi_msg *msgs,
+			uint32_t len)
 {
-	struct spi_ioc_transfer tr = {
-		.tx_buf = (unsigned long)data,
-		.rx_buf = (unsigned long)data,
-		.len = bytes_number,
-	};
 	struct linux_spi_desc *linux_desc;
-	int ret;
+	struct spi_ioc_transfer *tr;
+	uint32_t bytes;
+	uint32_t i;
+	int32_t ret;
+
+	if (!desc || !msgs || !len)
+		return -EINVAL;
 
 	linux_desc = desc->extra;
 
-	ret = ioctl(linux_desc->spidev_fd, SPI_IOC_MESSAGE(1), &tr);
-	if (ret == 1) {
-		printf("%s: Can't send spi message\n\r", __func__);
-		return -1;
+	bytes = 0;
+	for (i = 0; i < len; i++)
+		bytes += msgs[i].bytes_number;
+	if (len > LINUX_SPI_MAX_TRANSFERS || bytes > linux_desc->max_bytes)
+		return -EMSGSIZE;
+
+	/* Send what is queued if the new messages don't fit in the same ioctl */
+	if (linux_desc->nb_queued + len > linux_desc->tr_size ||
+	    linux_desc->queued_bytes + bytes > linux_desc->max_bytes) {
+		ret = linux_spi_flush(desc);
+		if (ret)
+			return ret;
+	}
+
+	if (len > linux_desc->tr_size) {
+		ret = linux_spi_pool_resize(linux_desc,
+					    no_os_min(no_os_max(len, 2 * linux_desc->tr_size),
+						      LINUX_SPI_MAX_TRANSFERS));
+		if (ret)
+			return ret;
 	}
 
+	tr = &linux_desc->tr[linux_desc->nb_queued];
+	memset(tr, 0, len * sizeof(*tr));
+	for (i = 0; i < len; i++) {
+		tr[i].tx_buf = (unsigned long) msgs[i].tx_buff;
+		tr[i].rx_buf = (unsigned long) msgs[i].rx_buff;
+		tr[i].len = msgs[i].bytes_number;
+		tr[i].cs_change = msgs[i].cs_change;
+		tr[i].word_delay_usecs = msgs[i].cs_change_delay;
+		tr[i].speed_hz = msgs[i].speed_hz;
+		tr[i].bits_per_word = msgs[i].bits_per_word;
+	}
+	/* Separate this list from the next one queued */
+	tr[len - 1].cs_change = 1;
+
+	linux_desc->nb_queued += len;
+	linux_desc->queued_bytes += bytes;
+
 	return 0;
 }
 
 /**
- * @brief Free the resources allocated by linux_spi_init().
+ * @brief Send all the queued messages with a single SPI_IOC_MESSAGE.
  * @param desc - The SPI descriptor.
- * @return 0 in case of success, -1 otherwise.
+ * @return 0 in case of success, negative error code otherwise.
  */
-int32_t linux_spi_remove(struct no_os_spi_desc *desc)
+int32_t linux_spi_flush(struct no_os_spi_desc *desc)
 {
 	struct linux_spi_desc *linux_desc;
-	int32_t ret;
+	uint32_t nb_queued;
+	int ret;
+
+	if (!desc)
+		return -EINVAL;
 
 	linux_desc = desc->extra;
+	nb_queued = linux_desc->nb_queued;
+	if (!nb_queued)
+		return 0;
 
-	ret = close(linux_desc->spidev_fd);
+	/* A cs_change on the last transfer would keep CS asserted */
+	linux_desc->tr[nb_queued - 1].cs_change = 0;
+	linux_desc->nb_queued = 0;
+	linux_desc->queued_bytes = 0;
+
+	ret = ioctl(linux_desc->spidev_fd, SPI_IOC_MESSAGE(nb_queued),
+		    linux_desc->tr);
 	if (ret < 0) {
-		printf("%s: Can't close device\n\r", __func__);
-		return -1;
+		ret = -errno;
+		printf("%s: Can't send spi message (%d)\n\r", __func__, -ret);
+		return ret;
 	}
 
-	no_os_free(desc->extra);
-	no_os_free(desc);
-
 	return 0;
 }
 
+/**
+ * @brief Iterate over the spi_msg array and send all messages at once. Queued
+ * messages are sent in the same ioctl, before these ones.
+ * @param desc - The SPI descriptor.
+ * @param msgs - Array of messages.
+ * @param len - Number of messages in the array.
+ * @return 0 in case of success, negative error code otherwise.
+ */
 static int32_t linux_spi_transfer(struct no_os_spi_desc *desc,
 				  struct no_os_spi_msg *msgs,
 				  uint32_t len)
+{
+	int32_t ret;
+
+	ret = linux_spi_queue(desc, msgs, len);
+	if (ret)
+		return ret;
+
+	return linux_spi_flush(desc);
+}
 
+/**
+ * @brief Write and read data to/from SPI.
+ * @param desc - The SPI descriptor.
+ * @param data - The buffer with the transmitted/received data.
+ * @param bytes_number - Number of bytes to write/read.
+ * @return 0 in case of success, -1 otherwise.
+ */
+int32_t linux_spi_write_and_read(struct no_os_spi_desc *desc,
+				 uint8_t *data,
+				 uint16_t bytes_number)
 {
-	struct spi_ioc_transfer *tr;
-	struct linux_spi_desc	*linux_desc;
-	int			ret;
-	uint32_t		i;
+	struct no_os_spi_msg msg = {
+		.tx_buff = data,
+		.rx_buff = data,
+		.bytes_number = bytes_number,
+	};
 
-	linux_desc = desc->extra;
+	if (linux_spi_transfer(desc, &msg, 1))
+		return -1;
 
-	tr = (struct spi_ioc_transfer *)no_os_calloc(len, sizeof(*tr));
-	if (!tr)
-		return -ENOMEM;
+	return 0;
+}
 
-	for (i = 0; i < len; i++) {
-		tr[i].tx_buf = (unsigned long) msgs[i].tx_buff;
-		tr[i].rx_buf = (unsigned long) msgs[i].rx_buff;
-		tr[i].len = msgs[i].bytes_number;
-		tr[i].cs_change = msgs[i].cs_change;
-		tr[i].word_delay_usecs = msgs[i].cs_change_delay;
-	}
+/**
+ * @brief Free the resources allocated by linux_spi_init().
+ * @param desc - The SPI descriptor.
+ * @return 0 in case of success, -1 otherwise.
+ */
+int32_t linux_spi_remove(struct no_os_spi_desc *desc)
+{
+	struct linux_spi_desc *linux_desc;
+	int32_t ret;
 
-	ret = ioctl(linux_desc->spidev_fd, SPI_IOC_MESSAGE(len), tr);
+	linux_desc = desc->extra;
 
-	no_os_free(tr);
+	linux_spi_flush(desc);
 
+	ret = close(linux_desc->spidev_fd);
 	if (ret < 0) {
-		printf("%s: Can't send spi message (%d)\n\r", __func__, errno);
-		return ret;
+		printf("%s: Can't close device\n\r", __func__);
+		return -1;
 	}
 
+	no_os_free(linux_desc->tr);
+	no_os_free(desc->extra);
+	no_os_free(desc);
+
 	return 0;
 }
+
 /**
  * @brief Linux platform specific SPI platform ops structure
  */
@@ -34,9 +34,32 @@
 #ifndef LINUX_SPI_H_
 #define LINUX_SPI_H_
 
+#include "no_os_spi.h"
+
+/**
+ * @struct linux_spi_init_param
+ * @brief Structure holding the initialization parameters for Linux platform
+ * specific SPI parameters. Optional, defaults are used if extra is NULL.
+ */
+struct linux_spi_init_param {
+	/**
+	 * Number of transfers preallocated for a single SPI_IOC_MESSAGE.
+	 * The pool grows if a longer message list is sent.
+	 */
+	uint32_t max_transfers;
+};
+
 /**
  * @brief Linux specific SPI platform ops structure
  */
 extern const struct no_os_spi_platform_ops linux_spi_ops;
 
+/* Queue a list of messages, to be sent together with the next ones. */
+int32_t linux_spi_queue(struct no_os_spi_desc *desc,
+			struct no_os_spi_msg *msgs,
+			uint32_t len);
+
+/* Send all the queued messages with a single ioctl. */
+int32_t linux_spi_flush(struct no_os_spi_desc *desc);
+
 #endif // LINUX_SPI_H_
@@ -109,12 +109,8 @@ static int32_t max_uart_read(struct no_os_uart_desc *desc, uint8_t *data,
 		return -EINVAL;
 
 	if (desc->rx_fifo) {
-		for (i = 0; i < bytes_number; i++) {
-			ret = lf256fifo_read(desc->rx_fifo, &data[i]);
-			if (ret)
-				return i ? (int32_t)i : -EAGAIN;
-		}
-		return i;
+		i = lf256fifo_read_bulk(desc->rx_fifo, data, bytes_number);
+		return i ? (int32_t)i : -EAGAIN;
 	}
 
 	ret = MXC_UART_Read(MXC_UART_GET_UART(desc->device_id), data,
@@ -368,7 +364,8 @@ static int32_t max_uart_init(struct no_os_uart_desc **desc,
 	*desc = descriptor;
 
 	if (param->asynchronous_rx) {
-		ret = lf256fifo_init(&descriptor->rx_fifo);
+		ret = lf256fifo_init_size(&descriptor->rx_fifo,
+					  param->rx_fifo_size);
 		if (ret)
 			goto error;
 
@@ -442,7 +439,6 @@ static int32_t max_uart_remove(struct no_os_uart_desc *desc)
 					      &discard);
 		no_os_irq_ctrl_remove(extra->nvic);
 		lf256fifo_remove(desc->rx_fifo);
-		no_os_free(desc->rx_fifo);
 	}
 
 	uart_irq_state[id].uart = MXC_UART_GET_UART(id);
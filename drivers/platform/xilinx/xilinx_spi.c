@@ -40,6 +40,12 @@
 #ifdef XPAR_XSPIPS_NUM_INSTANCES
 #include <xspips.h>
 #endif
+#ifdef __MICROBLAZE__
+#include <mb_interface.h>
+#else
+#include <xil_exception.h>
+#include <xpseudo_asm.h>
+#endif
 
 #include "no_os_error.h"
 #include "no_os_spi.h"
@@ -56,8 +62,29 @@
 #define SPI_NUM_INSTANCES	0
 #endif
 
+#ifdef __MICROBLAZE__
+/* Interrupt enable bit of the Microblaze MSR */
+#define XIL_MSR_IE		0x2
+#endif
+
 #warning SPI delays are not supported on the xilinx platform
 
+/**
+ * @brief Check if the caller runs in interrupt context or with interrupts
+ * masked. Overrides the generic version, which only knows Cortex-M cores.
+ * Interrupts are masked while a handler runs, unless it enables nesting.
+ * @return true if the caller must not wait for the SPI bus.
+ */
+bool no_os_spi_in_irq(void)
+{
+#ifdef __MICROBLAZE__
+	return !(mfmsr() & XIL_MSR_IE);
+#else
+	/* CPSR.I on Cortex-A9/R5, DAIF.I on Cortex-A53 */
+	return !!(mfcpsr() & XIL_EXCEPTION_IRQ);
+#endif
+}
+
 /**
  * @brief Initialize the hardware SPI peripherial
  *
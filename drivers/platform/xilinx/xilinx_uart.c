@@ -39,7 +39,6 @@
 #include "xilinx_irq.h"
 #ifdef XPAR_XUARTPS_NUM_INSTANCES
 #include "no_os_irq.h"
-#include "no_os_fifo.h"
 #include <xil_exception.h>
 #include <xuartps.h>
 #endif
@@ -50,51 +49,9 @@
 
 #define WRITE_SIZE 255
 
-#ifdef XUARTPS_H
-/**
- * @brief Save received data into fifo.
- * @param desc - Instance descriptor containing a fifo element.
- * @return 0 in case of success, -1 otherwise.
- */
-static int32_t uart_fifo_insert(struct no_os_uart_desc *desc)
-{
-	int32_t ret;
-	struct xil_uart_desc *xil_uart_desc = desc->extra;
-	struct no_os_irq_ctrl_desc *irq_desc = xil_uart_desc->irq_desc;
-
-	if (xil_uart_desc->bytes_received > 0) {
-		ret = no_os_irq_disable(irq_desc, xil_uart_desc->irq_id);
-		if (ret < 0)
-			return ret;
-		ret = no_os_fifo_insert(&xil_uart_desc->fifo, xil_uart_desc->buff,
-					xil_uart_desc->bytes_received);
-		if (ret < 0)
-			return ret;
-		xil_uart_desc->bytes_received = 0;
-		switch (xil_uart_desc->type) {
-		case UART_PS:
-			XUartPs_Recv(xil_uart_desc->instance, (u8*)(xil_uart_desc->buff),
-				     UART_BUFF_LENGTH);
-			break;
-		case UART_PL:
-
-			break;
-		default:
-			return -1;
-			break;
-		}
-		ret = no_os_irq_enable(irq_desc, xil_uart_desc->irq_id);
-		if (ret < 0)
-			return ret;
-	}
-
-	return 0;
-}
-#endif // XUARTPS_H
-
 /**
- * @brief Read byte from fifo.
- * @param desc - Instance descriptor containing a fifo element
+ * @brief Read byte from the PL UART.
+ * @param desc - Instance descriptor
  * @param data - read value.
  * @return 0 in case of success, -1 otherwise.
  */
@@ -104,29 +61,8 @@ static int32_t xil_uart_read_byte(struct no_os_uart_desc *desc, uint8_t *data)
 #ifdef XUARTLITE_H
 	XUartLite *instance = xil_uart_desc->instance;
 #endif
-#ifdef XUARTPS_H
-	int32_t ret;
-#endif
 
 	switch (xil_uart_desc->type) {
-	case UART_PS:
-#ifdef XUARTPS_H
-		while (xil_uart_desc->fifo == NULL) {
-			/* nothing in fifo, wait until something is received */
-			ret = uart_fifo_insert(desc);
-			if (ret < 0)
-				return ret;
-		}
-
-		*data = xil_uart_desc->fifo->data[xil_uart_desc->fifo_read_offset];
-		xil_uart_desc->fifo_read_offset++;
-
-		if (xil_uart_desc->fifo->len - xil_uart_desc->fifo_read_offset <= 0) {
-			xil_uart_desc->fifo_read_offset = 0;
-			xil_uart_desc->fifo = no_os_fifo_remove(xil_uart_desc->fifo);
-		}
-#endif // XUARTPS_H
-		break;
 	case UART_PL:
 #ifdef XUARTLITE_H
 		while (!(Xil_In32(instance->RegBaseAddress + XUL_STATUS_REG_OFFSET) &
@@ -151,8 +87,20 @@ static int32_t xil_uart_read_byte(struct no_os_uart_desc *desc, uint8_t *data)
 static int32_t xil_uart_read(struct no_os_uart_desc *desc, uint8_t *data,
 			     uint32_t bytes_number)
 {
+	struct xil_uart_desc *xil_uart_desc = desc->extra;
+	uint32_t i;
 	int ret;
-	for (uint32_t i = 0; i < bytes_number; i++) {
+
+	if (xil_uart_desc->type == UART_PS) {
+		/* Wait until the interrupt handler received everything */
+		for (i = 0; i < bytes_number;)
+			i += no_os_fifo_read(&xil_uart_desc->fifo, data + i,
+					     bytes_number - i);
+
+		return bytes_number;
+	}
+
+	for (i = 0; i < bytes_number; i++) {
 		ret = xil_uart_read_byte(desc, &data[i]);
 		if (ret < 0)
 			return ret;
@@ -233,7 +181,12 @@ static void uart_irq_handler(void *call_back_ref, uint32_t event,
 		 * timeout just indicates the data stopped for configured character time
 		 */
 		case XUARTPS_EVENT_RECV_TOUT:
-			xil_uart_desc->bytes_received = data_len;
+			if (no_os_fifo_insert(&xil_uart_desc->fifo,
+					      xil_uart_desc->buff,
+					      data_len) != data_len)
+				xil_uart_desc->total_error_count++;
+			XUartPs_Recv(xil_uart_desc->instance,
+				     (u8 *)xil_uart_desc->buff, UART_BUFF_LENGTH);
 			break;
 		/*
 		 * Data was received with an error, keep the data but determine
@@ -417,6 +370,9 @@ static int32_t xil_uart_init(struct no_os_uart_desc **desc,
 		 */
 		XUartPs_SetRecvTimeout(xil_uart_desc->instance, 8);
 
+		no_os_fifo_cfg(&xil_uart_desc->fifo, xil_uart_desc->fifo_buff,
+			       XIL_UART_FIFO_SIZE);
+
 		status = uart_irq_init(descriptor);
 		if (status != XST_SUCCESS)
 			goto error_free_instance;
@@ -499,7 +455,12 @@ static int32_t xil_uart_read_nonblocking(struct no_os_uart_desc *desc,
 		uint8_t *data,
 		uint32_t bytes_number)
 {
-	return -EINVAL;
+	struct xil_uart_desc *xil_uart_desc = desc->extra;
+
+	if (xil_uart_desc->type != UART_PS)
+		return -EINVAL;
+
+	return no_os_fifo_read(&xil_uart_desc->fifo, data, bytes_number);
 }
 
 /**
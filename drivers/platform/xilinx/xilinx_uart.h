@@ -34,8 +34,11 @@
 #ifndef XILINX_UART_H_
 #define XILINX_UART_H_
 
+#include "no_os_fifo.h"
 
 #define UART_BUFF_LENGTH 256
+/* Size of the receive fifo. Must be a power of 2 */
+#define XIL_UART_FIFO_SIZE 1024
 
 /**
  * @enum xil_uart_type
@@ -73,14 +76,12 @@ struct xil_uart_desc {
 	uint32_t			irq_id;
 	/** Interrupt Request Descriptor */
 	struct no_os_irq_ctrl_desc *irq_desc;
-	/** FIFO */
-	struct no_os_fifo_element	*fifo;
-	/** FIFO read offset */
-	uint32_t 			fifo_read_offset;
+	/** Receive FIFO, filled from the interrupt handler */
+	struct no_os_fifo		fifo;
+	/** Receive FIFO storage */
+	uint8_t				fifo_buff[XIL_UART_FIFO_SIZE];
 	/** UART Buffer */
 	char 				buff[UART_BUFF_LENGTH];
-	/** Number of bytes received */
-	uint32_t 			bytes_received;
 	/** Total number of errors */
 	uint32_t 			total_error_count;
 	/** UART Instance */
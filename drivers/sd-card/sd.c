@@ -37,6 +37,7 @@
 #include "no_os_delay.h"
 #include "no_os_error.h"
 #include "no_os_alloc.h"
+#include "no_os_util.h"
 
 #define BIT_CCS				(1u<<30)
 #define BIT_APPLICATION_CMD		(1u<<7)
@@ -46,6 +47,7 @@
 
 #define CMD0_RETRY_NUMBER		(5u)
 #define WAIT_RESP_TIMEOUT		(1000u) //1000ms
+#define BUSY_FAST_POLLS			(256u)  //Polls before delaying 1ms
 
 #define R1_READY_STATE			(0x00u)
 #define R1_IDLE_STATE			(0x01u)
@@ -88,6 +90,7 @@ static int32_t wait_for_response(struct sd_desc *sd_desc, uint8_t *data_out)
 	ret = -1;
 	not_timeout = WAIT_RESP_TIMEOUT;
 	do {
+		*data_out = 0xFF;
 		if (0 != no_os_spi_write_and_read(sd_desc->spi_desc,
 						  data_out, 1))
 			break;
@@ -108,24 +111,24 @@ static int32_t wait_for_response(struct sd_desc *sd_desc, uint8_t *data_out)
  */
 static int32_t wait_until_not_busy(struct sd_desc *sd_desc)
 {
-	uint32_t	not_timeout;
-	int32_t		ret;
+	uint32_t	i;
 	uint8_t		data;
 
-	ret = -1;
-	not_timeout = WAIT_RESP_TIMEOUT;
-	do {
+	/*
+	 * Most blocks are programmed in well under a millisecond, so poll
+	 * without delay first and only then fall back to 1ms steps.
+	 */
+	for (i = 0; i < BUSY_FAST_POLLS + WAIT_RESP_TIMEOUT; i++) {
 		data = 0xFF;
 		if (0 != no_os_spi_write_and_read(sd_desc->spi_desc, &data, 1))
-			break;
-		if (data != 0x00) {
-			ret = 0;
-			break;
-		}
-		no_os_mdelay(1);
-	} while (not_timeout--);
+			return -1;
+		if (data != 0x00)
+			return 0;
+		if (i >= BUSY_FAST_POLLS)
+			no_os_mdelay(1);
+	}
 
-	return ret;
+	return -1;
 }
 
 /**
@@ -194,31 +197,14 @@ static int32_t send_command(struct sd_desc *sd_desc, struct cmd_desc *cmd_desc)
 }
 
 /**
- * Send one block of data to the SD card
+ * Read the data response token sent by the SD card after a data block
  * @param sd_desc	- Instance of the SD card
- * @param data		- Data to be written
- * @param nb_of_blocks	- Number of blocks written in the executing command
- * @return 0 in case of success, -1 otherwise.
+ * @return 0 if the data was accepted, -1 otherwise.
  */
-static int32_t write_block(struct sd_desc *sd_desc, uint8_t *data,
-			   uint32_t nb_of_blocks)
+static int32_t read_data_response(struct sd_desc *sd_desc)
 {
-	/* Send start block token */
-	sd_desc->buff[0] = START_N_BLOCK_TOKEN;
-	if (nb_of_blocks == 1)
-		sd_desc->buff[0] = START_1_BLOCK_TOKEN;
-	if (0 != no_os_spi_write_and_read(sd_desc->spi_desc, sd_desc->buff, 1))
-		return -1;
-
-	/* Send data with CRC */
-	if (0 != no_os_spi_write_and_read(sd_desc->spi_desc, data, DATA_BLOCK_LEN))
-		return -1;
-	*((uint16_t *)sd_desc->buff) = 0xFFFF;
-	if (0 != no_os_spi_write_and_read(sd_desc->spi_desc, sd_desc->buff, CRC_LEN))
-		return -1;
-
-	/* Read response and check if write was ok */
 	uint8_t		response;
+
 	if (0 != wait_for_response(sd_desc, &response))
 		return -1;
 	switch (response & MASK_RESPONSE_TOKEN) {
@@ -234,6 +220,56 @@ static int32_t write_block(struct sd_desc *sd_desc, uint8_t *data,
 		DEBUG_MSG("Other problem\n");
 		return -1;
 	}
+
+	return 0;
+}
+
+/**
+ * Fill the messages that send one data block: start block token, data and
+ * dummy CRC. The data buffer is not overwritten with the received bytes.
+ * @param msgs		- Array of 3 messages
+ * @param token		- Start block token
+ * @param data		- DATA_BLOCK_LEN bytes to be written
+ * @param crc		- CRC_LEN bytes of CRC
+ */
+static void fill_data_block_msgs(struct no_os_spi_msg *msgs, uint8_t *token,
+				 uint8_t *data, uint8_t *crc)
+{
+	memset(msgs, 0, 3 * sizeof(*msgs));
+	msgs[0].tx_buff = token;
+	msgs[0].bytes_number = 1;
+	msgs[1].tx_buff = data;
+	msgs[1].bytes_number = DATA_BLOCK_LEN;
+	msgs[2].tx_buff = crc;
+	msgs[2].bytes_number = CRC_LEN;
+	msgs[2].cs_change = 1;
+}
+
+/**
+ * Send one block of data to the SD card
+ * @param sd_desc	- Instance of the SD card
+ * @param data		- Data to be written
+ * @param nb_of_blocks	- Number of blocks written in the executing command
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t write_block(struct sd_desc *sd_desc, uint8_t *data,
+			   uint32_t nb_of_blocks)
+{
+	struct no_os_spi_msg	msgs[3];
+
+	/* Send start block token and data with CRC */
+	sd_desc->buff[0] = START_N_BLOCK_TOKEN;
+	if (nb_of_blocks == 1)
+		sd_desc->buff[0] = START_1_BLOCK_TOKEN;
+	sd_desc->buff[1] = 0xFF;
+	sd_desc->buff[2] = 0xFF;
+	fill_data_block_msgs(msgs, &sd_desc->buff[0], data, &sd_desc->buff[1]);
+	if (0 != no_os_spi_transfer(sd_desc->spi_desc, msgs, NO_OS_ARRAY_SIZE(msgs)))
+		return -1;
+
+	/* Read response and check if write was ok */
+	if (0 != read_data_response(sd_desc))
+		return -1;
 	if (0 != wait_until_not_busy(sd_desc))
 		return -1;
 
@@ -389,28 +425,19 @@ static int32_t read_multiple_blocks(struct sd_desc *sd_desc,
 }
 
 /**
- * Read data of size len from the specified address and store it in data.
- * This operation returns only when the read is complete
+ * Send the command that starts a read of one or more blocks
  * @param sd_desc	- Instance of the SD card
- * @param data		- Where data will be read
- * @param address	- Address in memory from where data will be read
- * @param len		- Length in bytes of data to be read
+ * @param block		- First block to be read
+ * @param nb_of_blocks	- Number of blocks to be read
  * @return 0 in case of success, -1 otherwise.
  */
-int32_t sd_read(struct sd_desc *sd_desc,
-		uint8_t *data, uint64_t address, uint64_t len)
+static int32_t start_read(struct sd_desc *sd_desc, uint64_t block,
+			  uint32_t nb_of_blocks)
 {
 	struct cmd_desc	cmd_desc;
 
-	/* Initial checks */
-	if (data == NULL || address > sd_desc->memory_size ||
-	    len > sd_desc->memory_size ||
-	    address + len > sd_desc->memory_size)
-		return -1;
-
-	/* Send read command */
-	cmd_desc.cmd = (get_nb_of_blocks(address, len) == 1) ? CMD(17) : CMD(18);
-	cmd_desc.arg = address >> DATA_BLOCK_BITS;;
+	cmd_desc.cmd = (nb_of_blocks == 1) ? CMD(17) : CMD(18);
+	cmd_desc.arg = block;
 	cmd_desc.response_len = R1_LEN;
 	if (0 != send_command(sd_desc, &cmd_desc))
 		return -1;
@@ -419,82 +446,529 @@ int32_t sd_read(struct sd_desc *sd_desc,
 		return -1;
 	}
 
-	/* Read blocks */
-	if (0 != read_multiple_blocks(sd_desc, data, address, len))
-		return -1;
+	return 0;
+}
+
+/**
+ * End a read started with start_read
+ * @param sd_desc	- Instance of the SD card
+ * @param nb_of_blocks	- Number of blocks passed to start_read
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t stop_read(struct sd_desc *sd_desc, uint32_t nb_of_blocks)
+{
+	struct cmd_desc	cmd_desc;
 
 	/* Send stop transmission command */
-	if (get_nb_of_blocks(address, len) != 1) {
-		cmd_desc.cmd = CMD(12);
-		cmd_desc.arg = STUFF_ARG;
-		cmd_desc.response_len = R1_LEN;
-		if (0 != send_command(sd_desc, &cmd_desc))
-			return -1;
-		if (cmd_desc.response[0] != R1_READY_STATE) {
-			DEBUG_MSG("Failed to send stop transmission command\n");
-			return -1;
-		}
+	if (nb_of_blocks == 1)
+		return 0;
+
+	cmd_desc.cmd = CMD(12);
+	cmd_desc.arg = STUFF_ARG;
+	cmd_desc.response_len = R1_LEN;
+	if (0 != send_command(sd_desc, &cmd_desc))
+		return -1;
+	if (cmd_desc.response[0] != R1_READY_STATE) {
+		DEBUG_MSG("Failed to send stop transmission command\n");
+		return -1;
 	}
 
 	return 0;
 }
 
 /**
- * Write data of size len to the specified address
- * This operation returns only when the write is complete
+ * Send the command that starts a write of one or more blocks
+ * @param sd_desc	- Instance of the SD card
+ * @param block		- First block to be written
+ * @param nb_of_blocks	- Number of blocks to be written, 0 if not known
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t start_write(struct sd_desc *sd_desc, uint64_t block,
+			   uint32_t nb_of_blocks)
+{
+	struct cmd_desc	cmd_desc;
+
+	cmd_desc.cmd = (nb_of_blocks == 1) ? CMD(24) : CMD(25);
+	cmd_desc.arg = block;
+	cmd_desc.response_len = R1_LEN;
+	if (0 != send_command(sd_desc, &cmd_desc))
+		return -1;
+	if (cmd_desc.response[0] != R1_READY_STATE) {
+		DEBUG_MSG("Failed to write Data command\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * End a write started with start_write
+ * @param sd_desc	- Instance of the SD card
+ * @param nb_of_blocks	- Number of blocks passed to start_write
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t stop_write(struct sd_desc *sd_desc, uint32_t nb_of_blocks)
+{
+	/* Send stop transmission token */
+	if (nb_of_blocks == 1)
+		return 0;
+
+	sd_desc->buff[0] = STOP_TRANSMISSION_TOKEN;
+	sd_desc->buff[1] = 0xFF;
+	if (0 != no_os_spi_write_and_read(sd_desc->spi_desc, sd_desc->buff, 2))
+		return -1;
+
+	return wait_until_not_busy(sd_desc);
+}
+
+/**
+ * Read data from the card, without going through the cache
+ * @param sd_desc	- Instance of the SD card
+ * @param data		- Where data will be read
+ * @param address	- Address in memory from where data will be read
+ * @param len		- Length in bytes of data to be read
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t raw_read(struct sd_desc *sd_desc,
+			uint8_t *data, uint64_t address, uint64_t len)
+{
+	uint32_t	nb_of_blocks = get_nb_of_blocks(address, len);
+
+	if (0 != start_read(sd_desc, address >> DATA_BLOCK_BITS, nb_of_blocks))
+		return -1;
+
+	if (0 != read_multiple_blocks(sd_desc, data, address, len))
+		return -1;
+
+	return stop_read(sd_desc, nb_of_blocks);
+}
+
+/**
+ * Write data to the card, without going through the cache
  * @param sd_desc	- Instance of the SD card
  * @param data		- Data to write
  * @param address	- Address in memory where data will be written
  * @param len		- Length of data in bytes
  * @return 0 in case of success, -1 otherwise.
  */
-int32_t sd_write(struct sd_desc *sd_desc, uint8_t *data, uint64_t address,
-		 uint64_t len)
+static int32_t raw_write(struct sd_desc *sd_desc, uint8_t *data,
+			 uint64_t address, uint64_t len)
 {
-	struct cmd_desc	cmd_desc;
 	uint8_t		first_block[DATA_BLOCK_LEN] __attribute__((aligned));
 	uint8_t		last_block[DATA_BLOCK_LEN] __attribute__((aligned));
-
-	/* Initial checks */
-	if (data == NULL || address > sd_desc->memory_size ||
-	    len > sd_desc->memory_size || address + len > sd_desc->memory_size)
-		return -1;
+	uint32_t	nb_of_blocks = get_nb_of_blocks(address, len);
 
 	/* Read first and last block in memory if needed to be updated with user data and then written back                                                                        */
 	/* If not writing from the beginning of a block or */
 	if ((address & MASK_ADDR_IN_BLOCK) != 0 ||
 	    /* If writing from the beginning but not the full block */
 	    ((address & MASK_ADDR_IN_BLOCK) == 0 && len < DATA_BLOCK_LEN))
-		sd_read(sd_desc, first_block, address & MASK_BLOCK_NUMBER, DATA_BLOCK_LEN);
+		raw_read(sd_desc, first_block, address & MASK_BLOCK_NUMBER, DATA_BLOCK_LEN);
 	/* If the last block is different from the first and */
 	if (((address + len - 1) & MASK_BLOCK_NUMBER) != (address & MASK_BLOCK_NUMBER)
 	    /* If reading less than the full block */
 	    && ((address + len - 1) & MASK_ADDR_IN_BLOCK) != MASK_ADDR_IN_BLOCK)
-		sd_read(sd_desc, last_block, (address + len - 1) & MASK_BLOCK_NUMBER,
-			DATA_BLOCK_LEN);
+		raw_read(sd_desc, last_block, (address + len - 1) & MASK_BLOCK_NUMBER,
+			 DATA_BLOCK_LEN);
 
 	/* Send write command to SD */
-	cmd_desc.cmd = (get_nb_of_blocks(address, len) == 1) ? CMD(24) : CMD(25);
-	cmd_desc.arg = address >> DATA_BLOCK_BITS; //Address of first block
-	cmd_desc.response_len = R1_LEN;
-	if (0 != send_command(sd_desc, &cmd_desc))
-		return -1;
-	if (cmd_desc.response[0] != R1_READY_STATE) {
-		DEBUG_MSG("Failed to write Data command\n");
+	if (0 != start_write(sd_desc, address >> DATA_BLOCK_BITS, nb_of_blocks))
 		return -1;
-	}
 
 	/* Write blocks */
 	if (0 != write_multiple_blocks(sd_desc, data, address, len,
 				       first_block, last_block))
 		return -1;
 
-	/* Send stop transmission token */
-	if (get_nb_of_blocks(address, len) != 1) {
-		sd_desc->buff[0] = STOP_TRANSMISSION_TOKEN;
-		sd_desc->buff[1] = 0xFF;
-		if (0 != no_os_spi_write_and_read(sd_desc->spi_desc, sd_desc->buff, 2))
+	return stop_write(sd_desc, nb_of_blocks);
+}
+
+/**
+ * Find the cache line holding a block
+ * @param sd_desc	- Instance of the SD card
+ * @param block		- Block number
+ * @return The cache line or NULL if the block is not cached.
+ */
+static struct sd_cache_line *cache_find(struct sd_desc *sd_desc,
+					uint64_t block)
+{
+	struct sd_cache	*cache = &sd_desc->cache;
+	uint32_t	i;
+
+	for (i = 0; i < cache->nb_lines; i++)
+		if (cache->lines[i].valid && cache->lines[i].block == block)
+			return &cache->lines[i];
+
+	return NULL;
+}
+
+/**
+ * Mark a cache line as the most recently used one
+ * @param sd_desc	- Instance of the SD card
+ * @param line		- Cache line
+ */
+static inline void cache_touch(struct sd_desc *sd_desc,
+			       struct sd_cache_line *line)
+{
+	line->last_use = ++sd_desc->cache.use_cnt;
+}
+
+/**
+ * Write all the dirty cache lines to the card. Lines holding consecutive
+ * blocks are written with a single multiple block write.
+ * @param sd_desc	- Instance of the SD card
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t cache_flush(struct sd_desc *sd_desc)
+{
+	struct sd_cache		*cache = &sd_desc->cache;
+	struct sd_cache_line	*first;
+	struct sd_cache_line	*line;
+	uint32_t		nb_of_blocks;
+	uint32_t		i;
+
+	while (true) {
+		/* Start from the lowest dirty block */
+		first = NULL;
+		for (i = 0; i < cache->nb_lines; i++) {
+			line = &cache->lines[i];
+			if (line->valid && line->dirty &&
+			    (!first || line->block < first->block))
+				first = line;
+		}
+		if (!first)
+			return 0;
+
+		nb_of_blocks = 1;
+		while ((line = cache_find(sd_desc, first->block + nb_of_blocks)) &&
+		       line->dirty)
+			nb_of_blocks++;
+
+		if (0 != start_write(sd_desc, first->block, nb_of_blocks))
+			return -1;
+		for (i = 0; i < nb_of_blocks; i++) {
+			line = cache_find(sd_desc, first->block + i);
+			if (0 != write_block(sd_desc, line->data, nb_of_blocks))
+				return -1;
+			line->dirty = false;
+		}
+		if (0 != stop_write(sd_desc, nb_of_blocks))
+			return -1;
+	}
+}
+
+/**
+ * Get a free cache line, evicting the least recently used one if needed.
+ * If the evicted line is dirty, all the dirty lines are written back.
+ * @param sd_desc	- Instance of the SD card
+ * @return A line marked as invalid or NULL in case of error.
+ */
+static struct sd_cache_line *cache_evict(struct sd_desc *sd_desc)
+{
+	struct sd_cache		*cache = &sd_desc->cache;
+	struct sd_cache_line	*victim;
+	struct sd_cache_line	*line;
+	uint32_t		i;
+
+	victim = NULL;
+	for (i = 0; i < cache->nb_lines; i++) {
+		line = &cache->lines[i];
+		if (!line->valid) {
+			victim = line;
+			break;
+		}
+		if (!victim || cache->use_cnt - line->last_use >
+		    cache->use_cnt - victim->last_use)
+			victim = line;
+	}
+
+	if (victim->valid && victim->dirty)
+		if (0 != cache_flush(sd_desc))
+			return NULL;
+
+	victim->valid = false;
+
+	return victim;
+}
+
+/**
+ * Read consecutive blocks, none of them cached, into the cache with a single
+ * read command
+ * @param sd_desc	- Instance of the SD card
+ * @param block		- First block to be read
+ * @param nb_of_blocks	- Number of blocks, at most the number of cache lines
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t cache_fill(struct sd_desc *sd_desc, uint64_t block,
+			  uint32_t nb_of_blocks)
+{
+	struct sd_cache_line	*line;
+	uint32_t		i;
+
+	/* Reserve the lines first, evictions may need to write to the card */
+	for (i = 0; i < nb_of_blocks; i++) {
+		line = cache_evict(sd_desc);
+		if (!line)
+			goto error;
+		line->block = block + i;
+		line->valid = true;
+		line->dirty = false;
+		cache_touch(sd_desc, line);
+	}
+
+	if (0 != start_read(sd_desc, block, nb_of_blocks))
+		goto error;
+	for (i = 0; i < nb_of_blocks; i++)
+		if (0 != read_block(sd_desc, cache_find(sd_desc, block + i)->data))
+			goto error;
+	if (0 != stop_read(sd_desc, nb_of_blocks))
+		goto error;
+
+	return 0;
+error:
+	for (i = 0; i < nb_of_blocks; i++) {
+		line = cache_find(sd_desc, block + i);
+		if (line)
+			line->valid = false;
+	}
+
+	return -1;
+}
+
+/**
+ * Read data through the cache. On a miss, the missing blocks are read with
+ * one command, extended with the readahead blocks if the access continues
+ * the previous one.
+ * @param sd_desc	- Instance of the SD card
+ * @param data		- Where data will be read
+ * @param address	- Address in memory from where data will be read
+ * @param len		- Length in bytes of data to be read
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t cache_read(struct sd_desc *sd_desc,
+			  uint8_t *data, uint64_t address, uint64_t len)
+{
+	struct sd_cache		*cache = &sd_desc->cache;
+	struct sd_cache_line	*line;
+	uint64_t		block = address >> DATA_BLOCK_BITS;
+	uint64_t		last_block = (address + len - 1) >> DATA_BLOCK_BITS;
+	uint64_t		limit;
+	uint32_t		offset = address & MASK_ADDR_IN_BLOCK;
+	uint32_t		copy_len;
+	uint32_t		nb_of_blocks;
+
+	for (; block <= last_block; block++) {
+		line = cache_find(sd_desc, block);
+		if (!line) {
+			limit = last_block - block + 1;
+			if (address >> DATA_BLOCK_BITS == cache->next_block)
+				limit += cache->readahead;
+			limit = no_os_min(limit, (uint64_t)cache->nb_lines);
+			limit = no_os_min(limit,
+					  (sd_desc->memory_size >> DATA_BLOCK_BITS) - block);
+
+			nb_of_blocks = 1;
+			while (nb_of_blocks < limit &&
+			       !cache_find(sd_desc, block + nb_of_blocks))
+				nb_of_blocks++;
+
+			if (0 != cache_fill(sd_desc, block, nb_of_blocks))
+				return -1;
+			line = cache_find(sd_desc, block);
+		}
+		cache_touch(sd_desc, line);
+
+		copy_len = no_os_min((uint64_t)DATA_BLOCK_LEN - offset, len);
+		memcpy(data, line->data + offset, copy_len);
+		data += copy_len;
+		len -= copy_len;
+		offset = 0;
+	}
+	cache->next_block = last_block + 1;
+
+	return 0;
+}
+
+/**
+ * Write data to the cache. Only partially written blocks that are not cached
+ * are read from the card.
+ * @param sd_desc	- Instance of the SD card
+ * @param data		- Data to write
+ * @param address	- Address in memory where data will be written
+ * @param len		- Length of data in bytes
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t cache_write(struct sd_desc *sd_desc, uint8_t *data,
+			   uint64_t address, uint64_t len)
+{
+	struct sd_cache_line	*line;
+	uint64_t		block = address >> DATA_BLOCK_BITS;
+	uint64_t		last_block = (address + len - 1) >> DATA_BLOCK_BITS;
+	uint32_t		offset = address & MASK_ADDR_IN_BLOCK;
+	uint32_t		copy_len;
+
+	for (; block <= last_block; block++) {
+		copy_len = no_os_min((uint64_t)DATA_BLOCK_LEN - offset, len);
+		line = cache_find(sd_desc, block);
+		if (!line) {
+			if (copy_len == DATA_BLOCK_LEN) {
+				line = cache_evict(sd_desc);
+				if (!line)
+					return -1;
+				line->block = block;
+				line->valid = true;
+			} else {
+				if (0 != cache_fill(sd_desc, block, 1))
+					return -1;
+				line = cache_find(sd_desc, block);
+			}
+		}
+		cache_touch(sd_desc, line);
+
+		memcpy(line->data + offset, data, copy_len);
+		line->dirty = true;
+		data += copy_len;
+		len -= copy_len;
+		offset = 0;
+	}
+
+	return 0;
+}
+
+/**
+ * Write back and drop all the cache lines
+ * @param sd_desc	- Instance of the SD card
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t cache_invalidate(struct sd_desc *sd_desc)
+{
+	uint32_t	i;
+
+	if (0 != cache_flush(sd_desc))
+		return -1;
+
+	for (i = 0; i < sd_desc->cache.nb_lines; i++)
+		sd_desc->cache.lines[i].valid = false;
+
+	return 0;
+}
+
+/**
+ * Read data of size len from the specified address and store it in data.
+ * This operation returns only when the read is complete.
+ * If the cache is enabled, reads not larger than the cache are served from it.
+ * @param sd_desc	- Instance of the SD card
+ * @param data		- Where data will be read
+ * @param address	- Address in memory from where data will be read
+ * @param len		- Length in bytes of data to be read
+ * @return 0 in case of success, -1 otherwise.
+ */
+int32_t sd_read(struct sd_desc *sd_desc,
+		uint8_t *data, uint64_t address, uint64_t len)
+{
+	/* Initial checks */
+	if (data == NULL || len == 0 || address > sd_desc->memory_size ||
+	    len > sd_desc->memory_size ||
+	    address + len > sd_desc->memory_size)
+		return -1;
+	if (sd_desc->stream.active)
+		return -1;
+
+	if (!sd_desc->cache.lines)
+		return raw_read(sd_desc, data, address, len);
+
+	if (get_nb_of_blocks(address, len) <= sd_desc->cache.nb_lines)
+		return cache_read(sd_desc, data, address, len);
+
+	/* Larger than the cache, make sure the card is up to date */
+	if (0 != cache_flush(sd_desc))
+		return -1;
+
+	return raw_read(sd_desc, data, address, len);
+}
+
+/**
+ * Write data of size len to the specified address.
+ * If the cache is enabled, writes not larger than the cache only update it
+ * and the data reaches the card on eviction or on sd_flush. Otherwise this
+ * operation returns only when the write is complete.
+ * @param sd_desc	- Instance of the SD card
+ * @param data		- Data to write
+ * @param address	- Address in memory where data will be written
+ * @param len		- Length of data in bytes
+ * @return 0 in case of success, -1 otherwise.
+ */
+int32_t sd_write(struct sd_desc *sd_desc, uint8_t *data, uint64_t address,
+		 uint64_t len)
+{
+	/* Initial checks */
+	if (data == NULL || len == 0 || address > sd_desc->memory_size ||
+	    len > sd_desc->memory_size || address + len > sd_desc->memory_size)
+		return -1;
+	if (sd_desc->stream.active)
+		return -1;
+
+	if (!sd_desc->cache.lines)
+		return raw_write(sd_desc, data, address, len);
+
+	if (get_nb_of_blocks(address, len) <= sd_desc->cache.nb_lines)
+		return cache_write(sd_desc, data, address, len);
+
+	/* Larger than the cache, bypass it */
+	if (0 != cache_invalidate(sd_desc))
+		return -1;
+
+	return raw_write(sd_desc, data, address, len);
+}
+
+/**
+ * Write all the modified cached blocks to the card.
+ * @param sd_desc	- Instance of the SD card
+ * @return 0 in case of success, -1 otherwise.
+ */
+int32_t sd_flush(struct sd_desc *sd_desc)
+{
+	if (!sd_desc || sd_desc->stream.active)
+		return -1;
+
+	if (!sd_desc->cache.lines)
+		return 0;
+
+	return cache_flush(sd_desc);
+}
+
+/**
+ * Callback of the DMA transfer of a stream data block
+ * @param ctx	- Instance of the SD card
+ */
+static void stream_xfer_done(void *ctx)
+{
+	struct sd_desc *sd_desc = ctx;
+
+	sd_desc->stream.xfer_pending = false;
+}
+
+/**
+ * Wait until the last data block of the stream is programmed
+ * @param sd_desc	- Instance of the SD card
+ * @return 0 in case of success, -1 otherwise.
+ */
+static int32_t stream_complete(struct sd_desc *sd_desc)
+{
+	struct sd_stream	*stream = &sd_desc->stream;
+
+	while (stream->xfer_pending)
+		;
+
+	if (stream->resp_pending) {
+		stream->resp_pending = false;
+		if (0 != read_data_response(sd_desc))
 			return -1;
+		stream->busy = true;
+	}
+
+	if (stream->busy) {
+		stream->busy = false;
 		if (0 != wait_until_not_busy(sd_desc))
 			return -1;
 	}
@@ -502,6 +976,188 @@ int32_t sd_write(struct sd_desc *sd_desc, uint8_t *data, uint64_t address,
 	return 0;
 }
 
+/**
+ * Start sending one data block of the stream. The card response and the
+ * programming of the block are handled by the next stream call.
+ * @param sd_desc	- Instance of the SD card
+ * @param data		- DATA_BLOCK_LEN bytes to be written
+ * @return 0 in case of success, negative error code otherwise.
+ */
+static int32_t stream_send(struct sd_desc *sd_desc, uint8_t *data)
+{
+	struct sd_stream	*stream = &sd_desc->stream;
+	int32_t			ret;
+
+	stream->token = START_N_BLOCK_TOKEN;
+	stream->crc[0] = 0xFF;
+	stream->crc[1] = 0xFF;
+	fill_data_block_msgs(stream->msgs, &stream->token, data, stream->crc);
+
+	if (stream->dma) {
+		stream->xfer_pending = true;
+		ret = no_os_spi_transfer_dma_async(sd_desc->spi_desc, stream->msgs,
+						   NO_OS_ARRAY_SIZE(stream->msgs),
+						   stream_xfer_done, sd_desc);
+		if (ret == 0) {
+			stream->resp_pending = true;
+			return 0;
+		}
+		stream->xfer_pending = false;
+		if (ret != -ENOSYS)
+			return ret;
+		/* The platform has no DMA support, keep going without it */
+		stream->dma = false;
+	}
+
+	ret = no_os_spi_transfer(sd_desc->spi_desc, stream->msgs,
+				 NO_OS_ARRAY_SIZE(stream->msgs));
+	if (ret)
+		return ret;
+	stream->resp_pending = true;
+
+	return 0;
+}
+
+/**
+ * Open a multiple block write that stays open across sd_stream_write calls.
+ * Dirty cached blocks are written back and the cache is dropped. sd_read,
+ * sd_write and sd_flush fail until sd_stream_stop is called.
+ * @param sd_desc	- Instance of the SD card
+ * @param address	- Address in memory, aligned to DATA_BLOCK_LEN
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int32_t sd_stream_start(struct sd_desc *sd_desc, uint64_t address)
+{
+	struct sd_stream	*stream;
+
+	if (!sd_desc || (address & MASK_ADDR_IN_BLOCK) ||
+	    address >= sd_desc->memory_size)
+		return -EINVAL;
+
+	stream = &sd_desc->stream;
+	if (stream->active)
+		return -EBUSY;
+
+	if (sd_desc->cache.lines && 0 != cache_invalidate(sd_desc))
+		return -EIO;
+
+	if (0 != start_write(sd_desc, address >> DATA_BLOCK_BITS, 0))
+		return -EIO;
+
+	stream->next_block = address >> DATA_BLOCK_BITS;
+	stream->xfer_pending = false;
+	stream->resp_pending = false;
+	stream->busy = false;
+	stream->active = true;
+
+	return 0;
+}
+
+/**
+ * Append data to the open stream. Each call waits only for the previously
+ * sent block and returns once the transfer of the last block of data has
+ * started, so data must not be modified until the next stream call or
+ * until sd_stream_ready reports the stream as ready.
+ * @param sd_desc	- Instance of the SD card
+ * @param data		- Data to write
+ * @param len		- Length of data in bytes, multiple of DATA_BLOCK_LEN
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int32_t sd_stream_write(struct sd_desc *sd_desc, uint8_t *data, uint64_t len)
+{
+	struct sd_stream	*stream;
+	uint64_t		nb_of_blocks;
+	uint64_t		i;
+	int32_t			ret;
+
+	if (!sd_desc || !data || !len || (len & MASK_ADDR_IN_BLOCK))
+		return -EINVAL;
+
+	stream = &sd_desc->stream;
+	if (!stream->active)
+		return -EINVAL;
+
+	nb_of_blocks = len >> DATA_BLOCK_BITS;
+	if (stream->next_block + nb_of_blocks >
+	    sd_desc->memory_size >> DATA_BLOCK_BITS)
+		return -ENOSPC;
+
+	for (i = 0; i < nb_of_blocks; i++) {
+		if (0 != stream_complete(sd_desc))
+			return -EIO;
+		ret = stream_send(sd_desc, data + (i << DATA_BLOCK_BITS));
+		if (ret)
+			return ret;
+		stream->next_block++;
+	}
+
+	return 0;
+}
+
+/**
+ * Check, without blocking, if the stream can accept new data right away
+ * @param sd_desc	- Instance of the SD card
+ * @param ready		- Set to false while the last block is still being
+ *			  transferred or programmed by the card
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int32_t sd_stream_ready(struct sd_desc *sd_desc, bool *ready)
+{
+	struct sd_stream	*stream;
+	uint8_t			data;
+
+	if (!sd_desc || !ready || !sd_desc->stream.active)
+		return -EINVAL;
+
+	stream = &sd_desc->stream;
+	*ready = false;
+
+	if (stream->xfer_pending)
+		return 0;
+
+	if (stream->resp_pending) {
+		stream->resp_pending = false;
+		if (0 != read_data_response(sd_desc))
+			return -EIO;
+		stream->busy = true;
+	}
+
+	if (stream->busy) {
+		data = 0xFF;
+		if (0 != no_os_spi_write_and_read(sd_desc->spi_desc, &data, 1))
+			return -EIO;
+		if (data == 0x00)
+			return 0;
+		stream->busy = false;
+	}
+
+	*ready = true;
+
+	return 0;
+}
+
+/**
+ * Wait for the last block of the stream and close the multiple block write.
+ * @param sd_desc	- Instance of the SD card
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int32_t sd_stream_stop(struct sd_desc *sd_desc)
+{
+	int32_t	ret;
+
+	if (!sd_desc || !sd_desc->stream.active)
+		return -EINVAL;
+
+	ret = stream_complete(sd_desc);
+	sd_desc->stream.active = false;
+
+	/* Always send the stop token so the card leaves the receive state */
+	if (0 != stop_write(sd_desc, 0) || ret)
+		return -EIO;
+
+	return 0;
+}
+
 /**
  * Initialize an instance of SD card and stores it to the parameter desc
  * @param sd_desc	- Pointer where to store the instance of the SD
@@ -606,24 +1262,57 @@ int32_t sd_init(struct sd_desc **sd_desc, const struct sd_init_param *param)
 	local_desc->memory_size = ((uint64_t)c_size + 1) *
 				  ((uint64_t)DATA_BLOCK_LEN << 10u);
 
+	/* Allocate the block cache */
+	if (param->cache_blocks) {
+		uint8_t *cache_data;
+
+		local_desc->cache.lines = no_os_calloc(param->cache_blocks,
+						       sizeof(*local_desc->cache.lines));
+		if (!local_desc->cache.lines)
+			goto failure;
+		cache_data = no_os_calloc(param->cache_blocks, DATA_BLOCK_LEN);
+		if (!cache_data)
+			goto failure;
+		for (i = 0; i < param->cache_blocks; i++)
+			local_desc->cache.lines[i].data = cache_data + i * DATA_BLOCK_LEN;
+		local_desc->cache.nb_lines = param->cache_blocks;
+		local_desc->cache.readahead = no_os_min(param->readahead_blocks,
+							param->cache_blocks);
+	}
+	local_desc->stream.dma = param->stream_dma;
+
 	*sd_desc = local_desc;
 
 	return 0;
 failure:
+	no_os_free(local_desc->cache.lines);
 	no_os_free(local_desc);
 	return -1;
 }
 
 /**
  * Remove the initialize instance of SD card.
+ * An open stream is stopped and the cache is written back first.
  * @param desc	- Instance of the SD card
  * @return 0 in case of success, -1 otherwise.
  */
 int32_t sd_remove(struct sd_desc *desc)
 {
+	int32_t	ret = 0;
+
 	if (desc == NULL)
 		return -1;
 
+	/* Don't lose data still held by the driver */
+	if (desc->stream.active && 0 != sd_stream_stop(desc))
+		ret = -1;
+	if (desc->cache.lines) {
+		if (0 != cache_flush(desc))
+			ret = -1;
+		no_os_free(desc->cache.lines[0].data);
+		no_os_free(desc->cache.lines);
+	}
+
 	no_os_free(desc);
-	return 0;
+	return ret;
 }
@@ -67,6 +67,77 @@
 struct sd_init_param {
 	/** Descriptor of an initialized SPI channel */
 	struct no_os_spi_desc *spi_desc;
+	/**
+	 * Number of data blocks kept in the write-back cache. 0 disables the
+	 * cache and every access goes straight to the card.
+	 */
+	uint32_t	cache_blocks;
+	/**
+	 * Number of blocks read in advance when sequential reads are detected.
+	 * Limited to cache_blocks.
+	 */
+	uint32_t	readahead_blocks;
+	/** Send the data blocks of a stream with no_os_spi_transfer_dma_async */
+	bool		stream_dma;
+};
+
+/**
+ * @struct sd_cache_line
+ * @brief One data block held in the cache
+ */
+struct sd_cache_line {
+	/** Data block number on the card */
+	uint64_t	block;
+	/** Value of the access counter on the last use, for LRU eviction */
+	uint32_t	last_use;
+	/** Set when data holds the content of block */
+	bool		valid;
+	/** Set when data was modified and is not written to the card yet */
+	bool		dirty;
+	/** DATA_BLOCK_LEN bytes of block data */
+	uint8_t		*data;
+};
+
+/**
+ * @struct sd_cache
+ * @brief Write-back block cache
+ */
+struct sd_cache {
+	/** Cache lines, NULL if the cache is disabled */
+	struct sd_cache_line	*lines;
+	/** Number of cache lines */
+	uint32_t		nb_lines;
+	/** Number of blocks read in advance on sequential reads */
+	uint32_t		readahead;
+	/** Block following the last read access */
+	uint64_t		next_block;
+	/** Access counter */
+	uint32_t		use_cnt;
+};
+
+/**
+ * @struct sd_stream
+ * @brief State of a multiple block write kept open across calls
+ */
+struct sd_stream {
+	/** Set between sd_stream_start and sd_stream_stop */
+	bool			active;
+	/** Use DMA for the data blocks */
+	bool			dma;
+	/** Set while the DMA transfer of a data block is running */
+	volatile bool		xfer_pending;
+	/** Set when the data response of the last block was not read yet */
+	bool			resp_pending;
+	/** Set when the card may still be programming the last block */
+	bool			busy;
+	/** Next block to be written */
+	uint64_t		next_block;
+	/** Start block token, must outlive the DMA transfer */
+	uint8_t			token;
+	/** Dummy CRC, must outlive the DMA transfer */
+	uint8_t			crc[2];
+	/** Messages of the running DMA transfer */
+	struct no_os_spi_msg	msgs[3];
 };
 
 /**
@@ -82,6 +153,10 @@ struct sd_desc {
 	uint8_t		high_capacity;
 	/** Buffer used for the driver implementation */
 	uint8_t		buff[18];
+	/** Block cache */
+	struct sd_cache		cache;
+	/** Open multiple block write */
+	struct sd_stream	stream;
 };
 
 /**
@@ -110,6 +185,11 @@ int32_t sd_write(struct sd_desc *desc,
 		 uint8_t *data,
 		 uint64_t address,
 		 uint64_t len);
+int32_t sd_flush(struct sd_desc *desc);
+int32_t sd_stream_start(struct sd_desc *desc, uint64_t address);
+int32_t sd_stream_write(struct sd_desc *desc, uint8_t *data, uint64_t len);
+int32_t sd_stream_ready(struct sd_desc *desc, bool *ready);
+int32_t sd_stream_stop(struct sd_desc *desc);
 
 #endif /* __SD_H__ */
 
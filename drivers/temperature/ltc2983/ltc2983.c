@@ -32,6 +32,7 @@
 *******************************************************************************/
 
 #include <errno.h>
+#include <string.h>
 #include "ltc2983.h"
 #include "no_os_alloc.h"
 #include "no_os_delay.h"
@@ -39,6 +40,68 @@
 
 /******************************************************************************/
 
+/* Only the configuration registers are cached, the status register and the
+ * conversion results are volatile and the channel assignment and custom
+ * sensor data are written with raw SPI transfers. */
+static const struct no_os_regmap_range ltc2983_regmap_ranges[] = {
+	{
+		.first = LTC2983_GLOBAL_CONFIG_REG,
+		.last = LTC2983_GLOBAL_CONFIG_REG,
+		.policy = NO_OS_REGMAP_CACHEABLE,
+	},
+	{
+		.first = LTC2983_MUX_CONFIG_REG,
+		.last = LTC2983_MUX_CONFIG_REG,
+		.policy = NO_OS_REGMAP_CACHEABLE,
+	},
+};
+
+/**
+ * @brief Read a register from the device, used by the register map
+ * @param ctx - LTC2983 descriptor
+ * @param reg - register address
+ * @param val - register value
+ * @return 0 in case of success, negative error code otherwise
+ */
+static int ltc2983_spi_reg_read(void *ctx, uint32_t reg, uint32_t *val)
+{
+	struct ltc2983_desc *device = ctx;
+	int ret;
+	uint8_t raw_array[4];
+
+	raw_array[0] = LTC2983_SPI_READ_BYTE;
+	no_os_put_unaligned_be16(reg, raw_array + 1);
+	raw_array[3] = 0;
+
+	ret = no_os_spi_write_and_read(device->comm_desc, raw_array,
+				       NO_OS_ARRAY_SIZE(raw_array));
+	if (ret)
+		return ret;
+	*val = raw_array[3];
+
+	return 0;
+}
+
+/**
+ * @brief Write a register to the device, used by the register map
+ * @param ctx - LTC2983 descriptor
+ * @param reg - register address
+ * @param val - register value
+ * @return 0 in case of success, negative error code otherwise
+ */
+static int ltc2983_spi_reg_write(void *ctx, uint32_t reg, uint32_t val)
+{
+	struct ltc2983_desc *device = ctx;
+	uint8_t raw_array[4];
+
+	raw_array[0] = LTC2983_SPI_WRITE_BYTE;
+	no_os_put_unaligned_be16(reg, raw_array + 1);
+	raw_array[3] = val;
+
+	return no_os_spi_write_and_read(device->comm_desc, raw_array,
+					NO_OS_ARRAY_SIZE(raw_array));
+}
+
 /**
  * @brief Device and comm init function
  * @param device - LTC2983 descriptor to be initialized
@@ -50,6 +113,12 @@ int ltc2983_init(struct ltc2983_desc **device,
 {
 	int ret, i;
 	struct ltc2983_desc *descriptor;
+	struct no_os_regmap_init_param regmap_param = {
+		.reg_read = ltc2983_spi_reg_read,
+		.reg_write = ltc2983_spi_reg_write,
+		.ranges = ltc2983_regmap_ranges,
+		.nb_ranges = NO_OS_ARRAY_SIZE(ltc2983_regmap_ranges),
+	};
 
 	descriptor = no_os_calloc(1, sizeof(*descriptor));
 	if (!descriptor)
@@ -84,10 +153,15 @@ int ltc2983_init(struct ltc2983_desc **device,
 	if (!descriptor->num_channels) // should be at least one channel
 		goto spi_err;
 
+	regmap_param.ctx = descriptor;
+	ret = no_os_regmap_init(&descriptor->regmap, &regmap_param);
+	if (ret)
+		goto spi_err;
+
 	ret = no_os_gpio_get_optional(&descriptor->gpio_rstn,
 				      &init_param->gpio_rstn);
 	if (ret)
-		goto spi_err;
+		goto regmap_err;
 	ret = no_os_gpio_direction_output(descriptor->gpio_rstn,
 					  NO_OS_GPIO_LOW);
 	if (ret)
@@ -99,15 +173,27 @@ int ltc2983_init(struct ltc2983_desc **device,
 	if (ret)
 		goto gpio_err;
 
-	ret = ltc2983_setup(descriptor);
+	ret = no_os_gpio_get_optional(&descriptor->gpio_int,
+				      init_param->gpio_int);
 	if (ret)
 		goto gpio_err;
+	ret = no_os_gpio_direction_input(descriptor->gpio_int);
+	if (ret)
+		goto gpio_int_err;
+
+	ret = ltc2983_setup(descriptor);
+	if (ret)
+		goto gpio_int_err;
 
 	*device = descriptor;
 	return 0;
 
+gpio_int_err:
+	no_os_gpio_remove(descriptor->gpio_int);
 gpio_err:
 	no_os_gpio_remove(descriptor->gpio_rstn);
+regmap_err:
+	no_os_regmap_remove(descriptor->regmap);
 spi_err:
 	no_os_spi_remove(descriptor->comm_desc);
 free_err:
@@ -130,17 +216,23 @@ int ltc2983_remove(struct ltc2983_desc *device)
 	if (ret)
 		return -EINVAL;
 
+	ret = no_os_gpio_remove(device->gpio_int);
+	if (ret)
+		return -EINVAL;
+
 	ret = no_os_spi_remove(device->comm_desc);
 	if (ret)
 		return -EINVAL;
 
+	no_os_regmap_remove(device->regmap);
 	no_os_free(device);
 
 	return 0;
 }
 
 /**
- * @brief Read raw register value
+ * @brief Read register value. Configuration registers are read from the
+ * register map cache.
  * @param device - LTC2983 descriptor
  * @param reg_addr - register address
  * @param val - register value
@@ -150,23 +242,19 @@ int ltc2983_reg_read(struct ltc2983_desc *device, uint16_t reg_addr,
 		     uint8_t *val)
 {
 	int ret;
-	uint8_t raw_array[4];
-
-	raw_array[0] = LTC2983_SPI_READ_BYTE;
-	no_os_put_unaligned_be16(reg_addr, raw_array + 1);
-	raw_array[3] = 0;
+	uint32_t data;
 
-	ret = no_os_spi_write_and_read(device->comm_desc, raw_array,
-				       NO_OS_ARRAY_SIZE(raw_array));
+	ret = no_os_regmap_read(device->regmap, reg_addr, &data);
 	if (ret)
 		return ret;
-	*val = raw_array[3];
+	*val = data;
 
 	return 0;
 }
 
 /**
- * @brief Write raw register value
+ * @brief Write register value. Writing a configuration register with the
+ * value it already holds doesn't access the bus.
  * @param device - LTC2983 descriptor
  * @param reg_addr - register address
  * @param val - register value
@@ -175,19 +263,7 @@ int ltc2983_reg_read(struct ltc2983_desc *device, uint16_t reg_addr,
 int ltc2983_reg_write(struct ltc2983_desc *device, uint16_t reg_addr,
 		      uint8_t val)
 {
-	int ret;
-	uint8_t raw_array[4];
-
-	raw_array[0] = LTC2983_SPI_WRITE_BYTE;
-	no_os_put_unaligned_be16(reg_addr, raw_array + 1);
-	raw_array[3] = val;
-
-	ret = no_os_spi_write_and_read(device->comm_desc, raw_array,
-				       NO_OS_ARRAY_SIZE(raw_array));
-	if (ret)
-		return ret;
-
-	return 0;
+	return no_os_regmap_write(device->regmap, reg_addr, val);
 }
 
 /**
@@ -201,16 +277,8 @@ int ltc2983_reg_write(struct ltc2983_desc *device, uint16_t reg_addr,
 int ltc2983_reg_update_bits(struct ltc2983_desc *device, uint16_t reg_addr,
 			    uint8_t mask, uint8_t val)
 {
-	int ret;
-	uint8_t data;
-
-	ret = ltc2983_reg_read(device, reg_addr, &data);
-	if (ret)
-		return ret;
-
-	data = (data & ~mask) | no_os_field_prep(mask, val);
-
-	return ltc2983_reg_write(device, reg_addr, data);
+	return no_os_regmap_update_bits(device->regmap, reg_addr, mask,
+					no_os_field_prep(mask, val));
 }
 
 /**
@@ -319,7 +387,7 @@ int ltc2983_chan_read(struct ltc2983_desc *device, const int chan, int *val)
 	uint32_t raw_val, scale_val, scale_val2;
 	int ret;
 
-	if (device->sensors[chan]->type == LTC2983_RSENSE) {
+	if (device->sensors[chan - 1]->type == LTC2983_RSENSE) {
 		*val = -1;
 		return 0;
 	}
@@ -337,6 +405,90 @@ int ltc2983_chan_read(struct ltc2983_desc *device, const int chan, int *val)
 	return 0;
 }
 
+/**
+ * @brief Check if a conversion is done
+ * @param device - LTC2983 descriptor
+ * @param done - set to true if the last started conversion is done
+ * @return 0 in case of success, errno errors otherwise
+ */
+int ltc2983_conv_done(struct ltc2983_desc *device, bool *done)
+{
+	uint8_t status;
+	uint8_t value;
+	int ret;
+
+	/* INTERRUPT goes low when a conversion starts and high when it ends */
+	if (device->gpio_int) {
+		ret = no_os_gpio_get_value(device->gpio_int, &value);
+		if (ret)
+			return ret;
+
+		*done = value == NO_OS_GPIO_HIGH;
+
+		return 0;
+	}
+
+	ret = ltc2983_reg_read(device, LTC2983_STATUS_REG, &status);
+	if (ret)
+		return ret;
+
+	*done = LTC2983_STATUS_UP(status) == 1;
+
+	return 0;
+}
+
+/**
+ * @brief Wait for the end of a conversion
+ * @param device - LTC2983 descriptor
+ * @param timeout_ms - maximum time to wait
+ * @return 0 in case of success, errno errors otherwise
+ */
+static int ltc2983_wait_conv(struct ltc2983_desc *device, uint32_t timeout_ms)
+{
+	bool done;
+	int ret;
+
+	do {
+		ret = ltc2983_conv_done(device, &done);
+		if (ret)
+			return ret;
+		if (done)
+			return 0;
+		no_os_mdelay(1);
+	} while (timeout_ms--);
+
+	return -ETIMEDOUT;
+}
+
+/**
+ * @brief Check and decode a conversion result
+ * @param device - LTC2983 descriptor
+ * @param chan - channel number
+ * @param val - conversion result, replaced by the raw channel data
+ * @return 0 in case of success, errno errors otherwise
+ */
+static int ltc2983_chan_result(struct ltc2983_desc *device, const int chan,
+			       uint32_t *val)
+{
+	int ret;
+
+	if (!(LTC2983_RES_VALID_MASK & *val)) {
+		pr_err("Channel %d: Invalid conversion detected\r\n", chan);
+		return -EIO;
+	}
+
+	if (device->sensors[chan - 1]->type <= LTC2983_THERMOCOUPLE_CUSTOM)
+		ret = ltc2983_thermocouple_fault_handler(*val);
+	else
+		ret = ltc2983_common_fault_handler(*val);
+	if (ret)
+		return ret;
+
+	*val = no_os_sign_extend32((*val) & LTC2983_DATA_MASK,
+				   LTC2983_DATA_SIGN_BIT);
+	return 0;
+}
+
 /**
  * @brief Read raw channel data / temperature
  * @param device - LTC2983 descriptor
@@ -351,6 +503,10 @@ int ltc2983_chan_read_raw(struct ltc2983_desc *device, const int chan,
 	uint8_t raw_array[7];
 	int ret;
 
+	if (chan < 1 || chan > device->max_channels_nr ||
+	    !device->sensors[chan - 1])
+		return -EINVAL;
+
 	start_conversion = LTC2983_STATUS_START(true);
 	start_conversion |= LTC2983_STATUS_CHAN_SEL(chan);
 	/* start conversion */
@@ -358,7 +514,9 @@ int ltc2983_chan_read_raw(struct ltc2983_desc *device, const int chan,
 	if (ret)
 		return ret;
 
-	no_os_mdelay(300);
+	ret = ltc2983_wait_conv(device, LTC2983_CONV_TIMEOUT_MS);
+	if (ret)
+		return ret;
 
 	/* read the converted data */
 	raw_array[0] = LTC2983_SPI_READ_BYTE;
@@ -371,21 +529,137 @@ int ltc2983_chan_read_raw(struct ltc2983_desc *device, const int chan,
 
 	*val = no_os_get_unaligned_be32(raw_array + 3);
 
-	if (!(LTC2983_RES_VALID_MASK & *val)) {
-		pr_err("Channel %d: Invalid conversion detected\r\n", chan);
-		return -EIO;
+	return ltc2983_chan_result(device, chan, val);
+}
+
+/**
+ * @brief Get the scan mask of all channels that can be converted
+ * @param device - LTC2983 descriptor
+ * @return mask with LTC2983_CHAN_MASK(chan) set for every assigned channel
+ * other than sense resistors
+ */
+uint32_t ltc2983_scan_mask(struct ltc2983_desc *device)
+{
+	uint32_t mask = 0;
+	int i;
+
+	for (i = 0; i < device->max_channels_nr; i++)
+		if (device->sensors[i] &&
+		    device->sensors[i]->type != LTC2983_RSENSE)
+			mask |= LTC2983_CHAN_MASK(i + 1);
+
+	return mask;
+}
+
+/**
+ * @brief Start a conversion of multiple channels
+ *
+ * The channels are converted one after the other by the device. Completion
+ * can be checked with ltc2983_conv_done().
+ * @param device - LTC2983 descriptor
+ * @param chan_mask - channels to be converted, see LTC2983_CHAN_MASK()
+ * @return 0 in case of success, errno errors otherwise
+ */
+int ltc2983_scan_start(struct ltc2983_desc *device, uint32_t chan_mask)
+{
+	uint8_t raw_array[7];
+	int ret;
+
+	if (!chan_mask || (chan_mask & ~ltc2983_scan_mask(device)))
+		return -EINVAL;
+
+	raw_array[0] = LTC2983_SPI_WRITE_BYTE;
+	no_os_put_unaligned_be16(LTC2983_MULT_CHANNEL_START_REG, raw_array + 1);
+	no_os_put_unaligned_be32(chan_mask, raw_array + 3);
+	ret = no_os_spi_write_and_read(device->comm_desc, raw_array,
+				       NO_OS_ARRAY_SIZE(raw_array));
+	if (ret)
+		return ret;
+
+	/* a start with channel 0 selects the multiple channel mask */
+	return ltc2983_reg_write(device, LTC2983_STATUS_REG,
+				 LTC2983_STATUS_START(true));
+}
+
+/**
+ * @brief Read the results of a multiple channel conversion
+ *
+ * All result registers from the first to the last channel in chan_mask are
+ * read in a single SPI transfer.
+ * @param device - LTC2983 descriptor
+ * @param chan_mask - channels to be read, see LTC2983_CHAN_MASK()
+ * @param vals - raw data, vals[chan - 1] is set for every channel in
+ * chan_mask. Channels with a fault are set to 0.
+ * @param fault_mask - optional, set to the channels with a fault
+ * @return 0 in case of success, -EIO if any channel has a fault, errno
+ * errors otherwise
+ */
+int ltc2983_scan_read(struct ltc2983_desc *device, uint32_t chan_mask,
+		      uint32_t *vals, uint32_t *fault_mask)
+{
+	uint8_t raw_array[3 + 4 * NO_OS_ARRAY_SIZE(device->sensors)];
+	uint32_t first, last, faults = 0;
+	uint8_t *res;
+	uint32_t chan;
+	int ret;
+
+	if (!chan_mask || (chan_mask & ~ltc2983_scan_mask(device)))
+		return -EINVAL;
+
+	first = no_os_find_first_set_bit(chan_mask) + 1;
+	last = no_os_find_last_set_bit(chan_mask) + 1;
+
+	raw_array[0] = LTC2983_SPI_READ_BYTE;
+	no_os_put_unaligned_be16(LTC2983_CHAN_RES_ADDR(first), raw_array + 1);
+	memset(raw_array + 3, 0, 4 * (last - first + 1));
+	ret = no_os_spi_write_and_read(device->comm_desc, raw_array,
+				       3 + 4 * (last - first + 1));
+	if (ret)
+		return ret;
+
+	for (chan = first; chan <= last; chan++) {
+		if (!(chan_mask & LTC2983_CHAN_MASK(chan)))
+			continue;
+
+		res = raw_array + 3 + 4 * (chan - first);
+		vals[chan - 1] = no_os_get_unaligned_be32(res);
+		ret = ltc2983_chan_result(device, chan, &vals[chan - 1]);
+		if (ret) {
+			vals[chan - 1] = 0;
+			faults |= LTC2983_CHAN_MASK(chan);
+		}
 	}
 
-	if (device->sensors[chan]->type <= LTC2983_THERMOCOUPLE_CUSTOM)
-		ret = ltc2983_thermocouple_fault_handler(*val);
-	else
-		ret = ltc2983_common_fault_handler(*val);
+	if (fault_mask)
+		*fault_mask = faults;
+
+	return faults ? -EIO : 0;
+}
+
+/**
+ * @brief Convert multiple channels and read the results
+ * @param device - LTC2983 descriptor
+ * @param chan_mask - channels to be converted, see LTC2983_CHAN_MASK()
+ * @param vals - raw data, see ltc2983_scan_read()
+ * @param fault_mask - optional, set to the channels with a fault
+ * @return 0 in case of success, -EIO if any channel has a fault, errno
+ * errors otherwise
+ */
+int ltc2983_scan(struct ltc2983_desc *device, uint32_t chan_mask,
+		 uint32_t *vals, uint32_t *fault_mask)
+{
+	int ret;
+
+	ret = ltc2983_scan_start(device, chan_mask);
 	if (ret)
 		return ret;
 
-	*val = no_os_sign_extend32((*val) & LTC2983_DATA_MASK,
-				   LTC2983_DATA_SIGN_BIT);
-	return 0;
+	ret = ltc2983_wait_conv(device, LTC2983_CONV_TIMEOUT_MS *
+				no_os_hweight32(chan_mask));
+	if (ret)
+		return ret;
+
+	return ltc2983_scan_read(device, chan_mask, vals, fault_mask);
 }
 
 /**
@@ -399,7 +673,7 @@ int ltc2983_chan_read_raw(struct ltc2983_desc *device, const int chan,
 int ltc2983_chan_read_scale(struct ltc2983_desc *device, const int chan,
 			    uint32_t *val, uint32_t *val2)
 {
-	if (device->sensors[chan]->type == LTC2983_DIRECT_ADC) {
+	if (device->sensors[chan - 1]->type == LTC2983_DIRECT_ADC) {
 		/* value in millivolt */
 		*val = 1000;
 		/* 2^21 */
@@ -36,6 +36,7 @@
 
 #include <stdbool.h>
 #include "no_os_gpio.h"
+#include "no_os_regmap.h"
 #include "no_os_spi.h"
 #include "no_os_util.h"
 
@@ -44,6 +45,7 @@
 #define LTC2983_EEPROM_KEY_REG			0x00B0
 #define LTC2983_EEPROM_READ_STATUS_REG		0x00D0
 #define LTC2983_GLOBAL_CONFIG_REG 		0x00F0
+#define LTC2983_MULT_CHANNEL_START_REG		0x00F4
 #define LTC2986_EEPROM_STATUS_REG		0x00F9
 #define LTC2983_MUX_CONFIG_REG 			0x00FF
 #define LTC2983_CHAN_ASSIGN_START_REG 	0x0200
@@ -64,10 +66,15 @@
 #define LTC2983_EEPROM_WRITE_TIME_MS	2600
 #define LTC2983_EEPROM_READ_TIME_MS		20
 
+/* Worst case conversion time of one channel, including the MUX delay */
+#define LTC2983_CONV_TIMEOUT_MS		500
+
 #define LTC2983_CHAN_START_ADDR(chan) \
 			(((chan - 1) * 4) + LTC2983_CHAN_ASSIGN_START_REG)
 #define LTC2983_CHAN_RES_ADDR(chan) \
 			(((chan - 1) * 4) + LTC2983_TEMP_RES_START_REG)
+/* Bit of channel chan (1 based) in a scan mask */
+#define LTC2983_CHAN_MASK(chan)		NO_OS_BIT((chan) - 1)
 
 #define LTC2983_COMMON_HARD_FAULT_MASK	NO_OS_GENMASK(31, 30)
 #define LTC2983_COMMON_SOFT_FAULT_MASK	NO_OS_GENMASK(27, 25)
@@ -222,6 +229,11 @@ struct ltc2983_init_param {
 	struct no_os_spi_init_param spi_init;
 	/** Reset GPIO configuration */
 	struct no_os_gpio_init_param gpio_rstn;
+	/**
+	 * INTERRUPT pin GPIO configuration. Optional. When not used, the end of
+	 * conversion is detected by polling the status register.
+	 */
+	struct no_os_gpio_init_param *gpio_int;
 	/** MUX configuration delay in us */
 	uint32_t mux_delay_config_us;
 	/** Notch frequency of the digital filter */
@@ -242,6 +254,10 @@ struct ltc2983_desc {
 	struct no_os_spi_desc *comm_desc;
 	/** Reset GPIO descriptor */
 	struct no_os_gpio_desc *gpio_rstn;
+	/** INTERRUPT pin GPIO descriptor */
+	struct no_os_gpio_desc *gpio_int;
+	/** Register map caching the configuration registers */
+	struct no_os_regmap *regmap;
 	/** MUX configuration delay in us */
 	uint32_t mux_delay_config_us;
 	/** Notch frequency of the digital filter */
@@ -416,6 +432,21 @@ int ltc2983_chan_read(struct ltc2983_desc *, const int, int *);
 /** Read raw channel data / temperature */
 int ltc2983_chan_read_raw(struct ltc2983_desc *, const int, uint32_t *);
 
+/** Get the scan mask of all channels that can be converted */
+uint32_t ltc2983_scan_mask(struct ltc2983_desc *);
+
+/** Start a conversion of multiple channels */
+int ltc2983_scan_start(struct ltc2983_desc *, uint32_t);
+
+/** Check if a conversion is done */
+int ltc2983_conv_done(struct ltc2983_desc *, bool *);
+
+/** Read the results of a multiple channel conversion */
+int ltc2983_scan_read(struct ltc2983_desc *, uint32_t, uint32_t *, uint32_t *);
+
+/** Convert multiple channels and read the results */
+int ltc2983_scan(struct ltc2983_desc *, uint32_t, uint32_t *, uint32_t *);
+
 /** Set scale of raw channel data / temperature */
 int ltc2983_chan_read_scale(struct ltc2983_desc *, const int, uint32_t *,
 			    uint32_t *);
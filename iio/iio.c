@@ -63,6 +63,10 @@
 #define REG_ACCESS_ATTRIBUTE	"direct_reg_access"
 #define IIOD_CONN_BUFFER_SIZE	0x1000
 #define NO_TRIGGER				(uint32_t)-1
+#define IIO_DEV_ID_PREFIX	"iio:device"
+#define IIO_TRIG_ID_PREFIX	"trigger"
+/* Longest poll while a connection waits for device data */
+#define IIO_POLL_DATA_TIMEOUT_MS	1
 
 #define NO_OS_STRINGIFY(x) #x
 #define NO_OS_TOSTRING(x) NO_OS_STRINGIFY(x)
@@ -71,6 +75,7 @@ static char uart_buff[IIOD_CONN_BUFFER_SIZE];
 
 static char header[] =
 	"<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+#ifndef IIO_COMPACT_XML
 	"<!DOCTYPE context ["
 	"<!ELEMENT context (device | context-attribute)*>"
 	"<!ELEMENT context-attribute EMPTY>"
@@ -89,6 +94,7 @@ static char header[] =
 	"<!ATTLIST debug-attribute name CDATA #REQUIRED>"
 	"<!ATTLIST buffer-attribute name CDATA #REQUIRED>"
 	"]>"
+#endif
 	"<context name=\"xml\" description=\"no-OS/projects/"
 	NO_OS_TOSTRING(NO_OS_PROJECT)" "
 	NO_OS_TOSTRING(NO_OS_VERSION)"\" >";
@@ -112,6 +118,7 @@ static const char * const iio_chan_type_string[] = {
 	[IIO_DELTA_ANGL] = "deltaangl",
 	[IIO_DELTA_VELOCITY] = "deltavelocity",
 	[IIO_WEIGHT] = "weight",
+	[IIO_TIMESTAMP] = "timestamp",
 };
 
 static const char * const iio_modifier_names[] = {
@@ -132,6 +139,32 @@ struct attr_fun_params {
 	struct iio_ch_info	*ch_info;
 };
 
+/**
+ * @struct iio_attr_idx
+ * @brief Index of an attribute list, sorted by name for binary search
+ */
+struct iio_attr_idx {
+	/** Indexed attribute list */
+	struct iio_attribute	*attrs;
+	/** Positions in attrs sorted by attribute name */
+	uint16_t		*sorted;
+	/** Number of attributes in attrs */
+	uint16_t		num;
+};
+
+/**
+ * @struct iio_ch_idx
+ * @brief Channel entry of a device channel index
+ */
+struct iio_ch_idx {
+	/** Channel id as printed in the xml */
+	char			*id;
+	/** Indexed channel */
+	struct iio_channel	*ch;
+	/** Index of the channel attributes */
+	struct iio_attr_idx	attrs;
+};
+
 struct iio_buffer_priv {
 	/* Field visible by user */
 	struct iio_buffer	public;
@@ -145,6 +178,8 @@ struct iio_buffer_priv {
 	bool			initalized;
 	/* Set when no_os_calloc was used to initalize cb.buf */
 	bool			allocated;
+	/* Set to use cb in lock-free mode when possible */
+	bool			lock_free;
 };
 
 /**
@@ -169,6 +204,16 @@ struct iio_dev_priv {
 	struct iio_buffer_priv buffer;
 	/* Set to -1 when no trigger is set*/
 	uint32_t		trig_idx;
+	/** Channels sorted by id and direction. Built in iio_init */
+	struct iio_ch_idx	*ch_idx;
+	/** Storage for the ids in ch_idx */
+	char			*ch_ids;
+	/** Indexes of device, debug and buffer attributes */
+	struct iio_attr_idx	attr_idx[IIO_ATTR_TYPE_DEVICE + 1];
+	/** Xml fragment of the device. Generated on the first PRINT */
+	char			*xml;
+	/** Length of the xml fragment */
+	uint32_t		xml_len;
 };
 
 /**
@@ -187,13 +232,22 @@ struct iio_trig_priv {
 	struct iio_trigger *descriptor;
 	/** Set to true when the triggering condition is met */
 	bool	triggered;
+	/** Index of the trigger attributes */
+	struct iio_attr_idx attr_idx;
+	/** Xml fragment of the trigger. Generated on the first PRINT */
+	char	*xml;
+	/** Length of the xml fragment */
+	uint32_t xml_len;
 };
 
 struct iio_desc {
 	struct iiod_desc	*iiod;
 	struct iiod_ops		iiod_ops;
 	void			*phy_desc;
-	char			*xml_desc;
+	/* Xml of the context attributes */
+	char			*ctx_xml;
+	uint32_t		ctx_xml_len;
+	/* Length of the whole context xml */
 	uint32_t		xml_size;
 	struct iio_ctx_attr	*ctx_attrs;
 	uint32_t		nb_ctx_attr;
@@ -206,10 +260,28 @@ struct iio_desc {
 	int (*send)(void *conn, uint8_t *buf, uint32_t len);
 	/* FIFO for socket descriptors */
 	struct no_os_circular_buffer	*conns;
+	/* Maximum number of simultaneous connections */
+	uint32_t		max_conns;
 #if defined(NO_OS_NETWORKING) || defined(NO_OS_LWIP_NETWORKING) || defined(NO_OS_W5500_NETWORKING)
 	struct tcp_socket_desc	*current_sock;
 	/* Instance of server socket */
 	struct tcp_socket_desc	*server;
+	/* Socket of each iiod connection, indexed by connection id */
+	struct tcp_socket_desc	**conn_socks;
+	/* Maximum time to wait for events in iio_step */
+	uint32_t		poll_timeout_ms;
+	/* Payload buffers of the network connections, allocated at init */
+	char			*conn_pool;
+	/* Size of each buffer from conn_pool */
+	uint32_t		conn_buff_size;
+	/* Indexes of the unused buffers from conn_pool */
+	uint32_t		*free_bufs;
+	uint32_t		nb_free_bufs;
+	/* Sockets and events polled by iio_step. max_conns + 1 entries */
+	struct tcp_socket_desc	**poll_socks;
+	struct socket_poll_entry	*poll_entries;
+	/* Connection ids polled by iio_step. max_conns entries */
+	uint32_t		*poll_ids;
 #endif
 };
 
@@ -273,30 +345,74 @@ static inline void _print_ch_id(char *buff, struct iio_channel *ch)
 	}
 }
 
+/* Order channel index entries by id and then by direction */
+static int32_t iio_ch_idx_cmp(const char *id, bool ch_out,
+			      struct iio_ch_idx *entry)
+{
+	int32_t ret;
+
+	ret = strcmp(id, entry->id);
+	if (ret)
+		return ret;
+
+	return (int32_t)ch_out - (int32_t)entry->ch->ch_out;
+}
+
 /**
- * @brief Get channel ID from a list of channels.
+ * @brief Get channel from the channel index of a device.
  * @param channel - Channel name.
- * @param desc - Device descriptor
+ * @param dev - Device private structure.
  * @param ch_out - If "true" is output channel, if "false" is input channel.
- * @return Channel ID, or negative value if attribute is not found.
+ * @return Channel index entry, or NULL if channel is not found.
  */
-static inline struct iio_channel *iio_get_channel(const char *channel,
-		struct iio_device *desc, bool ch_out)
+static struct iio_ch_idx *iio_get_channel(const char *channel,
+		struct iio_dev_priv *dev, bool ch_out)
 {
-	int16_t i = 0;
-	char	ch_id[MAX_CHN_ID];
-
-	while (i < desc->num_ch) {
-		_print_ch_id(ch_id, &desc->channels[i]);
-		if (!strcmp(channel, ch_id) &&
-		    (desc->channels[i].ch_out == ch_out))
-			return &desc->channels[i];
-		i++;
+	int32_t low, high, mid, ret;
+
+	low = 0;
+	high = (int32_t)dev->dev_descriptor->num_ch - 1;
+	while (low <= high) {
+		mid = (low + high) / 2;
+		ret = iio_ch_idx_cmp(channel, ch_out, &dev->ch_idx[mid]);
+		if (!ret)
+			return &dev->ch_idx[mid];
+		if (ret < 0)
+			high = mid - 1;
+		else
+			low = mid + 1;
 	}
 
 	return NULL;
 }
 
+/**
+ * @brief Get the index encoded in an id generated at iio_init.
+ * @param id - Id to be parsed (e.g. iio:device0, trigger1).
+ * @param prefix - Prefix of the id.
+ * @param n - Number of valid indexes.
+ * @return Index, or -1 if the id is not valid.
+ */
+static int32_t iio_get_id_idx(const char *id, const char *prefix, uint32_t n)
+{
+	uint32_t len = strlen(prefix);
+	uint32_t i;
+	char *end;
+
+	if (strncmp(id, prefix, len) || id[len] < '0' || id[len] > '9')
+		return -1;
+
+	i = strtoul(id + len, &end, 10);
+	if (*end != '\0' || i >= n)
+		return -1;
+
+	/* Reject ids with leading zeros */
+	if (id[len] == '0' && id[len + 1] != '\0')
+		return -1;
+
+	return i;
+}
+
 /**
  * @brief Find interface with "device_name".
  * @param device_name - Device name.
@@ -306,14 +422,14 @@ static inline struct iio_channel *iio_get_channel(const char *channel,
 static struct iio_dev_priv *get_iio_device(struct iio_desc *desc,
 		const char *device_name)
 {
-	uint32_t i;
+	int32_t i;
 
-	for (i = 0; i < desc->nb_devs; i++) {
-		if (strcmp(desc->devs[i].dev_id, device_name) == 0)
-			return &desc->devs[i];
-	}
+	/* Device ids are iio:device<index in desc->devs> */
+	i = iio_get_id_idx(device_name, IIO_DEV_ID_PREFIX, desc->nb_devs);
+	if (i < 0)
+		return NULL;
 
-	return NULL;
+	return &desc->devs[i];
 }
 
 /**
@@ -325,14 +441,183 @@ static struct iio_dev_priv *get_iio_device(struct iio_desc *desc,
 static struct iio_trig_priv *get_iio_trig_device(struct iio_desc *desc,
 		const char *trigger_id)
 {
-	uint32_t i;
+	int32_t i;
 
-	for (i = 0; i < desc->nb_trigs; i++) {
-		if (strcmp(desc->trigs[i].id, trigger_id) == 0)
-			return &desc->trigs[i];
+	/* Trigger ids are trigger<index in desc->trigs> */
+	i = iio_get_id_idx(trigger_id, IIO_TRIG_ID_PREFIX, desc->nb_trigs);
+	if (i < 0)
+		return NULL;
+
+	return &desc->trigs[i];
+}
+
+/**
+ * @brief Build a name sorted index of an attribute list.
+ * @param idx - Index to be initialized.
+ * @param attrs - Attribute list. Last one has its name set to NULL.
+ * @return 0 in case of success or negative value otherwise.
+ */
+static int32_t iio_attr_idx_init(struct iio_attr_idx *idx,
+				 struct iio_attribute *attrs)
+{
+	uint16_t i, j, num;
+
+	idx->attrs = attrs;
+	idx->sorted = NULL;
+	idx->num = 0;
+
+	num = 0;
+	if (attrs)
+		while (attrs[num].name)
+			num++;
+	if (!num)
+		return 0;
+
+	idx->sorted = (uint16_t *)no_os_calloc(num, sizeof(*idx->sorted));
+	if (!idx->sorted)
+		return -ENOMEM;
+
+	/* Stable insertion sort. Keeps first match for duplicated names */
+	for (i = 0; i < num; i++) {
+		j = i;
+		while (j && strcmp(attrs[i].name,
+				   attrs[idx->sorted[j - 1]].name) < 0) {
+			idx->sorted[j] = idx->sorted[j - 1];
+			j--;
+		}
+		idx->sorted[j] = i;
 	}
+	idx->num = num;
 
-	return NULL;
+	return 0;
+}
+
+static void iio_attr_idx_remove(struct iio_attr_idx *idx)
+{
+	no_os_free(idx->sorted);
+	idx->sorted = NULL;
+	idx->num = 0;
+}
+
+/**
+ * @brief Find attribute by name using the attribute index.
+ * @param idx - Attribute index.
+ * @param name - Attribute name.
+ * @return Attribute, or NULL if not found.
+ */
+static struct iio_attribute *iio_attr_idx_find(struct iio_attr_idx *idx,
+		const char *name)
+{
+	struct iio_attribute *attr;
+	int32_t low, high, mid, ret;
+
+	if (!idx)
+		return NULL;
+
+	/* Lower bound search in order to return the first match */
+	low = 0;
+	high = idx->num;
+	while (low < high) {
+		mid = (low + high) / 2;
+		ret = strcmp(idx->attrs[idx->sorted[mid]].name, name);
+		if (ret < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if (low == idx->num)
+		return NULL;
+
+	attr = &idx->attrs[idx->sorted[low]];
+	if (strcmp(attr->name, name))
+		return NULL;
+
+	return attr;
+}
+
+/**
+ * @brief Build channel and attribute indexes of a device.
+ * @param dev - Device private structure.
+ * @return 0 in case of success or negative value otherwise.
+ */
+static int32_t iio_dev_idx_init(struct iio_dev_priv *dev)
+{
+	struct iio_device *desc = dev->dev_descriptor;
+	struct iio_ch_idx entry;
+	char ch_id[MAX_CHN_ID];
+	uint32_t size, of;
+	int32_t ret;
+	uint16_t i, j;
+
+	ret = iio_attr_idx_init(&dev->attr_idx[IIO_ATTR_TYPE_DEVICE],
+				desc->attributes);
+	if (NO_OS_IS_ERR_VALUE(ret))
+		return ret;
+	ret = iio_attr_idx_init(&dev->attr_idx[IIO_ATTR_TYPE_DEBUG],
+				desc->debug_attributes);
+	if (NO_OS_IS_ERR_VALUE(ret))
+		return ret;
+	ret = iio_attr_idx_init(&dev->attr_idx[IIO_ATTR_TYPE_BUFFER],
+				desc->buffer_attributes);
+	if (NO_OS_IS_ERR_VALUE(ret))
+		return ret;
+
+	if (!desc->num_ch || !desc->channels)
+		return 0;
+
+	size = 0;
+	for (i = 0; i < desc->num_ch; i++) {
+		_print_ch_id(ch_id, &desc->channels[i]);
+		size += strlen(ch_id) + 1;
+	}
+
+	dev->ch_ids = (char *)no_os_calloc(size, sizeof(*dev->ch_ids));
+	if (!dev->ch_ids)
+		return -ENOMEM;
+
+	dev->ch_idx = (struct iio_ch_idx *)no_os_calloc(desc->num_ch,
+			sizeof(*dev->ch_idx));
+	if (!dev->ch_idx)
+		return -ENOMEM;
+
+	of = 0;
+	for (i = 0; i < desc->num_ch; i++) {
+		entry.id = dev->ch_ids + of;
+		_print_ch_id(entry.id, &desc->channels[i]);
+		of += strlen(entry.id) + 1;
+		entry.ch = &desc->channels[i];
+		ret = iio_attr_idx_init(&entry.attrs, entry.ch->attributes);
+		if (NO_OS_IS_ERR_VALUE(ret))
+			return ret;
+
+		/* Stable insertion sort by channel id and direction */
+		j = i;
+		while (j && iio_ch_idx_cmp(entry.id, entry.ch->ch_out,
+					   &dev->ch_idx[j - 1]) < 0) {
+			dev->ch_idx[j] = dev->ch_idx[j - 1];
+			j--;
+		}
+		dev->ch_idx[j] = entry;
+	}
+
+	return 0;
+}
+
+/* Free the indexes built by iio_dev_idx_init */
+static void iio_dev_idx_remove(struct iio_dev_priv *dev)
+{
+	uint16_t i;
+
+	if (dev->ch_idx)
+		for (i = 0; i < dev->dev_descriptor->num_ch; i++)
+			iio_attr_idx_remove(&dev->ch_idx[i].attrs);
+	for (i = 0; i < NO_OS_ARRAY_SIZE(dev->attr_idx); i++)
+		iio_attr_idx_remove(&dev->attr_idx[i]);
+	no_os_free(dev->ch_idx);
+	no_os_free(dev->ch_ids);
+	dev->ch_idx = NULL;
+	dev->ch_ids = NULL;
 }
 
 /**
@@ -369,7 +654,7 @@ static int iio_set_buffers_count(struct iiod_ctx *ctx, const char *device,
  * @return Number of bytes read or negative value in case of error.
  */
 static int iio_read_all_attr(struct attr_fun_params *params,
-			     struct iio_attribute *attributes)
+			     struct iio_attr_idx *attributes)
 {
 	/* TODO Not sure if working corectly */
 	return -EINVAL;
@@ -422,7 +707,7 @@ static int iio_read_all_attr(struct attr_fun_params *params,
  * @return Number of written bytes or negative value in case of error.
  */
 static int iio_write_all_attr(struct attr_fun_params *params,
-			      struct iio_attribute *attributes)
+			      struct iio_attr_idx *attributes)
 {
 	/* TODO Not sure if working corectly */
 	return -EINVAL;
@@ -453,42 +738,35 @@ static int iio_write_all_attr(struct attr_fun_params *params,
 /**
  * @brief Read/write attribute.
  * @param params - Structure describing parameters for store and show functions
- * @param attributes - Array of attributes.
+ * @param attributes - Index of the attributes.
  * @param attr_name - Attribute name to be modified
  * @param is_write -If it has value "1", writes attribute, otherwise reads
  * 		attribute.
  * @return Length of chars written/read or negative value in case of error.
  */
 static int iio_rd_wr_attribute(struct attr_fun_params *params,
-			       struct iio_attribute *attributes,
+			       struct iio_attr_idx *attributes,
 			       const char *attr_name,
 			       bool is_write)
 {
-	int16_t i = 0;
+	struct iio_attribute *attr;
 
 	/* Search attribute */
-	while (attributes[i].name) {
-		if (!strcmp(attr_name, attributes[i].name))
-			break;
-		i++;
-	}
-
-	if (!attributes[i].name)
+	attr = iio_attr_idx_find(attributes, attr_name);
+	if (!attr)
 		return -ENOENT;
 
 	if (is_write) {
-		if (!attributes[i].store)
+		if (!attr->store)
 			return -ENOENT;
 
-		return attributes[i].store(params->dev_instance, params->buf,
-					   params->len, params->ch_info,
-					   attributes[i].priv);
+		return attr->store(params->dev_instance, params->buf,
+				   params->len, params->ch_info, attr->priv);
 	} else {
-		if (!attributes[i].show)
+		if (!attr->show)
 			return -ENOENT;
-		return attributes[i].show(params->dev_instance, params->buf,
-					  params->len, params->ch_info,
-					  attributes[i].priv);
+		return attr->show(params->dev_instance, params->buf,
+				  params->len, params->ch_info, attr->priv);
 	}
 }
 
@@ -725,23 +1003,18 @@ int iio_format_value(char *buf, uint32_t len, enum iio_val fmt,
 	}
 }
 
-static struct iio_attribute *get_attributes(enum iio_attr_type type,
+static struct iio_attr_idx *get_attributes(enum iio_attr_type type,
 		struct iio_dev_priv *dev,
-		struct iio_channel *ch)
+		struct iio_ch_idx *ch)
 {
 	switch (type) {
 	case IIO_ATTR_TYPE_DEBUG:
-		return dev->dev_descriptor->debug_attributes;
-		break;
 	case IIO_ATTR_TYPE_DEVICE:
-		return dev->dev_descriptor->attributes;
-		break;
 	case IIO_ATTR_TYPE_BUFFER:
-		return dev->dev_descriptor->buffer_attributes;
-		break;
+		return &dev->attr_idx[type];
 	case IIO_ATTR_TYPE_CH_IN:
 	case IIO_ATTR_TYPE_CH_OUT:
-		return ch->attributes;
+		return ch ? &ch->attrs : NULL;
 	}
 
 	return NULL;
@@ -751,16 +1024,15 @@ static struct iio_attribute *get_attributes(enum iio_attr_type type,
  * @brief Returns trigger attributes.
  * @param type - Attribute type.
  * @param trig - Trigger instance.
- * @return Attributes pointer if attributes exist, NULL otherwise.
+ * @return Attributes index if attributes exist, NULL otherwise.
  */
-static struct iio_attribute *get_trig_attributes(enum iio_attr_type type,
+static struct iio_attr_idx *get_trig_attributes(enum iio_attr_type type,
 		struct iio_trig_priv *trig)
 {
 	switch (type) {
 	/* Only device type attributes allowed for triggers */
 	case IIO_ATTR_TYPE_DEVICE:
-		return trig->descriptor->attributes;
-		break;
+		return &trig->attr_idx;
 	default:
 		break;
 	}
@@ -783,9 +1055,10 @@ static int iio_read_attr(struct iiod_ctx *ctx, const char *device,
 	struct iio_dev_priv *dev;
 	struct iio_trig_priv *trig_dev;
 	struct iio_ch_info ch_info;
-	struct iio_channel *ch = NULL;
+	struct iio_ch_idx *ch_idx = NULL;
+	struct iio_channel *ch;
 	struct attr_fun_params params;
-	struct iio_attribute *attributes;
+	struct iio_attr_idx *attributes;
 	int8_t ch_out;
 
 	dev = get_iio_device(ctx->instance, device);
@@ -801,10 +1074,10 @@ static int iio_read_attr(struct iiod_ctx *ctx, const char *device,
 
 		if (attr->channel[0] != '\0') {
 			ch_out = attr->type == IIO_ATTR_TYPE_CH_OUT ? 1 : 0;
-			ch = iio_get_channel(attr->channel, dev->dev_descriptor,
-					     ch_out);
-			if (!ch)
+			ch_idx = iio_get_channel(attr->channel, dev, ch_out);
+			if (!ch_idx)
 				return -ENOENT;
+			ch = ch_idx->ch;
 			ch_info.ch_out = ch_out;
 			ch_info.ch_num = ch->channel;
 			ch_info.type = ch->ch_type;
@@ -818,7 +1091,7 @@ static int iio_read_attr(struct iiod_ctx *ctx, const char *device,
 		params.buf = buf;
 		params.len = len;
 		params.dev_instance = dev->dev_instance;
-		attributes = get_attributes(attr->type, dev, ch);
+		attributes = get_attributes(attr->type, dev, ch_idx);
 		if (!strcmp(attr->name, ""))
 			return iio_read_all_attr(&params, attributes);
 		return iio_rd_wr_attribute(&params, attributes, attr->name, 0);
@@ -858,9 +1131,10 @@ static int iio_write_attr(struct iiod_ctx *ctx, const char *device,
 	struct iio_dev_priv	*dev;
 	struct iio_trig_priv *trig_dev;
 	struct attr_fun_params	params;
-	struct iio_attribute	*attributes;
+	struct iio_attr_idx	*attributes;
 	struct iio_ch_info ch_info;
-	struct iio_channel *ch = NULL;
+	struct iio_ch_idx *ch_idx = NULL;
+	struct iio_channel *ch;
 	int8_t ch_out;
 
 	dev = get_iio_device(ctx->instance, device);
@@ -877,10 +1151,10 @@ static int iio_write_attr(struct iiod_ctx *ctx, const char *device,
 
 		if (attr->channel[0] != '\0') {
 			ch_out = attr->type == IIO_ATTR_TYPE_CH_OUT ? 1 : 0;
-			ch = iio_get_channel(attr->channel, dev->dev_descriptor,
-					     ch_out);
-			if (!ch)
+			ch_idx = iio_get_channel(attr->channel, dev, ch_out);
+			if (!ch_idx)
 				return -ENOENT;
+			ch = ch_idx->ch;
 
 			ch_info.ch_out = ch_out;
 			ch_info.ch_num = ch->channel;
@@ -895,7 +1169,7 @@ static int iio_write_attr(struct iiod_ctx *ctx, const char *device,
 		params.buf = (char *)buf;
 		params.len = len;
 		params.dev_instance = dev->dev_instance;
-		attributes = get_attributes(attr->type, dev, ch);
+		attributes = get_attributes(attr->type, dev, ch_idx);
 		if (!strcmp(attr->name, ""))
 			return iio_write_all_attr(&params, attributes);
 		return iio_rd_wr_attribute(&params, attributes, attr->name, 1);
@@ -928,16 +1202,16 @@ static int iio_write_attr(struct iiod_ctx *ctx, const char *device,
  */
 static uint32_t iio_get_trig_idx_by_id(struct iio_desc *desc, const char *id)
 {
-	uint32_t i;
+	int32_t i;
 
 	if (!id)
 		return NO_TRIGGER;
 
-	for (i = 0; i < desc->nb_trigs; i++)
-		if (strcmp(desc->trigs[i].id, id) == 0)
-			return i;
+	i = iio_get_id_idx(id, IIO_TRIG_ID_PREFIX, desc->nb_trigs);
+	if (i < 0)
+		return NO_TRIGGER;
 
-	return NO_TRIGGER;
+	return i;
 }
 
 /**
@@ -1059,7 +1333,7 @@ static void iio_process_async_triggers(struct iio_desc *desc)
 
 		if (dev->dev_descriptor->trigger_handler) {
 			dev->dev_descriptor->trigger_handler(&dev->dev_data);
-			desc->trigs[i].triggered = 0;
+			desc->trigs[dev->trig_idx].triggered = 0;
 		}
 	}
 }
@@ -1073,22 +1347,48 @@ static void iio_process_async_triggers(struct iio_desc *desc)
  * @return ret - Result of the processing procedure.
  */
 int iio_process_trigger_type(struct iio_desc *desc, char *trigger_name)
+{
+	int ret;
+
+	ret = iio_process_trigger_timestamp(desc, trigger_name, 0);
+
+	return ret == -EBUSY ? 0 : ret;
+}
+
+/**
+ * @brief Process a trigger like iio_process_trigger_type() and store its
+ * timestamp in the buffers of the devices linked to it. The timestamp is
+ * written in the scans pushed with iio_buffer_push_scan() by their trigger
+ * handlers.
+ * @param desc         - IIO descriptor.
+ * @param trigger_name - Trigger name.
+ * @param timestamp    - Time of the triggering event in ns.
+ *
+ * @return 0 in case of success, -EBUSY if an asynchronous trigger was still
+ * pending and got lost, negative error code otherwise.
+ */
+int iio_process_trigger_timestamp(struct iio_desc *desc, char *trigger_name,
+				  int64_t timestamp)
 {
 	uint32_t i;
 	uint32_t trig_id;
 	struct iio_trig_priv *trig;
+	struct iio_dev_priv *dev;
+	bool missed = false;
 
 	trig_id = iio_get_trig_idx_by_name(desc, trigger_name);
 
 	if (trig_id == NO_TRIGGER)
 		return -EINVAL;
 
-	struct iio_dev_priv *dev;
+	trig = &desc->trigs[trig_id];
+	if (!trig->descriptor->is_synchronous && trig->triggered)
+		missed = true;
 
 	for (i = 0; i < desc->nb_devs; i++) {
 		dev = desc->devs + i;
 		if (dev->trig_idx == trig_id) {
-			trig = &desc->trigs[trig_id];
+			dev->buffer.public.timestamp = timestamp;
 			if (trig->descriptor->is_synchronous) {
 				if (dev->dev_descriptor->trigger_handler)
 					dev->dev_descriptor->trigger_handler(&dev->dev_data);
@@ -1098,7 +1398,7 @@ int iio_process_trigger_type(struct iio_desc *desc, char *trigger_name)
 		}
 	}
 
-	return 0;
+	return missed ? -EBUSY : 0;
 }
 
 static uint32_t bytes_per_scan(struct iio_channel *channels, uint32_t mask)
@@ -1130,6 +1430,32 @@ static uint32_t bytes_per_scan(struct iio_channel *channels, uint32_t mask)
 	return cnt;
 }
 
+/* Offset of the timestamp channel in a scan, using the bytes_per_scan layout.
+ * Returns -1 if the channel is not enabled. */
+static int32_t timestamp_offset(struct iio_channel *channels, uint32_t mask)
+{
+	uint32_t cnt = 0, i = 0, length;
+
+	while (mask) {
+		if ((mask & 1)) {
+			length = channels[i].scan_type->storagebits / 8;
+
+			if (cnt % length)
+				cnt += length - (cnt % length);
+
+			if (channels[i].ch_type == IIO_TIMESTAMP)
+				return cnt;
+
+			cnt += length;
+		}
+
+		mask >>= 1;
+		++i;
+	}
+
+	return -1;
+}
+
 /**
  * @brief  Open device.
  * @param ctx - IIO instance and conn instance
@@ -1148,6 +1474,7 @@ static int iio_open_dev(struct iiod_ctx *ctx, const char *device,
 	int32_t ret;
 	int8_t *buf;
 	uint32_t buf_size;
+	int32_t ts_offset;
 
 	dev = get_iio_device(ctx->instance, device);
 	if (!dev)
@@ -1167,6 +1494,9 @@ static int iio_open_dev(struct iiod_ctx *ctx, const char *device,
 	dev->buffer.public.active_mask = mask;
 	dev->buffer.public.bytes_per_scan =
 		bytes_per_scan(dev->dev_descriptor->channels, mask);
+	ts_offset = timestamp_offset(dev->dev_descriptor->channels, mask);
+	dev->buffer.public.timestamp_en = ts_offset >= 0;
+	dev->buffer.public.timestamp_offset = ts_offset;
 	dev->buffer.public.size = dev->buffer.public.bytes_per_scan * samples;
 	dev->buffer.public.samples = samples;
 	if (dev->buffer.raw_buf && dev->buffer.raw_buf_len) {
@@ -1189,7 +1519,10 @@ static int iio_open_dev(struct iiod_ctx *ctx, const char *device,
 		dev->buffer.allocated = 1;
 	}
 
-	ret = no_os_cb_cfg(&dev->buffer.cb, buf, buf_size);
+	if (dev->buffer.lock_free && !cyclic && !(buf_size & (buf_size - 1)))
+		ret = no_os_cb_cfg_lf(&dev->buffer.cb, buf, buf_size);
+	else
+		ret = no_os_cb_cfg(&dev->buffer.cb, buf, buf_size);
 	if (NO_OS_IS_ERR_VALUE(ret)) {
 		if (dev->buffer.allocated) {
 			no_os_free(dev->buffer.cb.buff);
@@ -1257,6 +1590,7 @@ static int iio_close_dev(struct iiod_ctx *ctx, const char *device)
 	}
 
 	dev->buffer.public.active_mask = 0;
+	dev->buffer.public.timestamp_en = false;
 	if (dev->dev_descriptor->post_disable)
 		ret = dev->dev_descriptor->post_disable(dev->dev_instance);
 
@@ -1356,6 +1690,70 @@ static int iio_read_buffer(struct iiod_ctx *ctx, const char *device, char *buf,
 	return bytes;
 }
 
+/**
+ * @brief Get a contiguous block of data from the device buffer without
+ * copying it.
+ * @param ctx - IIO instance and conn instance.
+ * @param device - String containing device name.
+ * @param buf - Where to store the address of the data.
+ * @param min_bytes - Minimum number of bytes available to return a block.
+ * @param max_bytes - Maximum number of bytes to return.
+ * @return Number of bytes in the block, -EAGAIN if less than min_bytes are
+ * available or negative value in case of error.
+ */
+static int iio_get_read_block(struct iiod_ctx *ctx, const char *device,
+			      char **buf, uint32_t min_bytes,
+			      uint32_t max_bytes)
+{
+	struct iio_dev_priv	*dev;
+	int32_t			ret;
+	uint32_t		size;
+	uint32_t		len;
+
+	dev = get_iio_device(ctx->instance, device);
+	if (!dev || !dev->buffer.initalized)
+		return -EINVAL;
+
+	ret = no_os_cb_size(&dev->buffer.cb, &size);
+#ifdef IIO_IGNORE_BUFF_OVERRUN_ERR
+	if (ret != -NO_OS_EOVERRUN)
+#endif
+		if (NO_OS_IS_ERR_VALUE(ret))
+			return ret;
+
+	/* The device buffer can't hold more than its size */
+	min_bytes = no_os_min(min_bytes, dev->buffer.cb.size);
+	if (!size || size < min_bytes || !max_bytes)
+		return -EAGAIN;
+
+	ret = no_os_cb_prepare_async_read(&dev->buffer.cb, max_bytes,
+					  (void **)buf, &len);
+#ifdef IIO_IGNORE_BUFF_OVERRUN_ERR
+	if (ret != -NO_OS_EOVERRUN)
+#endif
+		if (NO_OS_IS_ERR_VALUE(ret))
+			return ret;
+
+	return len;
+}
+
+/**
+ * @brief Release a block returned by iio_get_read_block.
+ * @param ctx - IIO instance and conn instance.
+ * @param device - String containing device name.
+ * @return 0 in case of success or negative value otherwise.
+ */
+static int iio_read_block_done(struct iiod_ctx *ctx, const char *device)
+{
+	struct iio_dev_priv *dev;
+
+	dev = get_iio_device(ctx->instance, device);
+	if (!dev || !dev->buffer.initalized)
+		return -EINVAL;
+
+	return no_os_cb_end_async_read(&dev->buffer.cb);
+}
+
 
 /**
  * @brief Write chunk of data into RAM.
@@ -1420,9 +1818,81 @@ int iio_buffer_push_scan(struct iio_buffer *buffer, void *data)
 	if (!buffer)
 		return -EINVAL;
 
+	if (buffer->timestamp_en)
+		memcpy((uint8_t *)data + buffer->timestamp_offset,
+		       &buffer->timestamp, sizeof(buffer->timestamp));
+
 	return no_os_cb_write(buffer->buf, data, buffer->bytes_per_scan);
 }
 
+/**
+ * @brief Reserve contiguous space in the buffer for up to nb_scans scans. The
+ * caller fills the scans in place and publishes them with
+ * iio_buffer_commit_scans(), so a batch costs a single buffer update. Less
+ * scans may be reserved than requested when the free space or the end of the
+ * buffer is reached; a second reservation continues from the start.
+ * @param buffer      - IIO buffer.
+ * @param nb_scans    - Number of scans requested.
+ * @param addr        - Address of the first reserved scan.
+ * @param nb_reserved - Number of scans reserved.
+ * @return 0 in case of success, -EAGAIN if there is no room for a scan,
+ * negative error code otherwise.
+ */
+int iio_buffer_reserve_scans(struct iio_buffer *buffer, uint32_t nb_scans,
+			     void **addr, uint32_t *nb_reserved)
+{
+	uint32_t size;
+	int ret;
+
+	if (!buffer || !addr || !nb_reserved || !nb_scans ||
+	    !buffer->bytes_per_scan)
+		return -EINVAL;
+
+	*nb_reserved = 0;
+	ret = no_os_cb_prepare_async_write(buffer->buf,
+					   nb_scans * buffer->bytes_per_scan,
+					   addr, &size);
+	if (ret)
+		return ret;
+
+	*nb_reserved = size / buffer->bytes_per_scan;
+	if (!*nb_reserved) {
+		no_os_cb_end_async_write_partial(buffer->buf, 0);
+		return -EAGAIN;
+	}
+	buffer->reserved = *addr;
+
+	return 0;
+}
+
+/**
+ * @brief Publish scans filled in the space returned by
+ * iio_buffer_reserve_scans(). As for iio_buffer_push_scan(), the timestamp
+ * channel of the committed scans is filled with the trigger timestamp.
+ * @param buffer   - IIO buffer.
+ * @param nb_scans - Number of scans written, 0 to cancel the reservation.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int iio_buffer_commit_scans(struct iio_buffer *buffer, uint32_t nb_scans)
+{
+	uint8_t *scan;
+	uint32_t i;
+
+	if (!buffer || nb_scans * buffer->bytes_per_scan >
+	    buffer->buf->write.async_size)
+		return -EINVAL;
+
+	if (buffer->timestamp_en && buffer->reserved) {
+		scan = (uint8_t *)buffer->reserved + buffer->timestamp_offset;
+		for (i = 0; i < nb_scans; i++, scan += buffer->bytes_per_scan)
+			memcpy(scan, &buffer->timestamp, sizeof(buffer->timestamp));
+	}
+	buffer->reserved = NULL;
+
+	return no_os_cb_end_async_write_partial(buffer->buf,
+						nb_scans * buffer->bytes_per_scan);
+}
+
 /* Read from buffer iio_buffer.bytes_per_scan bytes into data */
 int iio_buffer_pop_scan(struct iio_buffer *buffer, void *data)
 {
@@ -1443,6 +1913,90 @@ int iio_buffer_pop_scan(struct iio_buffer *buffer, void *data)
 
 #if defined(NO_OS_NETWORKING) || defined(NO_OS_LWIP_NETWORKING) || defined(NO_OS_W5500_NETWORKING)
 
+/**
+ * @brief Allocate the network connection pool.
+ * @param desc - IIo descriptor
+ * @param buff_size - Size of the payload buffer of each connection
+ * @return 0 in case of success or negative value otherwise.
+ */
+static int32_t iio_init_conn_pool(struct iio_desc *desc, uint32_t buff_size)
+{
+	uint32_t i;
+
+	desc->conn_buff_size = buff_size ? buff_size : IIOD_CONN_BUFFER_SIZE;
+	desc->conn_pool = no_os_calloc(desc->max_conns, desc->conn_buff_size);
+	desc->free_bufs = no_os_calloc(desc->max_conns,
+				       sizeof(*desc->free_bufs));
+	desc->conn_socks = no_os_calloc(desc->max_conns,
+					sizeof(*desc->conn_socks));
+	desc->poll_socks = no_os_calloc(desc->max_conns + 1,
+					sizeof(*desc->poll_socks));
+	desc->poll_entries = no_os_calloc(desc->max_conns + 1,
+					  sizeof(*desc->poll_entries));
+	desc->poll_ids = no_os_calloc(desc->max_conns,
+				      sizeof(*desc->poll_ids));
+	if (!desc->conn_pool || !desc->free_bufs || !desc->conn_socks ||
+	    !desc->poll_socks || !desc->poll_entries || !desc->poll_ids)
+		return -ENOMEM;
+
+	for (i = 0; i < desc->max_conns; i++)
+		desc->free_bufs[i] = desc->max_conns - 1 - i;
+	desc->nb_free_bufs = desc->max_conns;
+
+	return 0;
+}
+
+/**
+ * @brief Free the network connection pool.
+ * @param desc - IIo descriptor
+ */
+static void iio_remove_conn_pool(struct iio_desc *desc)
+{
+	no_os_free(desc->poll_ids);
+	no_os_free(desc->poll_entries);
+	no_os_free(desc->poll_socks);
+	no_os_free(desc->conn_socks);
+	no_os_free(desc->free_bufs);
+	no_os_free(desc->conn_pool);
+}
+
+static inline char *_get_conn_buf(struct iio_desc *desc)
+{
+	uint32_t idx;
+
+	if (!desc->nb_free_bufs)
+		return NULL;
+
+	idx = desc->free_bufs[--desc->nb_free_bufs];
+
+	return desc->conn_pool + idx * desc->conn_buff_size;
+}
+
+static inline void _put_conn_buf(struct iio_desc *desc, char *buf)
+{
+	desc->free_bufs[desc->nb_free_bufs++] = (buf - desc->conn_pool) /
+						desc->conn_buff_size;
+}
+
+/**
+ * @brief Release the resources of a network connection.
+ * @param desc - IIo descriptor
+ * @param conn_id - Id of the connection
+ */
+static void iio_remove_network_conn(struct iio_desc *desc, uint32_t conn_id)
+{
+	struct iiod_conn_data data;
+	int32_t ret;
+
+	ret = iiod_conn_remove(desc->iiod, conn_id, &data);
+	if (NO_OS_IS_ERR_VALUE(ret))
+		return;
+
+	socket_remove(data.conn);
+	_put_conn_buf(desc, data.buf);
+	desc->conn_socks[conn_id] = NULL;
+}
+
 static int32_t accept_network_clients(struct iio_desc *desc)
 {
 	struct tcp_socket_desc *sock;
@@ -1456,18 +2010,19 @@ static int32_t accept_network_clients(struct iio_desc *desc)
 			return ret;
 
 		data.conn = sock;
-		data.buf = no_os_calloc(1, IIOD_CONN_BUFFER_SIZE);
-		data.len = IIOD_CONN_BUFFER_SIZE;
+		data.buf = _get_conn_buf(desc);
+		data.len = desc->conn_buff_size;
 
 		if (!data.buf) {
-			ret = -ENOMEM;
+			ret = -EBUSY;
 			goto close_socket;
 		}
 
 		ret = iiod_conn_add(desc->iiod, &data, &id);
 		if (NO_OS_IS_ERR_VALUE(ret))
-			goto free_buf;
+			goto put_buf;
 
+		desc->conn_socks[id] = sock;
 		ret = _push_conn(desc, id);
 		if (NO_OS_IS_ERR_VALUE(ret))
 			goto remove_conn;
@@ -1477,23 +2032,99 @@ static int32_t accept_network_clients(struct iio_desc *desc)
 
 remove_conn:
 	iiod_conn_remove(desc->iiod, id, &data);
-free_buf:
-	no_os_free(data.buf);
+	desc->conn_socks[id] = NULL;
+put_buf:
+	_put_conn_buf(desc, data.buf);
 close_socket:
 	socket_remove(sock);
 
 	return ret;
 }
+
+/**
+ * @brief Step the network connections that are ready for I/O.
+ *
+ * All connections are polled together with the server socket. Connections
+ * that can make progress without I/O don't wait, otherwise the poll waits
+ * up to poll_timeout_ms for an event. Connections waiting for device data
+ * can't be woken up by the poll, so it sleeps at most
+ * IIO_POLL_DATA_TIMEOUT_MS for them.
+ * @param desc - IIo descriptor
+ * @return 0 or the last error returned by a connection step.
+ */
+static int32_t iio_step_ready_conns(struct iio_desc *desc)
+{
+	struct tcp_socket_desc **socks = desc->poll_socks;
+	struct socket_poll_entry *entries = desc->poll_entries;
+	uint32_t *ids = desc->poll_ids;
+	int32_t ret, step_ret = 0;
+	uint32_t timeout;
+	uint32_t events;
+	uint32_t nb;
+	uint32_t i;
+
+	timeout = desc->poll_timeout_ms;
+	socks[0] = desc->server;
+	entries[0].events = SOCKET_POLL_IN;
+	nb = 0;
+	while (nb < desc->max_conns && !_pop_conn(desc, &ids[nb])) {
+		iiod_conn_wait_events(desc->iiod, ids[nb], &events);
+		socks[nb + 1] = desc->conn_socks[ids[nb]];
+		entries[nb + 1].events = 0;
+		if (events & IIOD_CONN_WAIT_RECV)
+			entries[nb + 1].events |= SOCKET_POLL_IN;
+		if (events & IIOD_CONN_WAIT_SEND)
+			entries[nb + 1].events |= SOCKET_POLL_OUT;
+		if (events & IIOD_CONN_WAIT_DATA)
+			timeout = no_os_min(timeout, IIO_POLL_DATA_TIMEOUT_MS);
+		if (!events)
+			timeout = 0;
+		nb++;
+	}
+
+	ret = socket_poll(socks, entries, nb + 1, timeout);
+	if (NO_OS_IS_ERR_VALUE(ret)) {
+		for (i = 0; i < nb; i++)
+			_push_conn(desc, ids[i]);
+
+		return ret;
+	}
+
+	for (i = 0; i < nb; i++) {
+		if (entries[i + 1].events && !entries[i + 1].revents) {
+			_push_conn(desc, ids[i]);
+			continue;
+		}
+
+		ret = iiod_conn_step(desc->iiod, ids[i]);
+		if (ret == -ENOTCONN)
+			iio_remove_network_conn(desc, ids[i]);
+		else
+			_push_conn(desc, ids[i]);
+		if (NO_OS_IS_ERR_VALUE(ret) && ret != -EAGAIN)
+			step_ret = ret;
+	}
+
+	if (entries[0].revents & SOCKET_POLL_IN) {
+		ret = accept_network_clients(desc);
+		if (NO_OS_IS_ERR_VALUE(ret) && ret != -EAGAIN)
+			return ret;
+	}
+
+	return step_ret;
+}
 #endif
 
 /**
  * @brief Execute an iio step
+ *
+ * If the network interface supports socket_poll, all the connections that
+ * are ready are processed. Otherwise, one connection is processed per step.
  * @param desc - IIo descriptor
  * @return 0 in case of success or negative value otherwise.
  */
 int iio_step(struct iio_desc *desc)
 {
-	struct iiod_conn_data data;
 	uint32_t conn_id;
 	int32_t ret;
 
@@ -1501,12 +2132,15 @@ int iio_step(struct iio_desc *desc)
 
 #if defined(NO_OS_NETWORKING) || defined(NO_OS_LWIP_NETWORKING) || defined(NO_OS_W5500_NETWORKING)
 	if (desc->server) {
-		ret = accept_network_clients(desc);
-		if (NO_OS_IS_ERR_VALUE(ret) && ret != -EAGAIN)
-			return ret;
 #if defined(NO_OS_LWIP_NETWORKING)
 		no_os_lwip_step(desc->server->net->net, desc->server->net->net);
 #endif
+		if (desc->server->net->socket_poll)
+			return iio_step_ready_conns(desc);
+
+		ret = accept_network_clients(desc);
+		if (NO_OS_IS_ERR_VALUE(ret) && ret != -EAGAIN)
+			return ret;
 	}
 #endif
 
@@ -1517,9 +2151,7 @@ int iio_step(struct iio_desc *desc)
 	ret = iiod_conn_step(desc->iiod, conn_id);
 	if (ret == -ENOTCONN) {
 #if defined(NO_OS_NETWORKING) || defined(NO_OS_LWIP_NETWORKING) || defined(NO_OS_W5500_NETWORKING)
-		iiod_conn_remove(desc->iiod, conn_id, &data);
-		socket_remove(data.conn);
-		no_os_free(data.buf);
+		iio_remove_network_conn(desc, conn_id);
 #endif
 	} else {
 		_push_conn(desc, conn_id);
@@ -1744,60 +2376,175 @@ static uint32_t iio_generate_device_xml(struct iio_device *device, char *name,
 	return i;
 }
 
+/**
+ * @brief Compute the length of the context xml.
+ *
+ * Only the context attributes are written here. The xml of each device and
+ * trigger is generated when it is first sent.
+ * @param desc - IIo descriptor.
+ * @return 0 in case of success or negative value otherwise.
+ */
 static int32_t iio_init_xml(struct iio_desc *desc)
 {
 	struct iio_dev_priv *dev;
 	struct iio_trig_priv *trig;
 	struct iio_device dummy = { 0 };
-	uint32_t i, size, of;
+	uint32_t i, size;
 
 	/* -2 because of the 0 character */
 	size = sizeof(header) + sizeof(header_end) - 2;
-	size += iio_add_ctx_attr_in_xml(desc, NULL, -1);
+
+	desc->ctx_xml_len = iio_add_ctx_attr_in_xml(desc, NULL, -1);
+	if (desc->ctx_xml_len) {
+		desc->ctx_xml = no_os_calloc(desc->ctx_xml_len + 1,
+					     sizeof(*desc->ctx_xml));
+		if (!desc->ctx_xml)
+			return -ENOMEM;
+
+		iio_add_ctx_attr_in_xml(desc, desc->ctx_xml,
+					desc->ctx_xml_len + 1);
+		size += desc->ctx_xml_len;
+	}
+
 	for (i = 0; i < desc->nb_devs; i++) {
 		dev = desc->devs + i;
-		size += iio_generate_device_xml(dev->dev_descriptor,
-						(char *)dev->name,
-						dev->dev_id, NULL, -1);
+		dev->xml_len = iio_generate_device_xml(dev->dev_descriptor,
+						       (char *)dev->name,
+						       dev->dev_id, NULL, -1);
+		size += dev->xml_len;
 	}
 	for (i = 0; i < desc->nb_trigs; i++) {
 		trig = desc->trigs + i;
 		dummy.attributes = trig->descriptor->attributes;
-		size += iio_generate_device_xml(&dummy, trig->name, trig->id,
-						NULL, -1);
+		trig->xml_len = iio_generate_device_xml(&dummy, trig->name,
+							trig->id, NULL, -1);
+		size += trig->xml_len;
 	}
 
-	desc->xml_desc = (char *)no_os_calloc(size + 1, sizeof(*desc->xml_desc));
-	if (!desc->xml_desc)
+	desc->xml_size = size;
+
+	return 0;
+}
+
+/**
+ * @brief Free the xml fragments.
+ * @param desc - IIo descriptor.
+ */
+static void iio_remove_xml(struct iio_desc *desc)
+{
+	uint32_t i;
+
+	for (i = 0; i < desc->nb_devs; i++) {
+		no_os_free(desc->devs[i].xml);
+		desc->devs[i].xml = NULL;
+	}
+	for (i = 0; i < desc->nb_trigs; i++) {
+		no_os_free(desc->trigs[i].xml);
+		desc->trigs[i].xml = NULL;
+	}
+	no_os_free(desc->ctx_xml);
+	desc->ctx_xml = NULL;
+}
+
+/**
+ * @brief Generate the xml fragment of a device if not done already.
+ * @param frag - Cached fragment. Allocated on the first call.
+ * @param len - Length of the fragment, computed in iio_init_xml.
+ * @param device - Device descriptor.
+ * @param name - Device name.
+ * @param id - Device id.
+ * @return 0 in case of success or negative value otherwise.
+ */
+static int32_t iio_get_xml_frag(char **frag, uint32_t len,
+				struct iio_device *device, char *name, char *id)
+{
+	if (*frag)
+		return 0;
+
+	*frag = no_os_calloc(len + 1, sizeof(**frag));
+	if (!*frag)
 		return -ENOMEM;
 
-	desc->xml_size = size;
+	iio_generate_device_xml(device, name, id, *frag, len + 1);
+
+	return 0;
+}
+
+/**
+ * @brief Get the context xml starting at offset.
+ * @param ctx - IIO instance and conn instance.
+ * @param offset - Offset in the context xml.
+ * @param buf - Set to the xml at offset.
+ * @return Number of contiguous bytes from buf or negative value otherwise.
+ */
+static int iio_get_xml_chunk(struct iiod_ctx *ctx, uint32_t offset, char **buf)
+{
+	struct iio_desc *desc = ctx->instance;
+	struct iio_device dummy = { 0 };
+	struct iio_trig_priv *trig;
+	struct iio_dev_priv *dev;
+	uint32_t i;
+	int32_t ret;
+
+	if (offset < sizeof(header) - 1) {
+		*buf = header + offset;
+		return sizeof(header) - 1 - offset;
+	}
+	offset -= sizeof(header) - 1;
+
+	if (offset < desc->ctx_xml_len) {
+		*buf = desc->ctx_xml + offset;
+		return desc->ctx_xml_len - offset;
+	}
+	offset -= desc->ctx_xml_len;
 
-	strcpy(desc->xml_desc, header);
-	of = sizeof(header) - 1;
-	of += iio_add_ctx_attr_in_xml(desc, desc->xml_desc + of, size - of);
 	for (i = 0; i < desc->nb_devs; i++) {
 		dev = desc->devs + i;
-		of += iio_generate_device_xml(dev->dev_descriptor,
-					      (char *)dev->name, dev->dev_id,
-					      desc->xml_desc + of, size - of);
+		if (offset >= dev->xml_len) {
+			offset -= dev->xml_len;
+			continue;
+		}
+
+		ret = iio_get_xml_frag(&dev->xml, dev->xml_len,
+				       dev->dev_descriptor, (char *)dev->name,
+				       dev->dev_id);
+		if (NO_OS_IS_ERR_VALUE(ret))
+			return ret;
+
+		*buf = dev->xml + offset;
+		return dev->xml_len - offset;
 	}
+
 	for (i = 0; i < desc->nb_trigs; i++) {
 		trig = desc->trigs + i;
+		if (offset >= trig->xml_len) {
+			offset -= trig->xml_len;
+			continue;
+		}
+
 		dummy.attributes = trig->descriptor->attributes;
-		of += iio_generate_device_xml(&dummy, trig->name, trig->id,
-					      desc->xml_desc + of, size - of);
+		ret = iio_get_xml_frag(&trig->xml, trig->xml_len, &dummy,
+				       trig->name, trig->id);
+		if (NO_OS_IS_ERR_VALUE(ret))
+			return ret;
+
+		*buf = trig->xml + offset;
+		return trig->xml_len - offset;
 	}
 
-	strcpy(desc->xml_desc + of, header_end);
+	if (offset < sizeof(header_end) - 1) {
+		*buf = header_end + offset;
+		return sizeof(header_end) - 1 - offset;
+	}
 
-	return 0;
+	return -EINVAL;
 }
 
 static int32_t iio_init_devs(struct iio_desc *desc,
 			     struct iio_device_init *devs, uint32_t n)
 {
 	uint32_t i;
+	int32_t ret;
 	struct iio_dev_priv *ldev;
 	struct iio_device_init *ndev;
 
@@ -1811,7 +2558,7 @@ static int32_t iio_init_devs(struct iio_desc *desc,
 		ndev = devs + i;
 		ldev = desc->devs + i;
 		ldev->dev_descriptor = ndev->dev_descriptor;
-		sprintf(ldev->dev_id, "iio:device%"PRIu32"", i);
+		sprintf(ldev->dev_id, IIO_DEV_ID_PREFIX"%"PRIu32"", i);
 		ldev->trig_idx = iio_get_trig_idx_by_id(desc, ndev->trigger_id);
 		ldev->dev_instance = ndev->dev;
 		ldev->dev_data.dev = ndev->dev;
@@ -1823,14 +2570,40 @@ static int32_t iio_init_devs(struct iio_desc *desc,
 		    ndev->dev_descriptor->trigger_handler) {
 			ldev->buffer.raw_buf = ndev->raw_buf;
 			ldev->buffer.raw_buf_len = ndev->raw_buf_len;
+			ldev->buffer.lock_free = ndev->lock_free_buffer;
 			ldev->buffer.public.buf = &ldev->buffer.cb;
 			ldev->buffer.initalized = 1;
 		} else {
 			ldev->buffer.initalized = 0;
 		}
+		ret = iio_dev_idx_init(ldev);
+		if (NO_OS_IS_ERR_VALUE(ret))
+			goto free_idx;
 	}
 
 	return 0;
+
+free_idx:
+	do {
+		iio_dev_idx_remove(desc->devs + i);
+	} while (i--);
+	no_os_free(desc->devs);
+	desc->devs = NULL;
+
+	return ret;
+}
+
+/* Free the resources allocated by iio_init_devs */
+static void iio_remove_devs(struct iio_desc *desc)
+{
+	uint32_t i;
+
+	if (!desc->devs)
+		return;
+
+	for (i = 0; i < desc->nb_devs; i++)
+		iio_dev_idx_remove(desc->devs + i);
+	no_os_free(desc->devs);
 }
 
 /**
@@ -1844,6 +2617,7 @@ static int32_t iio_init_trigs(struct iio_desc *desc,
 			      struct iio_trigger_init *trigs, uint32_t n)
 {
 	uint32_t i;
+	int32_t ret;
 	struct iio_trig_priv *trig_priv_iter;
 	struct iio_trigger_init *trig_init_iter;
 
@@ -1859,10 +2633,36 @@ static int32_t iio_init_trigs(struct iio_desc *desc,
 		trig_priv_iter->instance = trig_init_iter->trig;
 		trig_priv_iter->name = trig_init_iter->name;
 		trig_priv_iter->descriptor = trig_init_iter->descriptor;
-		sprintf(trig_priv_iter->id, "trigger%"PRIu32"", i);
+		sprintf(trig_priv_iter->id, IIO_TRIG_ID_PREFIX"%"PRIu32"", i);
+		ret = iio_attr_idx_init(&trig_priv_iter->attr_idx,
+					trig_priv_iter->descriptor->attributes);
+		if (NO_OS_IS_ERR_VALUE(ret))
+			goto free_idx;
 	}
 
 	return 0;
+
+free_idx:
+	do {
+		iio_attr_idx_remove(&desc->trigs[i].attr_idx);
+	} while (i--);
+	no_os_free(desc->trigs);
+	desc->trigs = NULL;
+
+	return ret;
+}
+
+/* Free the resources allocated by iio_init_trigs */
+static void iio_remove_trigs(struct iio_desc *desc)
+{
+	uint32_t i;
+
+	if (!desc->trigs)
+		return;
+
+	for (i = 0; i < desc->nb_trigs; i++)
+		iio_attr_idx_remove(&desc->trigs[i].attr_idx);
+	no_os_free(desc->trigs);
 }
 
 /**
@@ -1891,15 +2691,15 @@ int iio_init(struct iio_desc **desc, struct iio_init_param *init_param)
 
 	ret = iio_init_trigs(ldesc, init_param->trigs, init_param->nb_trigs);
 	if (NO_OS_IS_ERR_VALUE(ret))
-		goto free_devs;
+		goto free_desc;
 
 	ret = iio_init_devs(ldesc, init_param->devs, init_param->nb_devs);
 	if (NO_OS_IS_ERR_VALUE(ret))
-		goto free_desc;
+		goto free_trigs;
 
 	ret = iio_init_xml(ldesc);
 	if (NO_OS_IS_ERR_VALUE(ret))
-		goto free_trigs;
+		goto free_devs;
 
 	/* device operations */
 	ops = &ldesc->iiod_ops;
@@ -1908,6 +2708,9 @@ int iio_init(struct iio_desc **desc, struct iio_init_param *init_param)
 	ops->get_trigger = iio_get_trigger;
 	ops->set_trigger = iio_set_trigger;
 	ops->read_buffer = iio_read_buffer;
+	ops->get_read_block = iio_get_read_block;
+	ops->read_block_done = iio_read_block_done;
+	ops->get_xml_chunk = iio_get_xml_chunk;
 	ops->write_buffer = iio_write_buffer;
 	ops->refill_buffer = iio_refill_buffer;
 	ops->push_buffer = iio_push_buffer;
@@ -1919,16 +2722,19 @@ int iio_init(struct iio_desc **desc, struct iio_init_param *init_param)
 
 	iiod_param.instance = ldesc;
 	iiod_param.ops = ops;
-	iiod_param.xml = ldesc->xml_desc;
+	iiod_param.xml = NULL;
 	iiod_param.xml_len = ldesc->xml_size;
 	iiod_param.phy_type = init_param->phy_type;
+	iiod_param.max_conns = init_param->max_conns ? init_param->max_conns :
+			       IIOD_MAX_CONNECTIONS;
+	ldesc->max_conns = iiod_param.max_conns;
 
 	ret = iiod_init(&ldesc->iiod, &iiod_param);
 	if (NO_OS_IS_ERR_VALUE(ret))
 		goto free_xml;
 
 	ret = no_os_cb_init(&ldesc->conns,
-			    sizeof(uint32_t) * (IIOD_MAX_CONNECTIONS + 1));
+			    sizeof(uint32_t) * (ldesc->max_conns + 1));
 	if (NO_OS_IS_ERR_VALUE(ret))
 		goto free_iiod;
 
@@ -1951,10 +2757,14 @@ int iio_init(struct iio_desc **desc, struct iio_init_param *init_param)
 	else if (init_param->phy_type == USE_NETWORK) {
 		ldesc->send = (int (*)())socket_send;
 		ldesc->recv = (int (*)())socket_recv;
+		ldesc->poll_timeout_ms = init_param->poll_timeout_ms;
+		ret = iio_init_conn_pool(ldesc, init_param->conn_buff_size);
+		if (NO_OS_IS_ERR_VALUE(ret))
+			goto free_pool;
 		ret = socket_init(&ldesc->server,
 				  init_param->tcp_socket_init_param);
 		if (NO_OS_IS_ERR_VALUE(ret))
-			goto free_conns;
+			goto free_pool;
 		ret = socket_bind(ldesc->server, IIOD_PORT);
 		if (NO_OS_IS_ERR_VALUE(ret))
 			goto free_pylink;
@@ -1988,17 +2798,19 @@ int iio_init(struct iio_desc **desc, struct iio_init_param *init_param)
 free_pylink:
 #if defined(NO_OS_NETWORKING) || defined(NO_OS_LWIP_NETWORKING) || defined(NO_OS_W5500_NETWORKING)
 	socket_remove(ldesc->server);
+free_pool:
+	iio_remove_conn_pool(ldesc);
 #endif
 free_conns:
 	no_os_cb_remove(ldesc->conns);
 free_iiod:
 	iiod_remove(ldesc->iiod);
 free_xml:
-	no_os_free(ldesc->xml_desc);
-free_trigs:
-	no_os_free(ldesc->trigs);
+	iio_remove_xml(ldesc);
 free_devs:
-	no_os_free(ldesc->devs);
+	iio_remove_devs(ldesc);
+free_trigs:
+	iio_remove_trigs(ldesc);
 free_desc:
 	no_os_free(ldesc);
 
@@ -2012,27 +2824,22 @@ free_desc:
  */
 int iio_remove(struct iio_desc *desc)
 {
-	struct iiod_conn_data data;
-	int ret;
-
 	if (!desc)
 		return -EINVAL;
 
 #if defined(NO_OS_NETWORKING) || defined(NO_OS_LWIP_NETWORKING) || defined(NO_OS_W5500_NETWORKING)
-	for (int i = 0; i < IIOD_MAX_CONNECTIONS; i++) {
-		ret = iiod_conn_remove(desc->iiod, i, &data);
-		if (!ret) {
-			no_os_free(data.buf);
-			socket_remove(data.conn);
-		}
+	if (desc->server) {
+		for (uint32_t i = 0; i < desc->max_conns; i++)
+			iio_remove_network_conn(desc, i);
+		socket_remove(desc->server);
+		iio_remove_conn_pool(desc);
 	}
-	socket_remove(desc->server);
 #endif
 	no_os_cb_remove(desc->conns);
 	iiod_remove(desc->iiod);
-	no_os_free(desc->devs);
-	no_os_free(desc->trigs);
-	no_os_free(desc->xml_desc);
+	iio_remove_xml(desc);
+	iio_remove_devs(desc);
+	iio_remove_trigs(desc);
 	no_os_free(desc);
 
 	return 0;
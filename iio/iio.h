@@ -63,6 +63,15 @@ struct iio_device_init {
 	uint32_t raw_buf_len;
 	/* If set, trigger will be linked to this device */
 	char *trigger_id;
+	/*
+	 * If set and the buffer size is a power of 2, the buffer is used as a
+	 * lock-free single producer single consumer buffer. Then
+	 * iio_buffer_push_scan, iio_buffer_reserve_scans/iio_buffer_commit_scans
+	 * and iio_buffer_get_block can be called from interrupt context. Scans
+	 * that don't fit are dropped instead of overwriting unread data. Not used
+	 * for cyclic buffers.
+	 */
+	bool lock_free_buffer;
 };
 
 struct iio_trigger_init {
@@ -108,6 +117,23 @@ struct iio_init_param {
 	uint32_t nb_devs;
 	struct iio_trigger_init *trigs;
 	uint32_t nb_trigs;
+	/*
+	 * Maximum time iio_step waits for network events when no connection
+	 * can make progress. Only used if the network interface implements
+	 * socket_poll. 0 never waits.
+	 */
+	uint32_t poll_timeout_ms;
+	/*
+	 * Maximum number of simultaneous connections.
+	 * If 0, IIOD_MAX_CONNECTIONS is used.
+	 */
+	uint32_t max_conns;
+	/*
+	 * Size of the payload buffer of each network connection. Buffers for
+	 * all max_conns connections are allocated in iio_init. Larger buffers
+	 * allow larger READBUF transfers. If 0, 4 KiB are used.
+	 */
+	uint32_t conn_buff_size;
 };
 
 /* Set communication ops and read/write ops. */
@@ -122,6 +148,11 @@ int iio_step(struct iio_desc *desc);
    (is_synchronous = true) or will be called from iio_step if trigger is
    asynchronous (is_synchronous = false) */
 int iio_process_trigger_type(struct iio_desc *desc, char *trigger_name);
+/* Same as iio_process_trigger_type, also storing the trigger timestamp in the
+   buffers of the triggered devices. Returns -EBUSY if an asynchronous trigger
+   was still pending, so the previous one was missed. */
+int iio_process_trigger_timestamp(struct iio_desc *desc, char *trigger_name,
+				  int64_t timestamp);
 
 int32_t iio_parse_value(char *buf, enum iio_val fmt,
 			int32_t *val, int32_t *val2);
@@ -135,9 +166,15 @@ int iio_buffer_get_block(struct iio_buffer *buffer, void **addr);
 int iio_buffer_block_done(struct iio_buffer *buffer);
 
 /* Trigger buffer functions. */
-/* Write to buffer iio_buffer.bytes_per_scan bytes from data */
+/* Write to buffer iio_buffer.bytes_per_scan bytes from data. If the timestamp
+   channel is enabled, its value is first written in data. */
 int iio_buffer_push_scan(struct iio_buffer *buffer, void *data);
 /* Read from buffer iio_buffer.bytes_per_scan bytes into data */
 int iio_buffer_pop_scan(struct iio_buffer *buffer, void *data);
+/* Reserve contiguous space for up to nb_scans scans to be filled in place */
+int iio_buffer_reserve_scans(struct iio_buffer *buffer, uint32_t nb_scans,
+			     void **addr, uint32_t *nb_reserved);
+/* Publish the first nb_scans reserved scans, 0 to cancel the reservation */
+int iio_buffer_commit_scans(struct iio_buffer *buffer, uint32_t nb_scans);
 
 #endif /* IIO_H_ */
@@ -79,6 +79,9 @@
 #define UART_BAUDRATE_DEFAULT	115200
 #define UART_STOPBITS_DEFAULT	NO_OS_UART_STOP_1_BIT
 
+/* Bounds the delay of post_step_callback when no client is active */
+#define IIO_APP_POLL_TIMEOUT_MS	10
+
 static inline uint32_t _calc_uart_xfer_time(uint32_t len, uint32_t baudrate)
 {
 	uint32_t ms = 1000ul * len * 8 / UART_BAUDRATE_DEFAULT;
@@ -195,6 +198,8 @@ static int32_t network_setup(struct iio_init_param *iio_init_param,
 
 #ifdef LINUX_PLATFORM
 	socket_param.net = &linux_net;
+	/* Sleep in iio_step until a client is ready */
+	iio_init_param->poll_timeout_ms = IIO_APP_POLL_TIMEOUT_MS;
 #endif
 #ifdef ADUCM_PLATFORM
 	int32_t status;
@@ -297,7 +302,7 @@ int iio_app_init(struct iio_app_desc **app,
 		 struct iio_app_init_param app_init_param)
 {
 	struct iio_device_init *iio_init_devs = NULL;
-	struct iio_init_param iio_init_param;
+	struct iio_init_param iio_init_param = {0};
 	struct no_os_uart_desc *uart_desc;
 	struct iio_app_desc *application;
 	struct iio_data_buffer *buff;
@@ -33,12 +33,92 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
 #include "no_os_error.h"
 #include "no_os_alloc.h"
+#include "no_os_util.h"
 #include "iio.h"
 #include "iio_trigger.h"
 
 #ifndef LINUX_PLATFORM
+/**
+ * @brief Get the time elapsed since the trigger initialization.
+ *
+ * @param desc - Trigger structure with a timer.
+ *
+ * @return Time in ns.
+*/
+static int64_t iio_hw_trig_time_ns(struct iio_hw_trig *desc)
+{
+	uint32_t freq = desc->timer->freq_hz;
+	uint32_t counter;
+	uint32_t delta;
+
+	if (no_os_timer_counter_get(desc->timer, &counter))
+		counter = desc->last_counter;
+
+	if (counter < desc->last_counter && desc->timer->ticks_count)
+		delta = desc->timer->ticks_count - desc->last_counter + counter;
+	else
+		delta = counter - desc->last_counter;
+
+	desc->last_counter = counter;
+	desc->ticks += delta;
+
+	return (desc->ticks / freq) * 1000000000ull +
+	       (desc->ticks % freq) * 1000000000ull / freq;
+}
+
+/**
+ * @brief Update the missed triggers and the jitter from the last period.
+ *
+ * @param desc     - Trigger structure.
+ * @param interval - Time since the previous trigger in ns.
+*/
+static void iio_hw_trig_period_update(struct iio_hw_trig *desc,
+				      uint64_t interval)
+{
+	uint32_t period = desc->period_ns;
+	uint32_t jitter;
+
+	if (!period) {
+		desc->period_ns = no_os_min(interval, (uint64_t)UINT32_MAX);
+		return;
+	}
+
+	if (interval > period + period / 2) {
+		desc->stats.missed += (interval + period / 2) / period - 1;
+		return;
+	}
+
+	jitter = interval > period ? interval - period : period - interval;
+	if (jitter > desc->stats.max_jitter_ns)
+		desc->stats.max_jitter_ns = jitter;
+}
+
+/**
+ * @brief Update the handler latency statistics.
+ *
+ * @param desc    - Trigger structure.
+ * @param latency - Time from the interrupt entry to the end of the handler.
+*/
+static void iio_hw_trig_latency_update(struct iio_hw_trig *desc,
+				       uint64_t latency)
+{
+	uint32_t us = latency / 1000;
+	uint32_t bin = 0;
+
+	while (us && bin < IIO_HW_TRIG_LATENCY_BINS - 1) {
+		us >>= 1;
+		bin++;
+	}
+	desc->stats.latency_hist[bin]++;
+
+	if (latency > desc->stats.max_latency_ns)
+		desc->stats.max_latency_ns = no_os_min(latency, (uint64_t)UINT32_MAX);
+}
+
 /**
  * @brief Initialize hardware trigger.
  *
@@ -56,6 +136,9 @@ int iio_hw_trig_init(struct iio_hw_trig **iio_trig,
 	if (!init_param->name)
 		return -EINVAL;
 
+	if (init_param->timer && !init_param->timer->freq_hz)
+		return -EINVAL;
+
 	trig_desc = (struct iio_hw_trig*)no_os_calloc(1, sizeof(*trig_desc));
 	if (!trig_desc)
 		return -ENOMEM;
@@ -65,6 +148,10 @@ int iio_hw_trig_init(struct iio_hw_trig **iio_trig,
 	trig_desc->irq_ctrl = init_param->irq_ctrl;
 	trig_desc->irq_id = init_param->irq_id;
 	trig_desc->irq_trig_lvl = init_param->irq_trig_lvl;
+	trig_desc->timer = init_param->timer;
+	trig_desc->period_ns = init_param->period_ns;
+	if (trig_desc->timer)
+		no_os_timer_counter_get(trig_desc->timer, &trig_desc->last_counter);
 
 	struct no_os_callback_desc irq_cb = {
 		.callback = iio_hw_trig_handler,
@@ -130,18 +217,116 @@ int iio_trig_disable(void *trig)
 
 /**
  * @brief Trigger interrupt handler. This function will be called when a system
- * interrupt is asserted for the configured trigger.
+ * interrupt is asserted for the configured trigger. If the trigger has a timer,
+ * the scans are timestamped with the time of the interrupt entry and the
+ * trigger statistics are updated.
  *
  * @param trig - Trigger structure which is linked to this handler.
 */
 void iio_hw_trig_handler(void *trig)
 {
+	int64_t start, end;
+	int ret;
+
 	if (!trig)
 		return;
 
 	struct iio_hw_trig *desc = trig;
 
-	iio_process_trigger_type(desc->iio_desc, desc->name);
+	if (!desc->timer) {
+		iio_process_trigger_type(desc->iio_desc, desc->name);
+		return;
+	}
+
+	/* Interrupted by a new trigger before finishing the previous one */
+	if (desc->in_handler) {
+		desc->stats.missed++;
+		return;
+	}
+	desc->in_handler = true;
+
+	start = iio_hw_trig_time_ns(desc);
+	if (desc->stats.triggers)
+		iio_hw_trig_period_update(desc, start - desc->last_timestamp);
+	desc->last_timestamp = start;
+	desc->stats.triggers++;
+
+	ret = iio_process_trigger_timestamp(desc->iio_desc, desc->name, start);
+	if (ret == -EBUSY)
+		desc->stats.missed++;
+
+	end = iio_hw_trig_time_ns(desc);
+	iio_hw_trig_latency_update(desc, end - start);
+
+	desc->in_handler = false;
+}
+
+/**
+ * @brief Handles the read request for the trigger statistics attributes.
+ *
+ * @param trig    - The iio trigger structure.
+ * @param buf     - Command buffer to be filled with the data to be read.
+ * @param len     - Length of the received command buffer in bytes.
+ * @param channel - Command channel info (is NULL).
+ * @param priv    - Statistic id, see enum iio_hw_trig_stat.
+ *
+ * @return ret    - Number of bytes written in buf, negative error code
+ * 		    otherwise.
+*/
+int iio_hw_trig_stats_show(void *trig, char *buf, uint32_t len,
+			   const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct iio_hw_trig_stats *stats;
+	uint32_t cnt = 0;
+	uint32_t i;
+
+	if (!trig)
+		return -EINVAL;
+
+	stats = &((struct iio_hw_trig *)trig)->stats;
+
+	switch (priv) {
+	case IIO_HW_TRIG_STAT_TRIGGERS:
+		return snprintf(buf, len, "%"PRIu32"", stats->triggers);
+	case IIO_HW_TRIG_STAT_MISSED:
+		return snprintf(buf, len, "%"PRIu32"", stats->missed);
+	case IIO_HW_TRIG_STAT_MAX_JITTER:
+		return snprintf(buf, len, "%"PRIu32"", stats->max_jitter_ns);
+	case IIO_HW_TRIG_STAT_MAX_LATENCY:
+		return snprintf(buf, len, "%"PRIu32"", stats->max_latency_ns);
+	case IIO_HW_TRIG_STAT_LATENCY_HIST:
+		for (i = 0; i < IIO_HW_TRIG_LATENCY_BINS && cnt < len; i++)
+			cnt += snprintf(buf + cnt, len - cnt, i ? " %"PRIu32"" : "%"PRIu32"",
+					stats->latency_hist[i]);
+		return no_os_min(cnt, len);
+	default:
+		return -EINVAL;
+	}
+}
+
+/**
+ * @brief Handles the write request for the trigger statistics attributes.
+ * Any write resets all the statistics.
+ *
+ * @param trig    - The iio trigger structure.
+ * @param buf     - Command buffer to be filled with the data to be written.
+ * @param len     - Length of the received command buffer in bytes.
+ * @param channel - Command channel info (is NULL).
+ * @param priv    - Statistic id, see enum iio_hw_trig_stat.
+ *
+ * @return ret    - Number of bytes consumed, negative error code otherwise.
+*/
+int iio_hw_trig_stats_store(void *trig, char *buf, uint32_t len,
+			    const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct iio_hw_trig *desc = trig;
+
+	if (!desc)
+		return -EINVAL;
+
+	memset(&desc->stats, 0, sizeof(desc->stats));
+
+	return len;
 }
 
 /**
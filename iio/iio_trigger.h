@@ -37,9 +37,77 @@
 #include "iio.h"
 #include "iio_types.h"
 #include "no_os_irq.h"
+#include "no_os_timer.h"
 
 #define TRIG_MAX_NAME_SIZE 20
 
+/* Handler latency histogram bins: < 1us, [1us, 2us), [2us, 4us), ...,
+ * the last one counting everything above */
+#define IIO_HW_TRIG_LATENCY_BINS 8
+
+/* Trigger attributes exposing the statistics of a hardware trigger. Writing
+ * any of them resets the statistics. */
+#define IIO_HW_TRIG_STATS_ATTRIBUTES					\
+	{								\
+		.name = "triggers",					\
+		.priv = IIO_HW_TRIG_STAT_TRIGGERS,			\
+		.show = iio_hw_trig_stats_show,				\
+		.store = iio_hw_trig_stats_store,			\
+	},								\
+	{								\
+		.name = "missed_triggers",				\
+		.priv = IIO_HW_TRIG_STAT_MISSED,			\
+		.show = iio_hw_trig_stats_show,				\
+		.store = iio_hw_trig_stats_store,			\
+	},								\
+	{								\
+		.name = "max_jitter_ns",				\
+		.priv = IIO_HW_TRIG_STAT_MAX_JITTER,			\
+		.show = iio_hw_trig_stats_show,				\
+		.store = iio_hw_trig_stats_store,			\
+	},								\
+	{								\
+		.name = "max_latency_ns",				\
+		.priv = IIO_HW_TRIG_STAT_MAX_LATENCY,			\
+		.show = iio_hw_trig_stats_show,				\
+		.store = iio_hw_trig_stats_store,			\
+	},								\
+	{								\
+		.name = "latency_histogram",				\
+		.priv = IIO_HW_TRIG_STAT_LATENCY_HIST,			\
+		.show = iio_hw_trig_stats_show,				\
+		.store = iio_hw_trig_stats_store,			\
+	}
+
+/**
+ * @enum iio_hw_trig_stat
+ * @brief Hardware trigger statistics exposed as attributes
+ */
+enum iio_hw_trig_stat {
+	IIO_HW_TRIG_STAT_TRIGGERS,
+	IIO_HW_TRIG_STAT_MISSED,
+	IIO_HW_TRIG_STAT_MAX_JITTER,
+	IIO_HW_TRIG_STAT_MAX_LATENCY,
+	IIO_HW_TRIG_STAT_LATENCY_HIST,
+};
+
+/**
+ * @struct iio_hw_trig_stats
+ * @brief Hardware trigger statistics, only updated when a timer is set
+ */
+struct iio_hw_trig_stats {
+	/** Number of handled triggers */
+	uint32_t triggers;
+	/** Triggers lost because of a late handler or an overrun */
+	uint32_t missed;
+	/** Largest deviation of the trigger period from the expected one */
+	uint32_t max_jitter_ns;
+	/** Largest time from the interrupt entry to the end of the handler */
+	uint32_t max_latency_ns;
+	/** Handler latency histogram, see IIO_HW_TRIG_LATENCY_BINS */
+	uint32_t latency_hist[IIO_HW_TRIG_LATENCY_BINS];
+};
+
 /**
  * @struct iio_hw_trig
  * @brief IIO hardware trigger structure
@@ -55,6 +123,20 @@ struct iio_hw_trig {
 	enum no_os_irq_trig_level irq_trig_lvl;
 	/** Device trigger name */
 	char name[TRIG_MAX_NAME_SIZE + 1];
+	/** Timer used for timestamps and statistics, may be NULL */
+	struct no_os_timer_desc *timer;
+	/** Expected trigger period in ns, 0 to use the first measured one */
+	uint32_t period_ns;
+	/** Trigger statistics */
+	struct iio_hw_trig_stats stats;
+	/** Timer ticks counted since the trigger was initialized */
+	uint64_t ticks;
+	/** Timer counter value at the last timestamp */
+	uint32_t last_counter;
+	/** Timestamp of the last trigger in ns, 0 if none yet */
+	int64_t last_timestamp;
+	/** Set while the trigger handler runs */
+	volatile bool in_handler;
 };
 
 /**
@@ -87,6 +169,15 @@ struct iio_hw_trig_init_param {
 	struct iio_hw_trig_cb_info cb_info;
 	/** Device trigger name */
 	const char *name;
+	/**
+	 * Optional running timer. When set, the counter is read at interrupt
+	 * entry to timestamp the scans and to measure the trigger period and
+	 * the handler latency. The trigger period must be shorter than the
+	 * timer wrap-around period.
+	 */
+	struct no_os_timer_desc *timer;
+	/** Expected trigger period in ns, 0 to use the first measured one */
+	uint32_t period_ns;
 };
 
 /**
@@ -123,6 +214,12 @@ int iio_trig_disable(void *trig);
 void iio_hw_trig_handler(void *trig);
 /** API to remove a hardware trigger */
 int iio_hw_trig_remove(struct iio_hw_trig *trig);
+/** API to show the hardware trigger statistics */
+int iio_hw_trig_stats_show(void *trig, char *buf, uint32_t len,
+			   const struct iio_ch_info *channel, intptr_t priv);
+/** API to reset the hardware trigger statistics */
+int iio_hw_trig_stats_store(void *trig, char *buf, uint32_t len,
+			    const struct iio_ch_info *channel, intptr_t priv);
 #endif
 
 /** API to initialize a software trigger */
@@ -70,6 +70,7 @@ enum iio_chan_type {
 	IIO_DELTA_ANGL,
 	IIO_DELTA_VELOCITY,
 	IIO_WEIGHT,
+	IIO_TIMESTAMP,
 };
 
 /**
@@ -187,6 +188,23 @@ struct iio_channel {
 	bool			diferential;
 };
 
+/*
+ * Timestamp channel, in ns. When it is enabled, iio_buffer_push_scan fills
+ * it with the timestamp of the trigger that started the scan, so the data
+ * passed by the driver only needs room for it.
+ */
+#define IIO_CHAN_SOFT_TIMESTAMP(_si) {					\
+	.name = "timestamp",						\
+	.ch_type = IIO_TIMESTAMP,					\
+	.channel = -1,							\
+	.scan_index = _si,						\
+	.scan_type = &(struct scan_type) {				\
+		.sign = 's',						\
+		.realbits = 64,						\
+		.storagebits = 64,					\
+	},								\
+}
+
 enum iio_buffer_direction {
 	IIO_DIRECTION_INPUT,
 	IIO_DIRECTION_OUTPUT
@@ -212,6 +230,14 @@ struct iio_buffer {
 	struct no_os_circular_buffer *buf;
 	/* Stores cyclic buffer specific information */
 	struct iio_cyclic_buffer_info cyclic_info;
+	/* Timestamp in ns of the trigger that started the current scan */
+	int64_t timestamp;
+	/* Set if the timestamp channel is enabled */
+	bool timestamp_en;
+	/* Offset of the timestamp channel in a scan */
+	uint32_t timestamp_offset;
+	/* Space returned by the last iio_buffer_reserve_scans */
+	void *reserved;
 };
 
 struct iio_device_data {
@@ -340,6 +340,10 @@ int32_t iiod_copy_ops(struct iiod_ops *ops, struct iiod_ops *new_ops)
 					       dummy_close);
 	ops->push_buffer = SET_DUMMY_IF_NULL(new_ops->push_buffer,
 					     dummy_close);
+	/* Zero copy reads are used only if both are set */
+	ops->get_read_block = new_ops->get_read_block;
+	ops->read_block_done = new_ops->read_block_done;
+	ops->get_xml_chunk = new_ops->get_xml_chunk;
 
 	return 0;
 }
@@ -357,10 +361,15 @@ int32_t iiod_init(struct iiod_desc **desc, struct iiod_init_param *param)
 		return -ENOMEM;
 
 	ret = iiod_copy_ops(&ldesc->ops, param->ops);
-	if (NO_OS_IS_ERR_VALUE(ret)) {
-		free(ldesc);
-
-		return ret;
+	if (NO_OS_IS_ERR_VALUE(ret))
+		goto free_desc;
+
+	ldesc->max_conns = param->max_conns ? param->max_conns :
+			   IIOD_MAX_CONNECTIONS;
+	ldesc->conns = calloc(ldesc->max_conns, sizeof(*ldesc->conns));
+	if (!ldesc->conns) {
+		ret = -ENOMEM;
+		goto free_desc;
 	}
 
 	ldesc->xml = param->xml;
@@ -371,10 +380,19 @@ int32_t iiod_init(struct iiod_desc **desc, struct iiod_init_param *param)
 	*desc = ldesc;
 
 	return 0;
+
+free_desc:
+	free(ldesc);
+
+	return ret;
 }
 
 void iiod_remove(struct iiod_desc *desc)
 {
+	if (!desc)
+		return;
+
+	free(desc->conns);
 	free(desc);
 }
 
@@ -399,7 +417,7 @@ int32_t iiod_conn_add(struct iiod_desc *desc, struct iiod_conn_data *data,
 	if (!desc || !new_conn_id)
 		return -EINVAL;
 
-	for (i = 0; i < IIOD_MAX_CONNECTIONS; ++i)
+	for (i = 0; i < desc->max_conns; ++i)
 		if (!desc->conns[i].used) {
 			conn = &desc->conns[i];
 			memset(conn, 0, sizeof(*conn));
@@ -420,14 +438,35 @@ int32_t iiod_conn_add(struct iiod_desc *desc, struct iiod_conn_data *data,
 	return -EBUSY;
 }
 
+/*
+ * Give back the device block of an interrupted zero copy read, otherwise the
+ * device buffer stays busy until it is closed.
+ */
+static void iiod_read_block_release(struct iiod_desc *desc,
+				    struct iiod_conn_priv *conn)
+{
+	struct iiod_ctx ctx = IIOD_CTX(desc, conn);
+
+	if (!conn->nb_buf.buf)
+		return;
+
+	memset(&conn->nb_buf, 0, sizeof(conn->nb_buf));
+	desc->ops.read_block_done(&ctx, conn->cmd_data.device);
+}
+
 int32_t iiod_conn_remove(struct iiod_desc *desc, uint32_t conn_id,
 			 struct iiod_conn_data *data)
 {
-	if (!desc || conn_id > IIOD_MAX_CONNECTIONS ||
+	if (!desc || conn_id >= desc->max_conns ||
 	    !desc->conns[conn_id].used)
 		return -EINVAL;
 	struct iiod_conn_priv *conn;
 	conn = &desc->conns[conn_id];
+	if (conn->state == IIOD_RW_BUF &&
+	    conn->cmd_data.cmd == IIOD_CMD_READBUF &&
+	    desc->ops.get_read_block && desc->ops.read_block_done)
+		iiod_read_block_release(desc, conn);
+
 	data->conn = conn->conn;
 	data->len = conn->payload_buf_len;
 	data->buf = conn->payload_buf;
@@ -531,11 +570,67 @@ static int32_t do_read_buff_delayed(struct iiod_desc *desc,
 	return 0;
 }
 
+/*
+ * Send data directly from the device buffer without copying it in
+ * payload_buf. When the data wraps around the end of the device buffer, both
+ * regions are sent back to back in the same call.
+ */
+static int32_t do_read_buff_zc(struct iiod_desc *desc,
+			       struct iiod_conn_priv *conn)
+{
+	struct iiod_ctx ctx = IIOD_CTX(desc, conn);
+	uint32_t min_bytes;
+	int32_t ret;
+
+	while (conn->cmd_data.bytes_count) {
+		if (!conn->nb_buf.buf) {
+			/*
+			 * On network wait for all the requested data in
+			 * order to reduce the ammount of network traffic.
+			 */
+			if (desc->phy_type == USE_NETWORK)
+				min_bytes = conn->cmd_data.bytes_count;
+			else
+				min_bytes = 1;
+
+			ret = desc->ops.get_read_block(&ctx,
+						       conn->cmd_data.device,
+						       &conn->nb_buf.buf,
+						       min_bytes,
+						       conn->cmd_data.bytes_count);
+			if (NO_OS_IS_ERR_VALUE(ret))
+				return ret;
+
+			conn->nb_buf.len = ret;
+			conn->nb_buf.idx = 0;
+		}
+
+		ret = rw_iiod_buff(desc, conn, &conn->nb_buf, IIOD_WR);
+		if (ret == -EAGAIN)
+			return ret;
+		if (NO_OS_IS_ERR_VALUE(ret)) {
+			iiod_read_block_release(desc, conn);
+			return ret;
+		}
+
+		conn->cmd_data.bytes_count -= conn->nb_buf.len;
+		memset(&conn->nb_buf, 0, sizeof(conn->nb_buf));
+		ret = desc->ops.read_block_done(&ctx, conn->cmd_data.device);
+		if (NO_OS_IS_ERR_VALUE(ret))
+			return ret;
+	}
+
+	return 0;
+}
+
 static int32_t do_read_buff(struct iiod_desc *desc, struct iiod_conn_priv *conn)
 {
 	struct iiod_ctx ctx;
 	int32_t ret, len;
 
+	if (desc->ops.get_read_block && desc->ops.read_block_done)
+		return do_read_buff_zc(desc, conn);
+
 	/*
 	 * When using the network backend wait for a whole buffer to be filled
 	 * before sending in order to reduce the ammount of network traffic.
@@ -643,8 +738,12 @@ static int32_t iiod_run_cmd(struct iiod_desc *desc,
 	case IIOD_CMD_PRINT:
 		conn->res.val = desc->xml_len;
 		conn->res.write_val = 1;
-		conn->res.buf.buf = desc->xml;
-		conn->res.buf.len = desc->xml_len;
+		if (desc->ops.get_xml_chunk) {
+			conn->res.xml_chunked = true;
+		} else {
+			conn->res.buf.buf = desc->xml;
+			conn->res.buf.len = desc->xml_len;
+		}
 		break;
 	case IIOD_CMD_VERSION:
 		conn->res.buf.buf = IIOD_VERSION;
@@ -735,6 +834,46 @@ end:
 	return ret;
 }
 
+/*
+ * Send the xml chunk by chunk, as returned by get_xml_chunk. Non blocking.
+ * res.buf holds the chunk being sent and res.xml_idx the total sent bytes.
+ */
+static int32_t iiod_send_xml(struct iiod_desc *desc,
+			     struct iiod_conn_priv *conn)
+{
+	struct iiod_ctx ctx = IIOD_CTX(desc, conn);
+	struct iiod_buff *buf = &conn->res.buf;
+	uint32_t idx;
+	int32_t ret;
+
+	while (conn->res.xml_idx < desc->xml_len) {
+		if (buf->idx == buf->len) {
+			ret = desc->ops.get_xml_chunk(&ctx, conn->res.xml_idx,
+						      &buf->buf);
+			if (NO_OS_IS_ERR_VALUE(ret))
+				return ret;
+			if (!ret)
+				return -EIO;
+
+			buf->len = no_os_min((uint32_t)ret,
+					     desc->xml_len - conn->res.xml_idx);
+			buf->idx = 0;
+		}
+
+		idx = buf->idx;
+		ret = rw_iiod_buff(desc, conn, buf, IIOD_WR);
+		conn->res.xml_idx += buf->idx - idx;
+		if (NO_OS_IS_ERR_VALUE(ret))
+			return ret;
+	}
+
+	/* Only the line ending is left */
+	buf->len = 0;
+	buf->idx = 0;
+
+	return rw_iiod_buff(desc, conn, buf, IIOD_ENDL);
+}
+
 /*
  * Function will return SUCCESS when a state was processed.
  * If a state is still in processing state, it will return -EAGAIN.
@@ -804,8 +943,12 @@ static int32_t iiod_run_state(struct iiod_desc *desc,
 			}
 		}
 		/* Send buf from result. Non blocking */
-		if (conn->res.buf.buf &&
-		    conn->res.buf.idx < conn->res.buf.len) {
+		if (conn->res.xml_chunked) {
+			ret = iiod_send_xml(desc, conn);
+			if (NO_OS_IS_ERR_VALUE(ret))
+				return ret;
+		} else if (conn->res.buf.buf &&
+			   conn->res.buf.idx < conn->res.buf.len) {
 			ret = rw_iiod_buff(desc, conn, &conn->res.buf,
 					   IIOD_WR | IIOD_ENDL);
 			if (NO_OS_IS_ERR_VALUE(ret))
@@ -814,9 +957,11 @@ static int32_t iiod_run_state(struct iiod_desc *desc,
 
 		if (conn->cmd_data.cmd != IIOD_CMD_READBUF &&
 		    conn->cmd_data.cmd != IIOD_CMD_WRITEBUF) {
-			if (conn->is_cyclic_buffer && conn->cmd_data.cmd != IIOD_CMD_OPEN)
+			if (conn->is_cyclic_buffer && conn->cmd_data.cmd != IIOD_CMD_OPEN) {
+				/* Don't keep the sent result in nb_buf */
+				memset(&conn->nb_buf, 0, sizeof(conn->nb_buf));
 				conn->state = IIOD_PUSH_CYCLIC_BUFFER;
-			else
+			} else
 				conn->state = IIOD_LINE_DONE;
 		} else {
 			/* Preapre for IIOD_RW_BUF state */
@@ -907,7 +1052,7 @@ int32_t iiod_conn_step(struct iiod_desc *desc, uint32_t conn_id)
 	struct iiod_conn_priv *conn;
 	int32_t ret;
 
-	if (!desc || conn_id > IIOD_MAX_CONNECTIONS ||
+	if (!desc || conn_id >= desc->max_conns ||
 	    !desc->conns[conn_id].used)
 		return -EINVAL;
 
@@ -925,3 +1070,53 @@ int32_t iiod_conn_step(struct iiod_desc *desc, uint32_t conn_id)
 
 	return ret;
 }
+
+/* True if a READBUF has device data left to send */
+static bool iiod_read_buff_sending(struct iiod_desc *desc,
+				   struct iiod_conn_priv *conn)
+{
+	if (conn->nb_buf.idx >= conn->nb_buf.len)
+		return false;
+
+	/* The delayed read sends once all the requested data is read */
+	if (desc->phy_type == USE_NETWORK &&
+	    !(desc->ops.get_read_block && desc->ops.read_block_done))
+		return conn->nb_buf.len >= conn->cmd_data.bytes_count;
+
+	return true;
+}
+
+int32_t iiod_conn_wait_events(struct iiod_desc *desc, uint32_t conn_id,
+			      uint32_t *events)
+{
+	struct iiod_conn_priv *conn;
+
+	if (!desc || !events || conn_id >= desc->max_conns ||
+	    !desc->conns[conn_id].used)
+		return -EINVAL;
+
+	conn = &desc->conns[conn_id];
+	switch (conn->state) {
+	case IIOD_READING_LINE:
+	case IIOD_READING_WRITE_DATA:
+		*events = IIOD_CONN_WAIT_RECV;
+		break;
+	case IIOD_WRITING_CMD_RESULT:
+		*events = IIOD_CONN_WAIT_SEND;
+		break;
+	case IIOD_RW_BUF:
+		if (conn->cmd_data.cmd == IIOD_CMD_WRITEBUF)
+			*events = IIOD_CONN_WAIT_RECV;
+		else if (iiod_read_buff_sending(desc, conn))
+			*events = IIOD_CONN_WAIT_SEND;
+		else
+			*events = IIOD_CONN_WAIT_DATA;
+		break;
+	default:
+		/* Cyclic buffers are pushed on every step */
+		*events = 0;
+		break;
+	}
+
+	return 0;
+}
@@ -39,11 +39,17 @@
 
 #include "iio.h"
 
-/* Maximum nomber of iiod connections to allocate simultaneously */
+/* Default number of iiod connections to allocate simultaneously */
 #define IIOD_MAX_CONNECTIONS	10
 #define IIOD_VERSION		"1.1.0000000"
 #define IIOD_VERSION_LEN	(sizeof(IIOD_VERSION) - 1)
 
+/* Events a connection waits for, returned by iiod_conn_wait_events */
+#define IIOD_CONN_WAIT_RECV	0x1
+#define IIOD_CONN_WAIT_SEND	0x2
+/* Waits for device data, which no socket event reports */
+#define IIOD_CONN_WAIT_DATA	0x4
+
 #define MAX_DEV_ID		64
 #define MAX_TRIG_ID		64
 #define MAX_CHN_ID		64
@@ -116,6 +122,25 @@ struct iiod_ops {
 			   uint32_t bytes);
 	/* Called to notify that buffer must be refiiled */
 	int (*refill_buffer)(struct iiod_ctx *ctx, const char *device);
+	/*
+	 * Optional zero copy alternative to read_buffer.
+	 * Set buf to the address of at most max_bytes of contiguous data from
+	 * the opened buffer and return their number, or -EAGAIN while less than
+	 * min_bytes are available. Data must remain valid until
+	 * read_block_done is called.
+	 */
+	int (*get_read_block)(struct iiod_ctx *ctx, const char *device,
+			      char **buf, uint32_t min_bytes,
+			      uint32_t max_bytes);
+	/* Release the data returned by get_read_block */
+	int (*read_block_done)(struct iiod_ctx *ctx, const char *device);
+	/*
+	 * Optional. Set buf to the context xml starting at offset and return
+	 * the number of contiguous bytes available from there. If set, the
+	 * xml from iiod_init_param is not used and PRINT is sent in chunks.
+	 * Data must remain valid until iiod_remove is called.
+	 */
+	int (*get_xml_chunk)(struct iiod_ctx *ctx, uint32_t offset, char **buf);
 
 	/* Write data to opened buffer */
 	int (*write_buffer)(struct iiod_ctx *ctx, const char *device,
@@ -163,13 +188,15 @@ struct iiod_init_param {
 	void *instance;
 	/*
 	 * Xml description of the context and devices. It should exist until
-	 * iiod_remove is called
+	 * iiod_remove is called. Can be NULL if ops->get_xml_chunk is set.
 	 */
 	char *xml;
 	/* Size of xml in bytes */
 	uint32_t xml_len;
 	/* Backend used by IIOD */
 	enum physical_link_type phy_type;
+	/* Size of the connection pool. If 0, IIOD_MAX_CONNECTIONS is used */
+	uint32_t max_conns;
 };
 
 /* Initialize desc. */
@@ -188,5 +215,11 @@ int32_t iiod_conn_remove(struct iiod_desc *desc, uint32_t conn_id,
 			 struct iiod_conn_data *data);
 /* Advance in the state machine of a connection. Will not block */
 int32_t iiod_conn_step(struct iiod_desc *desc, uint32_t conn_id);
+/*
+ * Get the I/O events needed for the connection to make progress.
+ * events is 0 when the connection can be stepped without waiting for I/O.
+ */
+int32_t iiod_conn_wait_events(struct iiod_desc *desc, uint32_t conn_id,
+			      uint32_t *events);
 
 #endif //IIOD_H
@@ -107,6 +107,10 @@ struct iiod_run_cmd_result {
 	bool write_val;
 	/* If buf.len != 0 buf has to be sent */
 	struct iiod_buff buf;
+	/* Set when the xml is sent in chunks from get_xml_chunk */
+	bool xml_chunked;
+	/* Number of xml bytes already sent */
+	uint32_t xml_idx;
 };
 
 /* Internal structure to handle a connection state */
@@ -162,7 +166,9 @@ struct iiod_conn_priv {
 /* Private iiod information */
 struct iiod_desc {
 	/* Pool of iiod connections */
-	struct iiod_conn_priv conns[IIOD_MAX_CONNECTIONS];
+	struct iiod_conn_priv *conns;
+	/* Number of connections in the pool */
+	uint32_t max_conns;
 	/* Application operations */
 	struct iiod_ops ops;
 	/* Application instance */
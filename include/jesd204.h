@@ -245,10 +245,25 @@ struct jesd204_topology_dev {
 };
 
 /* no-OS specific */
+/**
+ * @struct jesd204_topology
+ * @brief JESD204 topology
+ * @param dev_top:		top-level device of the topology
+ * @param devs:			the other devices of the topology
+ * @param devs_number:		number of entries in @devs
+ * @param op_time_us:		wall time spent in each state during the last
+ *				bring-up, in microseconds
+ * @param parallel_ops:		run the ops of the devices other than the top one
+ *				concurrently, one task/thread per device, on
+ *				FreeRTOS and Linux; the top device ops and SYSREF
+ *				run once all of them are done
+ */
 struct jesd204_topology {
 	struct jesd204_dev_top		*dev_top;
 	struct jesd204_topology_dev	*devs;
 	unsigned int			devs_number;
+	uint32_t			op_time_us[__JESD204_MAX_OPS];
+	bool				parallel_ops;
 };
 
 /* no-OS specific */
@@ -272,6 +287,14 @@ int jesd204_fsm_start(struct jesd204_topology *topology, unsigned int link_idx);
 /* no-OS specific */
 int jesd204_fsm_stop(struct jesd204_topology *topology, unsigned int link_idx);
 
+/* no-OS specific */
+int jesd204_fsm_resume(struct jesd204_topology *topology, unsigned int link_idx,
+		       enum jesd204_dev_op op);
+
+/* no-OS specific */
+int jesd204_fsm_rollback(struct jesd204_topology *topology,
+			 unsigned int link_idx, enum jesd204_dev_op op);
+
 void *jesd204_dev_priv(struct jesd204_dev *jdev);
 
 int jesd204_link_get_lmfc_lemc_rate(struct jesd204_link *lnk,
@@ -46,4 +46,48 @@ void *no_os_calloc(size_t nitems, size_t size);
  * no_os_malloc */
 void no_os_free(void *ptr);
 
+#ifdef NO_OS_ALLOC_POOL
+#include <stdint.h>
+
+/**
+ * @struct no_os_alloc_pool_stats
+ * @brief Usage of a fixed-size block pool.
+ */
+struct no_os_alloc_pool_stats {
+	/** Size of a block in bytes */
+	uint32_t block_size;
+	/** Number of blocks in the pool */
+	uint32_t nb_blocks;
+	/** Number of blocks currently allocated */
+	uint32_t used;
+	/** Maximum number of blocks allocated at the same time */
+	uint32_t high_water;
+	/** Allocations that found the pool empty */
+	uint32_t failures;
+};
+
+/**
+ * @struct no_os_alloc_arena_stats
+ * @brief Usage of the init-time arena.
+ */
+struct no_os_alloc_arena_stats {
+	/** Size of the arena in bytes */
+	uint32_t size;
+	/** Bytes handed out from the arena */
+	uint32_t used;
+	/** Allocations that didn't fit in the arena */
+	uint32_t failures;
+};
+
+/* Stop serving allocations from the arena. Call when initialization is done */
+void no_os_alloc_arena_lock(void);
+
+/* Get the usage of the pool with index idx */
+int no_os_alloc_get_pool_stats(uint32_t idx,
+			       struct no_os_alloc_pool_stats *stats);
+
+/* Get the usage of the arena */
+void no_os_alloc_get_arena_stats(struct no_os_alloc_arena_stats *stats);
+#endif /* NO_OS_ALLOC_POOL */
+
 #endif // _NO_OS_ALLOC_H_
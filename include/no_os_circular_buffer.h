@@ -36,13 +36,18 @@
 #define _NO_OS_CIRCULAR_BUFFER_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /**
  * @struct no_os_cb_ptr
  * @brief Circular buffer pointer
  */
 struct no_os_cb_ptr {
-	/** Index of data in the buffer */
+	/**
+	 * Index of data in the buffer.
+	 * In lock-free mode it is a free running counter masked with
+	 * no_os_circular_buffer.mask to get the index.
+	 */
 	uint32_t	idx;
 	/** Counts the number of times idx exceeds the liniar buffer */
 	uint32_t	spin_count;
@@ -52,6 +57,17 @@ struct no_os_cb_ptr {
 	uint32_t	async_size;
 };
 
+/**
+ * @struct no_os_cb_stats
+ * @brief Circular buffer statistics. Updated only in lock-free mode.
+ */
+struct no_os_cb_stats {
+	/** Number of writes dropped because the buffer was full */
+	uint32_t	overruns;
+	/** Maximum number of bytes stored in the buffer */
+	uint32_t	high_water;
+};
+
 /**
  * @struct no_os_circular_buffer
  * @brief Circular buffer descriptor
@@ -65,13 +81,27 @@ struct no_os_circular_buffer {
 	struct no_os_cb_ptr	write;
 	/** Read pointer */
 	struct no_os_cb_ptr	read;
+	/** Set when configured with no_os_cb_cfg_lf */
+	bool		lock_free;
+	/** size - 1 in lock-free mode */
+	uint32_t	mask;
+	/** Statistics. Written only by the producer */
+	struct no_os_cb_stats	stats;
 };
 
 int32_t no_os_cb_init(struct no_os_circular_buffer **desc, uint32_t size);
 /* Configure cb structure with given parameters without memory allocation */
 int32_t no_os_cb_cfg(struct no_os_circular_buffer *desc, int8_t *buf,
 		     uint32_t size);
+/*
+ * Configure cb structure as a lock-free single producer single consumer
+ * buffer. Size must be a power of 2.
+ */
+int32_t no_os_cb_cfg_lf(struct no_os_circular_buffer *desc, int8_t *buf,
+			uint32_t size);
 int32_t no_os_cb_remove(struct no_os_circular_buffer *desc);
+int32_t no_os_cb_get_stats(struct no_os_circular_buffer *desc,
+			   struct no_os_cb_stats *stats);
 int32_t no_os_cb_size(struct no_os_circular_buffer *desc, uint32_t *size);
 
 int32_t no_os_cb_write(struct no_os_circular_buffer *desc, const void *data,
@@ -84,6 +114,8 @@ int32_t no_os_cb_prepare_async_write(struct no_os_circular_buffer *desc,
 				     void **write_buff,
 				     uint32_t *raw_size_avilable);
 int32_t no_os_cb_end_async_write(struct no_os_circular_buffer *desc);
+int32_t no_os_cb_end_async_write_partial(struct no_os_circular_buffer *desc,
+		uint32_t size);
 
 int32_t no_os_cb_prepare_async_read(struct no_os_circular_buffer *desc,
 				    uint32_t raw_size_to_read,
@@ -38,11 +38,28 @@
 
 #define NO_OS_CRC8_TABLE_SIZE 256
 
+/* x^8 + x^2 + x^1 + 1, msb-first */
+#define NO_OS_CRC8_POLY07 0x07
+
 #define NO_OS_DECLARE_CRC8_TABLE(_table) \
 	static uint8_t _table[NO_OS_CRC8_TABLE_SIZE]
 
+#define NO_OS_DECLARE_CRC8_SLICE_TABLE(_table, _nb_slices) \
+	static uint8_t _table[(_nb_slices) * NO_OS_CRC8_TABLE_SIZE]
+
+/* Constant lookup table for NO_OS_CRC8_POLY07 */
+extern const uint8_t no_os_crc8_poly07_table[NO_OS_CRC8_TABLE_SIZE];
+
 void no_os_crc8_populate_msb(uint8_t * table, const uint8_t polynomial);
 uint8_t no_os_crc8(const uint8_t * table, const uint8_t *pdata, size_t nbytes,
 		   uint8_t crc);
+void no_os_crc8_populate_slices_msb(uint8_t *tables, uint8_t nb_slices,
+				    const uint8_t polynomial);
+uint8_t no_os_crc8_slice(const uint8_t *tables, uint8_t nb_slices,
+			 const uint8_t *pdata, size_t nbytes, uint8_t crc);
+/* Hardware CRC hook. Returns -ENOSYS unless implemented by the platform */
+int no_os_crc8_hw(uint8_t polynomial, const uint8_t *pdata, size_t nbytes,
+		  uint8_t crc, uint8_t *result);
+uint8_t no_os_crc8_poly07(const uint8_t *pdata, size_t nbytes, uint8_t crc);
 
 #endif // _NO_OS_CRC8_H_
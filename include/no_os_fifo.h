@@ -34,25 +34,59 @@
 #define _NO_OS_FIFO_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /**
- * @struct no_os_fifo_element
- * @brief Structure holding the fifo element parameters.
+ * @struct no_os_fifo
+ * @brief Ring buffer FIFO.
+ *
+ * One producer and one consumer may run in different contexts (e.g. an
+ * interrupt handler and the main loop) without locking. Each side only writes
+ * its own free running counter.
  */
-struct no_os_fifo_element {
-	/** next FIFO element */
-	struct no_os_fifo_element *next;
-	/** FIFO data pointer */
-	char *data;
-	/** FIFO length */
-	uint32_t len;
+struct no_os_fifo {
+	/** Storage */
+	uint8_t *buff;
+	/** Size of buff in bytes. Power of 2 */
+	uint32_t size;
+	/** Number of bytes ever written. Updated by the producer */
+	uint32_t head;
+	/** Number of bytes ever read. Updated by the consumer */
+	uint32_t tail;
+	/** Writes that didn't fit. Updated by the producer */
+	uint32_t overruns;
+	/** Set if buff was allocated by no_os_fifo_init */
+	bool alloc_buff;
 };
 
-/* Insert element to fifo tail. */
-int32_t no_os_fifo_insert(struct no_os_fifo_element **p_fifo, char *buff,
-			  uint32_t len);
+/* Allocate a fifo of size bytes. Size must be a power of 2. */
+int32_t no_os_fifo_init(struct no_os_fifo **fifo, uint32_t size);
+
+/* Configure a fifo over a user provided buffer. Size must be a power of 2. */
+int32_t no_os_fifo_cfg(struct no_os_fifo *fifo, uint8_t *buff, uint32_t size);
+
+/* Free the resources allocated by no_os_fifo_init. */
+int32_t no_os_fifo_remove(struct no_os_fifo *fifo);
+
+/* Number of bytes available to read. */
+uint32_t no_os_fifo_len(struct no_os_fifo *fifo);
+
+/* Number of bytes that can be written. */
+uint32_t no_os_fifo_space(struct no_os_fifo *fifo);
+
+/* Insert up to len bytes. Return the number of bytes inserted. */
+uint32_t no_os_fifo_insert(struct no_os_fifo *fifo, const void *buff,
+			   uint32_t len);
+
+/* Remove up to len bytes. Return the number of bytes removed. */
+uint32_t no_os_fifo_read(struct no_os_fifo *fifo, void *buff, uint32_t len);
+
+/* Insert a packet. Either the whole packet is inserted or nothing. */
+int32_t no_os_fifo_insert_pkt(struct no_os_fifo *fifo, const void *buff,
+			      uint16_t len);
 
-/* Remove fifo head. */
-struct no_os_fifo_element *no_os_fifo_remove(struct no_os_fifo_element *p_fifo);
+/* Remove the oldest packet. */
+int32_t no_os_fifo_read_pkt(struct no_os_fifo *fifo, void *buff,
+			    uint16_t max_len);
 
 #endif // _NO_OS_FIFO_H_
@@ -1,6 +1,6 @@
 /***************************************************************************//**
  *   @file   no_os_lf256fifo.h
- *   @brief  SPSC lock-free fifo of fixed size (256), specialized for UART.
+ *   @brief  SPSC lock-free byte fifo with a power of 2 size.
  *   @author Darius Berghe (darius.berghe@analog.com)
 ********************************************************************************
  *   @copyright
@@ -39,15 +39,59 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-struct lf256fifo;
+/* Size used by lf256fifo_init() */
+#define LF256FIFO_DEFAULT_SIZE	256
+
+/**
+ * @struct lf256fifo
+ * @brief Single producer single consumer lock-free byte fifo. The producer
+ * (e.g. an UART interrupt or DMA completion) and the consumer (e.g. the main
+ * loop) only write their own counter, so no locking is needed.
+ */
+struct lf256fifo {
+	/** Memory area of the fifo */
+	uint8_t *data;
+	/** Size of data in bytes, a power of 2 */
+	uint32_t size;
+	/** Free running read counter, written only by the consumer */
+	uint32_t ffilled;
+	/** Free running write counter, written only by the producer */
+	uint32_t fempty;
+	/** Set when the descriptor and data were allocated by the fifo */
+	bool allocated;
+};
+
+/*
+ * Define a statically allocated fifo, to be used without lf256fifo_init():
+ * LF256FIFO_DEFINE(uart_rx_fifo, 1024);
+ * ...
+ * desc->rx_fifo = &uart_rx_fifo;
+ * A size that is not a power of 2 fails to build.
+ */
+#define LF256FIFO_DEFINE(_name, _size)					\
+	static uint8_t _name##_data[((_size) & ((_size) - 1)) ? -1 : (_size)]; \
+	static struct lf256fifo _name = {				\
+		.data = _name##_data,					\
+		.size = (_size),					\
+	}
 
 int lf256fifo_init(struct lf256fifo **);
+int lf256fifo_init_size(struct lf256fifo **fifo, uint32_t size);
+int lf256fifo_cfg(struct lf256fifo *fifo, uint8_t *buf, uint32_t size);
 bool lf256fifo_is_full(struct lf256fifo *);
 bool lf256fifo_is_empty(struct lf256fifo *);
+uint32_t lf256fifo_count(struct lf256fifo *fifo);
+uint32_t lf256fifo_space(struct lf256fifo *fifo);
 int lf256fifo_read(struct lf256fifo *, uint8_t *);
 int lf256fifo_write(struct lf256fifo *, uint8_t);
+uint32_t lf256fifo_read_bulk(struct lf256fifo *fifo, uint8_t *buf,
+			     uint32_t len);
+uint32_t lf256fifo_write_bulk(struct lf256fifo *fifo, const uint8_t *buf,
+			      uint32_t len);
+uint32_t lf256fifo_peek(struct lf256fifo *fifo, uint8_t *buf, uint32_t len);
+uint32_t lf256fifo_write_prepare(struct lf256fifo *fifo, uint8_t **buf);
+void lf256fifo_write_commit(struct lf256fifo *fifo, uint32_t len);
 void lf256fifo_flush(struct lf256fifo *);
 void lf256fifo_remove(struct lf256fifo *fifo);
 
 #endif
-
@@ -0,0 +1,104 @@
+/***************************************************************************//**
+ *   @file   no_os_regmap.h
+ *   @brief  Header file of the register map cache.
+ *   @author Analog Devices Inc.
+********************************************************************************
+ *   @copyright
+ * Copyright 2024(c) Analog Devices, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Analog Devices, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ANALOG DEVICES, INC. “AS IS” AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL ANALOG DEVICES, INC. BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _NO_OS_REGMAP_H_
+#define _NO_OS_REGMAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @enum no_os_regmap_policy
+ * @brief How accesses to the registers of a range are cached.
+ */
+enum no_os_regmap_policy {
+	/** Values are cached. Reads hit the bus only while a value is unknown */
+	NO_OS_REGMAP_CACHEABLE,
+	/** Registers can't be read back, the written values are cached */
+	NO_OS_REGMAP_WRITE_ONLY,
+	/** Every access goes to the bus (status, data, self clearing bits) */
+	NO_OS_REGMAP_VOLATILE,
+};
+
+/**
+ * @struct no_os_regmap_range
+ * @brief Range of consecutive registers sharing a cache policy.
+ */
+struct no_os_regmap_range {
+	/** First register address */
+	uint32_t first;
+	/** Last register address, included */
+	uint32_t last;
+	/** Cache policy */
+	enum no_os_regmap_policy policy;
+};
+
+/**
+ * @struct no_os_regmap_init_param
+ * @brief Register map initialization parameters. Registers not covered by a
+ * range are volatile.
+ */
+struct no_os_regmap_init_param {
+	/** Device descriptor passed to the access functions */
+	void *ctx;
+	/** Read one register from the device */
+	int (*reg_read)(void *ctx, uint32_t reg, uint32_t *val);
+	/** Write one register to the device */
+	int (*reg_write)(void *ctx, uint32_t reg, uint32_t val);
+	/** (Optional) Write cnt consecutive registers in one bus transfer */
+	int (*bulk_write)(void *ctx, uint32_t reg, const uint32_t *vals,
+			  uint32_t cnt);
+	/** Register ranges, must not overlap */
+	const struct no_os_regmap_range *ranges;
+	/** Number of ranges */
+	uint32_t nb_ranges;
+};
+
+struct no_os_regmap;
+
+int no_os_regmap_init(struct no_os_regmap **map,
+		      const struct no_os_regmap_init_param *param);
+int no_os_regmap_remove(struct no_os_regmap *map);
+int no_os_regmap_read(struct no_os_regmap *map, uint32_t reg, uint32_t *val);
+int no_os_regmap_write(struct no_os_regmap *map, uint32_t reg, uint32_t val);
+int no_os_regmap_update_bits(struct no_os_regmap *map, uint32_t reg,
+			     uint32_t mask, uint32_t val);
+void no_os_regmap_cache_only(struct no_os_regmap *map, bool enable);
+int no_os_regmap_sync(struct no_os_regmap *map);
+int no_os_regmap_sync_range(struct no_os_regmap *map, uint32_t first,
+			    uint32_t last);
+void no_os_regmap_mark_dirty(struct no_os_regmap *map);
+void no_os_regmap_cache_drop(struct no_os_regmap *map);
+
+#endif // _NO_OS_REGMAP_H_
@@ -35,6 +35,7 @@
 #define _NO_OS_SPI_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #define	NO_OS_SPI_CPHA	0x01
 #define	NO_OS_SPI_CPOL	0x02
@@ -103,6 +104,72 @@ struct no_os_spi_msg {
 	uint32_t		cs_delay_first;
 	/** Delay (in us) between the last SCLK edge and the CS deassert */
 	uint32_t		cs_delay_last;
+	/**
+	 * SCLK frequency (in Hz) for this message. If 0, the descriptor setting
+	 * is used. Only honoured by platforms that support it.
+	 */
+	uint32_t		speed_hz;
+	/**
+	 * Word size (in bits) for this message. If 0, the descriptor setting is
+	 * used. Only honoured by platforms that support it.
+	 */
+	uint8_t			bits_per_word;
+};
+
+/**
+ * @enum no_os_spi_xfer_prio
+ * @brief Priority class of a queued SPI transaction. A transaction is started
+ * only when no transaction of a higher class is waiting.
+ */
+enum no_os_spi_xfer_prio {
+	/** Deadline bound transfers, e.g. sample reads */
+	NO_OS_SPI_PRIO_HIGH,
+	/** Default class */
+	NO_OS_SPI_PRIO_NORMAL,
+	/** Background transfers, e.g. configuration or status polling */
+	NO_OS_SPI_PRIO_LOW,
+	/** Number of priority classes */
+	NO_OS_SPI_PRIO_CNT
+};
+
+struct no_os_spi_desc;
+
+/**
+ * @struct no_os_spi_xfer
+ * @brief SPI transaction queued on a bus with no_os_spi_submit(). The
+ * structure and the messages are owned by the caller and must stay valid
+ * until the transaction is done.
+ */
+struct no_os_spi_xfer {
+	/** Slave that the messages are sent to */
+	struct no_os_spi_desc	*desc;
+	/** Messages sent as one transaction, like in no_os_spi_transfer() */
+	struct no_os_spi_msg	*msgs;
+	/** Number of messages */
+	uint32_t		len;
+	/** Priority class */
+	enum no_os_spi_xfer_prio	prio;
+	/** Use the platform transfer_dma_async, if implemented */
+	bool			dma;
+	/**
+	 * Called when the transaction is done, possibly from interrupt
+	 * context. May submit new transactions, but must not use the blocking
+	 * API on the same bus. Optional.
+	 */
+	void (*callback)(struct no_os_spi_xfer *xfer);
+	/** User data for the callback */
+	void			*ctx;
+	/** Result of the transaction, valid once it is done */
+	int32_t			status;
+	/** Set when the transaction is done. Managed by the SPI API */
+	bool			done;
+	/**
+	 * Placeholder of a blocking API caller, which is handed the bus
+	 * instead of having the transfer run for it. Managed by the SPI API
+	 */
+	bool			handoff;
+	/** Next transaction in the bus queue. Managed by the SPI API */
+	struct no_os_spi_xfer	*next;
 };
 
 /**
@@ -171,6 +238,18 @@ struct no_os_spibus_desc {
 	const struct no_os_spi_platform_ops *platform_ops;
 	/** SPI bus extra */
 	void		*extra;
+	/** Set while a context owns the bus and runs its transactions */
+	bool		busy;
+	/** Transactions submitted and not yet sorted, newest first */
+	struct no_os_spi_xfer	*intake;
+	/** First transaction waiting in each priority class */
+	struct no_os_spi_xfer	*queue_head[NO_OS_SPI_PRIO_CNT];
+	/** Last transaction waiting in each priority class */
+	struct no_os_spi_xfer	*queue_tail[NO_OS_SPI_PRIO_CNT];
+	/** Transaction running on the DMA */
+	struct no_os_spi_xfer	*current;
+	/** Slave of the last started transaction, used to alternate slaves */
+	struct no_os_spi_desc	*last_desc;
 };
 
 /**
@@ -262,6 +341,15 @@ int32_t no_os_spi_transfer_dma_async(struct no_os_spi_desc *desc,
 				     void (*callback)(void *),
 				     void *ctx);
 
+/* Queue a transaction on the bus of its slave. */
+int32_t no_os_spi_submit(struct no_os_spi_xfer *xfer);
+
+/* Check if a queued transaction is done. */
+bool no_os_spi_xfer_is_done(struct no_os_spi_xfer *xfer);
+
+/* Check if the caller runs in interrupt context or with interrupts masked. */
+bool no_os_spi_in_irq(void);
+
 /* Abort SPI transfers. */
 int32_t no_os_spi_transfer_abort(struct no_os_spi_desc *desc);
 
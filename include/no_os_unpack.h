@@ -0,0 +1,62 @@
+/***************************************************************************//**
+ *   @file   no_os_unpack.h
+ *   @brief  Header file of the packed sample stream unpacking functions.
+ *   @author Analog Devices Inc.
+********************************************************************************
+ *   @copyright
+ * Copyright 2024(c) Analog Devices, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Analog Devices, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ANALOG DEVICES, INC. “AS IS” AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL ANALOG DEVICES, INC. BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef _NO_OS_UNPACK_H_
+#define _NO_OS_UNPACK_H_
+
+#include <stdint.h>
+
+/**
+ * @enum no_os_unpack_order
+ * @brief Bit order of a packed sample stream.
+ */
+enum no_os_unpack_order {
+	/** Samples are packed MSB first, as shifted out by most converters */
+	NO_OS_UNPACK_BE,
+	/** Samples are packed LSB first, starting with bit 0 of the first byte */
+	NO_OS_UNPACK_LE,
+};
+
+/* Unpack a stream of bits wide samples into 32-bit words. */
+int no_os_unpack(const uint8_t *src, uint32_t *dst, uint32_t nb_samples,
+		 uint8_t bits, enum no_os_unpack_order order);
+
+/* Sign extend bits wide samples stored in 32-bit words, in place. */
+int no_os_unpack_sign_extend(uint32_t *buf, uint32_t nb_samples, uint8_t bits);
+
+/* Split a stream of two bit interleaved lanes into one stream per lane. */
+void no_os_unpack_deinterleave2(const uint8_t *src, uint32_t nb_pairs,
+				uint8_t *dst0, uint8_t *dst1);
+
+#endif /* _NO_OS_UNPACK_H_ */
@@ -5,97 +5,559 @@
  */
 
 #include "no_os_error.h"
+#include "no_os_alloc.h"
+#include "no_os_delay.h"
+#include "no_os_print_log.h"
 #include "jesd204-priv.h"
 
+#if defined(FREERTOS)
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#ifndef JESD204_FSM_TASK_STACK_SIZE
+#define JESD204_FSM_TASK_STACK_SIZE	(configMINIMAL_STACK_SIZE * 16)
+#endif
+#ifndef JESD204_FSM_TASK_PRIORITY
+#define JESD204_FSM_TASK_PRIORITY	(tskIDLE_PRIORITY + 1)
+#endif
+#elif defined(LINUX_PLATFORM)
+#include <pthread.h>
+#endif
+
+#if defined(FREERTOS)
 /* no-OS specific */
-int jesd204_fsm_start(struct jesd204_topology *topology, unsigned int link_idx)
+struct jesd204_fsm_barrier {
+	/* Given by the job that brings pending to 0 */
+	SemaphoreHandle_t		done;
+	unsigned int			pending;
+};
+#endif
+
+/* no-OS specific */
+struct jesd204_fsm_job {
+	struct jesd204_topology_dev	*tdev;
+	unsigned int			link_id;
+	struct jesd204_link		*lnk;
+	enum jesd204_dev_op		op;
+	bool				*per_device_op_done;
+	int				ret;
+#if defined(FREERTOS)
+	struct jesd204_fsm_barrier	*barrier;
+#elif defined(LINUX_PLATFORM)
+	pthread_t			thread;
+	bool				spawned;
+#endif
+};
+
+static const char *const jesd204_op_names[__JESD204_MAX_OPS] = {
+	[JESD204_OP_DEVICE_INIT] = "device_init",
+	[JESD204_OP_LINK_INIT] = "link_init",
+	[JESD204_OP_LINK_SUPPORTED] = "link_supported",
+	[JESD204_OP_LINK_PRE_SETUP] = "link_pre_setup",
+	[JESD204_OP_CLK_SYNC_STAGE1] = "clk_sync_stage1",
+	[JESD204_OP_CLK_SYNC_STAGE2] = "clk_sync_stage2",
+	[JESD204_OP_CLK_SYNC_STAGE3] = "clk_sync_stage3",
+	[JESD204_OP_LINK_SETUP] = "link_setup",
+	[JESD204_OP_OPT_SETUP_STAGE1] = "opt_setup_stage1",
+	[JESD204_OP_OPT_SETUP_STAGE2] = "opt_setup_stage2",
+	[JESD204_OP_OPT_SETUP_STAGE3] = "opt_setup_stage3",
+	[JESD204_OP_OPT_SETUP_STAGE4] = "opt_setup_stage4",
+	[JESD204_OP_OPT_SETUP_STAGE5] = "opt_setup_stage5",
+	[JESD204_OP_CLOCKS_ENABLE] = "clocks_enable",
+	[JESD204_OP_LINK_ENABLE] = "link_enable",
+	[JESD204_OP_LINK_RUNNING] = "link_running",
+	[JESD204_OP_OPT_POST_RUNNING_STAGE] = "opt_post_running_stage",
+};
+
+/* no-OS specific */
+static uint64_t jesd204_fsm_time_us(void)
+{
+	struct no_os_time t = no_os_get_time();
+
+	return (uint64_t)t.s * 1000000 + t.us;
+}
+
+/* no-OS specific */
+static int jesd204_fsm_links(struct jesd204_topology *topology,
+			     unsigned int link_idx, unsigned int *first,
+			     unsigned int *last)
+{
+	unsigned int num_links = topology->dev_top->num_links;
+
+	if (!num_links)
+		return -EINVAL;
+
+	if (link_idx == JESD204_LINKS_ALL) {
+		*first = 0;
+		*last = num_links - 1;
+		return 0;
+	}
+
+	if (link_idx >= num_links)
+		return -EINVAL;
+
+	*first = link_idx;
+	*last = link_idx;
+
+	return 0;
+}
+
+/* no-OS specific */
+static bool *jesd204_fsm_alloc_done(struct jesd204_topology *topology)
+{
+	/* Never dereferenced when the top device is alone. */
+	return (bool *)no_os_calloc(topology->devs_number + 1, sizeof(bool));
+}
+
+/* no-OS specific */
+static int jesd204_fsm_dev_init(struct jesd204_topology_dev *tdev,
+				unsigned int link_id, struct jesd204_link *lnk,
+				enum jesd204_dev_op op, bool *per_device_op_done)
 {
 	enum jesd204_state_op_reason reason = JESD204_STATE_OP_REASON_INIT;
+	const struct jesd204_state_op *dev_op;
+	unsigned int lnk_dev;
+	int ret;
+
+	dev_op = &tdev->jdev->dev_data->state_ops[op];
+
+	for (lnk_dev = 0; lnk_dev < tdev->links_number; lnk_dev++) {
+		if (tdev->link_ids[lnk_dev] != link_id)
+			continue;
+
+		if (dev_op->per_device && !*per_device_op_done) {
+			ret = dev_op->per_device(tdev->jdev, reason);
+			if (ret < 0)
+				return ret;
+			*per_device_op_done = true;
+		}
+		if (dev_op->per_link) {
+			ret = dev_op->per_link(tdev->jdev, reason, lnk);
+			if (ret < 0)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+/* no-OS specific */
+static void jesd204_fsm_job_run(struct jesd204_fsm_job *job)
+{
+	job->ret = jesd204_fsm_dev_init(job->tdev, job->link_id, job->lnk,
+					job->op, job->per_device_op_done);
+}
+
+#if defined(FREERTOS)
+/* no-OS specific */
+static void jesd204_fsm_job_task(void *arg)
+{
+	struct jesd204_fsm_job *job = arg;
+	struct jesd204_fsm_barrier *barrier = job->barrier;
+
+	jesd204_fsm_job_run(job);
+	if (!__atomic_sub_fetch(&barrier->pending, 1, __ATOMIC_ACQ_REL))
+		xSemaphoreGive(barrier->done);
+	vTaskDelete(NULL);
+}
+
+/* no-OS specific */
+static void jesd204_fsm_jobs_run(struct jesd204_fsm_job *jobs,
+				 unsigned int nb_jobs)
+{
+	/* The caller holds one count until all the jobs are spawned */
+	struct jesd204_fsm_barrier barrier = {
+		.pending = 1,
+	};
+	unsigned int i;
+
+	/*
+	 * A semaphore of its own, so that notifications and semaphores of the
+	 * calling task can't release the barrier early.
+	 */
+	barrier.done = xSemaphoreCreateBinary();
+
+	for (i = 0; i < nb_jobs; i++) {
+		jobs[i].barrier = &barrier;
+		if (barrier.done) {
+			__atomic_add_fetch(&barrier.pending, 1, __ATOMIC_RELAXED);
+			if (xTaskCreate(jesd204_fsm_job_task, "jesd204",
+					JESD204_FSM_TASK_STACK_SIZE, &jobs[i],
+					JESD204_FSM_TASK_PRIORITY, NULL) == pdPASS)
+				continue;
+			__atomic_sub_fetch(&barrier.pending, 1, __ATOMIC_RELAXED);
+		}
+
+		jesd204_fsm_job_run(&jobs[i]);
+	}
+
+	if (!barrier.done)
+		return;
+
+	/* Barrier, the last job to finish gives the semaphore. */
+	if (__atomic_sub_fetch(&barrier.pending, 1, __ATOMIC_ACQ_REL))
+		xSemaphoreTake(barrier.done, portMAX_DELAY);
+
+	vSemaphoreDelete(barrier.done);
+}
+#elif defined(LINUX_PLATFORM)
+/* no-OS specific */
+static void *jesd204_fsm_job_thread(void *arg)
+{
+	jesd204_fsm_job_run(arg);
+
+	return NULL;
+}
+
+/* no-OS specific */
+static void jesd204_fsm_jobs_run(struct jesd204_fsm_job *jobs,
+				 unsigned int nb_jobs)
+{
+	unsigned int i;
+
+	for (i = 0; i < nb_jobs; i++) {
+		jobs[i].spawned = !pthread_create(&jobs[i].thread, NULL,
+						  jesd204_fsm_job_thread, &jobs[i]);
+		if (!jobs[i].spawned)
+			jesd204_fsm_job_run(&jobs[i]);
+	}
+
+	/* Barrier */
+	for (i = 0; i < nb_jobs; i++)
+		if (jobs[i].spawned)
+			pthread_join(jobs[i].thread, NULL);
+}
+#else
+/* no-OS specific */
+static void jesd204_fsm_jobs_run(struct jesd204_fsm_job *jobs,
+				 unsigned int nb_jobs)
+{
+	unsigned int i;
+
+	/* No scheduler to hand the jobs to. */
+	for (i = 0; i < nb_jobs; i++)
+		jesd204_fsm_job_run(&jobs[i]);
+}
+#endif
+
+/* no-OS specific */
+static int jesd204_fsm_link_init_parallel(struct jesd204_topology *topology,
+		unsigned int lnk_id, enum jesd204_dev_op op,
+		bool *per_device_op_done)
+{
 	struct jesd204_dev_top *jdev_top = topology->dev_top;
-	bool per_device_op_done[16];
-	enum jesd204_dev_op op;
-	int lnk_dev;
-	int lnk_id;
-	int dev;
+	const struct jesd204_state_op *dev_op;
+	struct jesd204_fsm_job *jobs;
+	unsigned int nb_jobs = 0;
+	unsigned int dev;
+	unsigned int i;
+	int ret = 0;
+
+	jobs = (struct jesd204_fsm_job *)no_os_calloc(topology->devs_number,
+			sizeof(*jobs));
+	if (!jobs)
+		return -ENOMEM;
 
-	for (op = 0; op < __JESD204_MAX_OPS; op++) {
-		for (dev = 0; dev < topology->devs_number; dev++)
-			per_device_op_done[dev] = false;
+	/* One job per device, each calls the ops of its own device only. */
+	for (dev = 0; dev < topology->devs_number; dev++) {
+		dev_op = &topology->devs[dev].jdev->dev_data->state_ops[op];
+		if (!dev_op->per_device && !dev_op->per_link)
+			continue;
 
-		for (lnk_id = 0; lnk_id < jdev_top->num_links; lnk_id++) {
+		jobs[nb_jobs].tdev = &topology->devs[dev];
+		jobs[nb_jobs].link_id = jdev_top->link_ids[lnk_id];
+		jobs[nb_jobs].lnk = &jdev_top->active_links[lnk_id].link;
+		jobs[nb_jobs].op = op;
+		jobs[nb_jobs].per_device_op_done = &per_device_op_done[dev];
+		nb_jobs++;
+	}
+
+	jesd204_fsm_jobs_run(jobs, nb_jobs);
+
+	for (i = 0; i < nb_jobs; i++) {
+		if (jobs[i].ret < 0) {
+			ret = jobs[i].ret;
+			break;
+		}
+	}
+
+	no_os_free(jobs);
+
+	return ret;
+}
+
+/* no-OS specific */
+static int jesd204_fsm_op_init(struct jesd204_topology *topology,
+			       unsigned int first, unsigned int last,
+			       enum jesd204_dev_op op, bool *per_device_op_done)
+{
+	enum jesd204_state_op_reason reason = JESD204_STATE_OP_REASON_INIT;
+	struct jesd204_dev_top *jdev_top = topology->dev_top;
+	const struct jesd204_state_op *top_op;
+	struct jesd204_link *lnk = NULL;
+	unsigned int lnk_id;
+	unsigned int dev;
+	int ret;
+
+	top_op = &jdev_top->jdev->dev_data->state_ops[op];
+
+	for (dev = 0; dev < topology->devs_number; dev++)
+		per_device_op_done[dev] = false;
+
+	for (lnk_id = first; lnk_id <= last; lnk_id++) {
+		lnk = &jdev_top->active_links[lnk_id].link;
+		if (topology->parallel_ops && topology->devs_number > 1) {
+			ret = jesd204_fsm_link_init_parallel(topology, lnk_id, op,
+							     per_device_op_done);
+			if (ret < 0)
+				goto error;
+		} else {
 			for (dev = 0; dev < topology->devs_number; dev++) {
-				for (lnk_dev = 0; lnk_dev < topology->devs[dev].links_number; lnk_dev++) {
-					if (topology->devs[dev].link_ids[lnk_dev] == jdev_top->link_ids[lnk_id]) {
-						if (topology->devs[dev].jdev->dev_data->state_ops[op].per_device
-						    && !per_device_op_done[dev]) {
-							topology->devs[dev].jdev->dev_data->state_ops[op].per_device(
-								topology->devs[dev].jdev, reason);
-							per_device_op_done[dev] = true;
-						}
-						if (topology->devs[dev].jdev->dev_data->state_ops[op].per_link)
-							topology->devs[dev].jdev->dev_data->state_ops[op].per_link(
-								topology->devs[dev].jdev, reason,
-								&jdev_top->active_links[lnk_id].link);
-					}
-				}
+				ret = jesd204_fsm_dev_init(&topology->devs[dev],
+							   jdev_top->link_ids[lnk_id],
+							   lnk, op,
+							   &per_device_op_done[dev]);
+				if (ret < 0)
+					goto error;
 			}
-			if (jdev_top->jdev->dev_data->state_ops[op].per_link) {
-				jdev_top->jdev->dev_data->state_ops[op].per_link(jdev_top->jdev, reason,
-						&jdev_top->active_links[lnk_id].link);
-				if (jdev_top->jdev->dev_data->state_ops[op].post_state_sysref)
-					jesd204_sysref_async(jdev_top->jdev);
+		}
+		if (top_op->per_link) {
+			ret = top_op->per_link(jdev_top->jdev, reason, lnk);
+			if (ret < 0)
+				goto error;
+			if (top_op->post_state_sysref) {
+				ret = jesd204_sysref_async(jdev_top->jdev);
+				if (ret < 0)
+					goto error;
 			}
 		}
-		if (jdev_top->jdev->dev_data->state_ops[op].per_device) {
-			jdev_top->jdev->dev_data->state_ops[op].per_device(jdev_top->jdev, reason);
-			if (jdev_top->jdev->dev_data->state_ops[op].post_state_sysref)
-				jesd204_sysref_async(jdev_top->jdev);
+	}
+
+	lnk = NULL;
+	if (top_op->per_device) {
+		ret = top_op->per_device(jdev_top->jdev, reason);
+		if (ret < 0)
+			goto error;
+		if (top_op->post_state_sysref) {
+			ret = jesd204_sysref_async(jdev_top->jdev);
+			if (ret < 0)
+				goto error;
 		}
 	}
 
 	return 0;
+
+error:
+	if (lnk) {
+		lnk->error = ret;
+		pr_err("jesd204: %s failed for link %u (%d)\n",
+		       jesd204_op_names[op], lnk->link_id, ret);
+	} else {
+		for (lnk_id = first; lnk_id <= last; lnk_id++)
+			jdev_top->active_links[lnk_id].link.error = ret;
+		pr_err("jesd204: %s failed for the top device (%d)\n",
+		       jesd204_op_names[op], ret);
+	}
+
+	return ret;
 }
 
 /* no-OS specific */
-int jesd204_fsm_stop(struct jesd204_topology *topology, unsigned int link_idx)
+static int jesd204_fsm_op_uninit(struct jesd204_topology *topology,
+				 unsigned int first, unsigned int last,
+				 enum jesd204_dev_op op, bool *per_device_op_done)
 {
 	enum jesd204_state_op_reason reason = JESD204_STATE_OP_REASON_UNINIT;
 	struct jesd204_dev_top *jdev_top = topology->dev_top;
-	bool per_device_op_done[16];
+	const struct jesd204_state_op *top_op;
+	const struct jesd204_state_op *dev_op;
+	struct jesd204_topology_dev *tdev;
+	struct jesd204_link *lnk;
 	int lnk_dev;
 	int lnk_id;
 	int dev;
-	int op;
+	int ret = 0;
+	int err;
+
+	top_op = &jdev_top->jdev->dev_data->state_ops[op];
+
+	for (dev = topology->devs_number - 1; dev >= 0; dev--)
+		per_device_op_done[dev] = false;
+
+	/* Tear down as much as possible, report the first error. */
+	if (top_op->per_device) {
+		err = top_op->per_device(jdev_top->jdev, reason);
+		if (err < 0 && !ret)
+			ret = err;
+	}
+
+	for (lnk_id = last; lnk_id >= (int)first; lnk_id--) {
+		lnk = &jdev_top->active_links[lnk_id].link;
+		if (top_op->per_link) {
+			err = top_op->per_link(jdev_top->jdev, reason, lnk);
+			if (err < 0 && !ret)
+				ret = err;
+		}
+		for (dev = topology->devs_number - 1; dev >= 0; dev--) {
+			tdev = &topology->devs[dev];
+			dev_op = &tdev->jdev->dev_data->state_ops[op];
+			for (lnk_dev = tdev->links_number - 1; lnk_dev >= 0; lnk_dev--) {
+				if (tdev->link_ids[lnk_dev] != jdev_top->link_ids[lnk_id])
+					continue;
 
-	for (op = __JESD204_MAX_OPS - 1; op >= 0; op--) {
-		for (dev = topology->devs_number - 1; dev >= 0 ; dev--)
-			per_device_op_done[dev] = false;
-
-		if (jdev_top->jdev->dev_data->state_ops[op].per_device)
-			jdev_top->jdev->dev_data->state_ops[op].per_device(jdev_top->jdev, reason);
-
-		for (lnk_id = jdev_top->num_links - 1; lnk_id >= 0; lnk_id--) {
-			if (jdev_top->jdev->dev_data->state_ops[op].per_link)
-				jdev_top->jdev->dev_data->state_ops[op].per_link(jdev_top->jdev, reason,
-						&jdev_top->active_links[lnk_id].link);
-			for (dev = topology->devs_number - 1; dev >= 0; dev--) {
-				for (lnk_dev = topology->devs[dev].links_number - 1; lnk_dev >= 0; lnk_dev--) {
-					if (topology->devs[dev].link_ids[lnk_dev] == jdev_top->link_ids[lnk_id]) {
-						if (topology->devs[dev].jdev->dev_data->state_ops[op].per_device
-						    && !per_device_op_done[dev]) {
-							topology->devs[dev].jdev->dev_data->state_ops[op].per_device(
-								topology->devs[dev].jdev, reason);
-							per_device_op_done[dev] = true;
-						}
-						if (topology->devs[dev].jdev->dev_data->state_ops[op].per_link)
-							topology->devs[dev].jdev->dev_data->state_ops[op].per_link(
-								topology->devs[dev].jdev, reason,
-								&jdev_top->active_links[lnk_id].link);
-					}
+				if (dev_op->per_device && !per_device_op_done[dev]) {
+					err = dev_op->per_device(tdev->jdev, reason);
+					if (err < 0 && !ret)
+						ret = err;
+					per_device_op_done[dev] = true;
+				}
+				if (dev_op->per_link) {
+					err = dev_op->per_link(tdev->jdev, reason, lnk);
+					if (err < 0 && !ret)
+						ret = err;
 				}
 			}
 		}
 	}
 
-	return 0;
+	if (ret)
+		pr_err("jesd204: %s uninit failed (%d)\n", jesd204_op_names[op], ret);
+
+	return ret;
+}
+
+/* no-OS specific */
+static int jesd204_fsm_uninit(struct jesd204_topology *topology,
+			      unsigned int first, unsigned int last,
+			      int from, int to, bool *per_device_op_done)
+{
+	int ret = 0;
+	int err;
+	int op;
+
+	for (op = from; op >= to; op--) {
+		err = jesd204_fsm_op_uninit(topology, first, last, op,
+					    per_device_op_done);
+		if (err && !ret)
+			ret = err;
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Bring up the links of a topology, starting from a given state.
+ * A failing state rolls the links back down to @op and the bring-up is retried
+ * up to the num_retries of the top device. The states before @op are assumed
+ * to be done already, so a link re-sync does not reprogram the clock chips.
+ * @param topology - the JESD204 topology
+ * @param link_idx - index of the link to bring up or JESD204_LINKS_ALL
+ * @param op - first state to run
+ * @return 0 in case of success, negative error code otherwise. The error is
+ * also stored in the error field of the failing link.
+ */
+int jesd204_fsm_resume(struct jesd204_topology *topology, unsigned int link_idx,
+		       enum jesd204_dev_op op)
+{
+	struct jesd204_dev_top *jdev_top;
+	bool *per_device_op_done;
+	unsigned int retries;
+	unsigned int first;
+	unsigned int last;
+	unsigned int i;
+	uint64_t start;
+	int cur;
+	int ret;
+
+	if (!topology || !topology->dev_top || op >= __JESD204_MAX_OPS)
+		return -EINVAL;
+
+	jdev_top = topology->dev_top;
+	ret = jesd204_fsm_links(topology, link_idx, &first, &last);
+	if (ret)
+		return ret;
+
+	per_device_op_done = jesd204_fsm_alloc_done(topology);
+	if (!per_device_op_done)
+		return -ENOMEM;
+
+	retries = jdev_top->jdev->dev_data->num_retries;
+	while (true) {
+		for (i = first; i <= last; i++)
+			jdev_top->active_links[i].link.error = 0;
+
+		for (cur = op; cur < __JESD204_MAX_OPS; cur++) {
+			start = jesd204_fsm_time_us();
+			ret = jesd204_fsm_op_init(topology, first, last, cur,
+						  per_device_op_done);
+			topology->op_time_us[cur] = jesd204_fsm_time_us() - start;
+			if (ret)
+				break;
+
+			pr_debug("jesd204: %s done in %u us\n", jesd204_op_names[cur],
+				 (unsigned int)topology->op_time_us[cur]);
+		}
+		if (!ret)
+			break;
+
+		/* Leave the links in the state they were found in. */
+		jesd204_fsm_uninit(topology, first, last, cur, op, per_device_op_done);
+		if (!retries)
+			break;
+
+		retries--;
+		pr_warning("jesd204: retrying from %s\n", jesd204_op_names[op]);
+	}
+
+	no_os_free(per_device_op_done);
+
+	return ret;
+}
+
+/* no-OS specific */
+int jesd204_fsm_start(struct jesd204_topology *topology, unsigned int link_idx)
+{
+	return jesd204_fsm_resume(topology, link_idx, JESD204_OP_DEVICE_INIT);
+}
+
+/**
+ * @brief Take the links of a topology down to a given state.
+ * All the states from the last one down to @op, included, are uninitialized.
+ * @param topology - the JESD204 topology
+ * @param link_idx - index of the link to take down or JESD204_LINKS_ALL
+ * @param op - last state to uninitialize
+ * @return 0 in case of success, the first error met otherwise.
+ */
+int jesd204_fsm_rollback(struct jesd204_topology *topology,
+			 unsigned int link_idx, enum jesd204_dev_op op)
+{
+	bool *per_device_op_done;
+	unsigned int first;
+	unsigned int last;
+	int ret;
+
+	if (!topology || !topology->dev_top || op >= __JESD204_MAX_OPS)
+		return -EINVAL;
+
+	ret = jesd204_fsm_links(topology, link_idx, &first, &last);
+	if (ret)
+		return ret;
+
+	per_device_op_done = jesd204_fsm_alloc_done(topology);
+	if (!per_device_op_done)
+		return -ENOMEM;
+
+	ret = jesd204_fsm_uninit(topology, first, last, __JESD204_MAX_OPS - 1, op,
+				 per_device_op_done);
+
+	no_os_free(per_device_op_done);
+
+	return ret;
+}
+
+/* no-OS specific */
+int jesd204_fsm_stop(struct jesd204_topology *topology, unsigned int link_idx)
+{
+	return jesd204_fsm_rollback(topology, link_idx, JESD204_OP_DEVICE_INIT);
 }
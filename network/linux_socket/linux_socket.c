@@ -49,6 +49,7 @@
 #include <netdb.h>
 #include <string.h>
 #include <fcntl.h>
+#include <poll.h>
 
 /** @brief See \ref network_interface.socket_open */
 static int32_t linux_socket_open(void *desc, uint32_t *sock_id,
@@ -252,6 +253,40 @@ static int32_t linux_socket_accept(void *desc, uint32_t sock_id,
 	return 0;
 }
 
+/** @brief See \ref network_interface.socket_poll */
+static int32_t linux_socket_poll(void *desc, struct socket_poll_entry *entries,
+				 uint32_t nb_entries, uint32_t timeout_ms)
+{
+	struct pollfd fds[nb_entries];
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < nb_entries; i++) {
+		fds[i].fd = entries[i].sock_id;
+		fds[i].events = 0;
+		if (entries[i].events & SOCKET_POLL_IN)
+			fds[i].events |= POLLIN;
+		if (entries[i].events & SOCKET_POLL_OUT)
+			fds[i].events |= POLLOUT;
+	}
+
+	ret = poll(fds, nb_entries, timeout_ms);
+	if (ret < 0)
+		return -errno;
+
+	for (i = 0; i < nb_entries; i++) {
+		entries[i].revents = 0;
+		if (fds[i].revents & POLLIN)
+			entries[i].revents |= SOCKET_POLL_IN;
+		if (fds[i].revents & POLLOUT)
+			entries[i].revents |= SOCKET_POLL_OUT;
+		if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+			entries[i].revents |= SOCKET_POLL_ERR;
+	}
+
+	return ret;
+}
+
 struct network_interface linux_net = {
 	.socket_open = (int32_t (*)(void *, uint32_t *, enum socket_protocol,
 				    uint32_t)) linux_socket_open,
@@ -264,7 +299,8 @@ struct network_interface linux_net = {
 	.socket_recvfrom = (int32_t (*)(void *, uint32_t, void *, uint32_t, struct socket_address * from))linux_socket_recvfrom,
 	.socket_bind = (int32_t (*)(void *, uint32_t, uint16_t))linux_socket_bind,
 	.socket_listen = (int32_t (*)(void *, uint32_t, uint32_t))linux_socket_listen,
-	.socket_accept = (int32_t (*)(void *, uint32_t, uint32_t*))linux_socket_accept
+	.socket_accept = (int32_t (*)(void *, uint32_t, uint32_t*))linux_socket_accept,
+	.socket_poll = linux_socket_poll
 };
 
 #endif
@@ -120,6 +120,67 @@ static void _release_socket(struct lwip_network_desc *desc, uint32_t id)
 	sock->state = SOCKET_CLOSED;
 }
 
+/**
+ * @brief Reset the send accounting of a socket.
+ * @param sock - the socket.
+ */
+static void _reset_send(struct lwip_socket_desc *sock)
+{
+	sock->snd_queued = 0;
+	sock->snd_acked = 0;
+	sock->zc_first = 0;
+	sock->zc_count = 0;
+	sock->aborted = false;
+}
+
+/**
+ * @brief Hand back to their owners the zero-copy buffers lwip is done with.
+ * @param sock - the socket.
+ * @param all - true if the pcb is gone and every buffer is released.
+ */
+static void _release_zc(struct lwip_socket_desc *sock, bool all)
+{
+	struct lwip_socket_zc_buf buf;
+
+	while (sock->zc_count) {
+		buf = sock->zc[sock->zc_first];
+		if (!all && (int32_t)(sock->snd_acked - buf.end) < 0)
+			break;
+
+		/* Pop first, the callback may queue a new buffer. */
+		sock->zc_first = (sock->zc_first + 1) % NO_OS_LWIP_ZC_BUFS;
+		sock->zc_count--;
+		if (buf.cb)
+			buf.cb(buf.arg, buf.data, buf.size);
+	}
+}
+
+/**
+ * @brief Mark bytes of the first pbuf of a socket as read. The pbuf is
+ * released once all of its bytes are read.
+ * @param sock - the socket.
+ * @param len - number of bytes read, at most the ones left in the pbuf.
+ */
+static void _advance_pbuf(struct lwip_socket_desc *sock, uint32_t len)
+{
+	struct pbuf *p = sock->p;
+
+	sock->p_idx += len;
+	if (sock->p_idx < p->len)
+		return;
+
+	/* Done with current p. Cleanup and mark as read */
+	sock->p = p->next;
+	if (sock->p)
+		pbuf_ref(sock->p);
+
+	if (p->ref > 0)
+		pbuf_free(p);
+
+	tcp_recved(sock->pcb, sock->p_idx);
+	sock->p_idx = 0;
+}
+
 /**
  * @brief Low level pbuf output function. Lwip will call this to send data
  * on the wire.
@@ -431,6 +492,17 @@ static void lwip_err_callback(void *arg, err_t err)
 	struct lwip_socket_desc *socket = arg;
 
 	socket->state = SOCKET_CLOSED;
+	/*
+	 * The pcb and its segments are already freed. Forget the pcb before
+	 * the completion callbacks run, they may close the socket.
+	 */
+	socket->pcb = NULL;
+	if (socket->p) {
+		pbuf_free(socket->p);
+		socket->p = NULL;
+	}
+	socket->p_idx = 0;
+	_release_zc(socket, true);
 }
 
 /**
@@ -456,9 +528,22 @@ static int32_t lwip_socket_close(void *net, uint32_t sock_id)
 		pbuf_free(sock->p);
 	}
 
-	tcp_close(sock->pcb);
-	tcp_recv(sock->pcb, NULL);
-	tcp_err(sock->pcb, NULL);
+	if (sock->zc_count) {
+		/*
+		 * A closed pcb keeps sending its queued data, which may still
+		 * reference buffers of the application. Abort the connection
+		 * so they can be given back right away.
+		 */
+		tcp_err(sock->pcb, NULL);
+		tcp_abort(sock->pcb);
+		sock->aborted = true;
+		_release_zc(sock, true);
+	} else {
+		tcp_close(sock->pcb);
+		tcp_recv(sock->pcb, NULL);
+		tcp_err(sock->pcb, NULL);
+		tcp_sent(sock->pcb, NULL);
+	}
 
 	sock->p_idx = 0;
 	sock->pcb = NULL;
@@ -480,15 +565,17 @@ static err_t lwip_recv_callback(void *arg, struct tcp_pcb *tpcb, struct pbuf *p,
 				err_t err)
 {
 	struct lwip_socket_desc *sock = arg;
+	bool aborted;
 
 	/* The remote side has closed the connection. */
 	if (!p) {
 		tcp_recv(sock->pcb, NULL);
 		sock->state = SOCKET_CLOSED;
 
+		aborted = sock->zc_count;
 		lwip_socket_close(sock->desc, sock->id);
 
-		return ERR_OK;
+		return aborted ? ERR_ABRT : ERR_OK;
 	}
 
 	if (err != ERR_OK) {
@@ -507,14 +594,36 @@ static err_t lwip_recv_callback(void *arg, struct tcp_pcb *tpcb, struct pbuf *p,
 }
 
 /**
- * @brief Configure the receive and error callbacks.
+ * @brief Called when sent data is acknowledged by the remote.
+ * @param arg - the socket.
+ * @param tpcb - lwip TCP descriptor of the socket.
+ * @param len - number of acknowledged bytes.
+ * @return ERR_ABRT if a completion callback closed the socket and the pcb
+ * was aborted, ERR_OK otherwise
+ */
+static err_t lwip_sent_callback(void *arg, struct tcp_pcb *tpcb, u16_t len)
+{
+	struct lwip_socket_desc *sock = arg;
+
+	sock->aborted = false;
+	sock->snd_acked += len;
+	_release_zc(sock, false);
+
+	/* lwip must not touch the pcb anymore. */
+	return sock->aborted ? ERR_ABRT : ERR_OK;
+}
+
+/**
+ * @brief Configure the receive, sent and error callbacks.
  * @param desc - lwip sockets layer specific descriptor.
  * @param err - error code.
  */
 static void lwip_config_socket(struct lwip_socket_desc *desc)
 {
+	_reset_send(desc);
 	tcp_arg(desc->pcb, desc);
 	tcp_recv(desc->pcb, lwip_recv_callback);
+	tcp_sent(desc->pcb, lwip_sent_callback);
 	tcp_err(desc->pcb, lwip_err_callback);
 }
 
@@ -599,6 +708,76 @@ static int32_t lwip_socket_send(void *net, uint32_t sock_id, const void *data,
 	if (err != ERR_OK)
 		return err;
 
+	sock->snd_queued += size;
+	if (!(flags & TCP_WRITE_FLAG_MORE)) {
+		/* Mark data as ready to be sent */
+		err = tcp_output(sock->pcb);
+		if (err != ERR_OK)
+			return err;
+	}
+
+	return size;
+}
+
+/**
+ * @brief Send a TCP packet without copying the data. The buffer is
+ * referenced by lwip until it is acknowledged by the remote, cb is then
+ * called and the buffer may be reused. Closing the socket while buffers
+ * are in flight aborts the connection.
+ * @param desc - lwip sockets layer specific descriptor.
+ * @param sock_id - index of the socket to send data to.
+ * @param data - pointer to the data array.
+ * @param size - size of data array.
+ * @param cb - called with the queued part of the buffer once released.
+ * @param arg - parameter passed to cb.
+ * @return number of queued bytes in the case of success, -EAGAIN if too many
+ * buffers are in flight, negative error code otherwise
+ */
+int32_t lwip_socket_send_zc(struct lwip_network_desc *desc, uint32_t sock_id,
+			    const void *data, uint32_t size,
+			    lwip_socket_sent_cb cb, void *arg)
+{
+	struct lwip_socket_zc_buf *buf;
+	struct lwip_socket_desc *sock;
+	uint32_t avail;
+	uint32_t flags = 0;
+	err_t err;
+
+	if (!desc)
+		return -EINVAL;
+
+	sock = _get_sock(desc, sock_id);
+	if (!sock)
+		return -EINVAL;
+
+	if (sock->state != SOCKET_CONNECTED)
+		return -ENOTCONN;
+
+	if (sock->zc_count == NO_OS_LWIP_ZC_BUFS)
+		return -EAGAIN;
+
+	avail = tcp_sndbuf(sock->pcb);
+	if (avail < size)
+		/* Partial write */
+		flags |= TCP_WRITE_FLAG_MORE;
+
+	size = no_os_min(avail, size);
+	if (!size)
+		return 0;
+
+	err = tcp_write(sock->pcb, data, size, flags);
+	if (err != ERR_OK)
+		return err;
+
+	sock->snd_queued += size;
+	buf = &sock->zc[(sock->zc_first + sock->zc_count) % NO_OS_LWIP_ZC_BUFS];
+	buf->data = data;
+	buf->size = size;
+	buf->end = sock->snd_queued;
+	buf->cb = cb;
+	buf->arg = arg;
+	sock->zc_count++;
+
 	if (!(flags & TCP_WRITE_FLAG_MORE)) {
 		/* Mark data as ready to be sent */
 		err = tcp_output(sock->pcb);
@@ -622,7 +801,6 @@ static int32_t lwip_socket_recv(void *net, uint32_t sock_id, void *data,
 {
 	struct lwip_network_desc *desc = net;
 	struct lwip_socket_desc *socket;
-	struct pbuf *p, *old_p;
 	uint8_t *buf, *pdata;
 	uint32_t i, len;
 
@@ -634,36 +812,88 @@ static int32_t lwip_socket_recv(void *net, uint32_t sock_id, void *data,
 		return -ENOTCONN;
 
 	i = 0;
-	p = socket->p;
 	pdata = data;
 
 	/* Iterate over payloads until requested data has been read */
-	while (p && i < size) {
-		len = no_os_min(size - i, p->len - socket->p_idx);
-		buf = p->payload;
+	while (socket->p && i < size) {
+		len = no_os_min(size - i, socket->p->len - socket->p_idx);
+		buf = socket->p->payload;
 		buf += socket->p_idx;
 		memcpy(pdata + i, buf, len);
 		i += len;
-		socket->p_idx += len;
-		if (socket->p_idx == p->len) {
-			/* Done with current p. Cleanup and mark as read */
-			old_p = p;
-			p = p->next;
-			if (p)
-				pbuf_ref(p);
-
-			if (old_p->ref > 0)
-				pbuf_free(old_p);
-
-			tcp_recved(socket->pcb, socket->p_idx);
-			socket->p_idx = 0;
-		}
+		_advance_pbuf(socket, len);
 	}
-	socket->p = p;
 
 	return i;
 }
 
+/**
+ * @brief Get the received data of a socket without copying it. The unread
+ * part of the first received pbuf is lent to the caller, until it is given
+ * back with lwip_socket_recv_zc_release(). Calling this again without
+ * releasing anything returns the same data.
+ * @param desc - lwip sockets layer specific descriptor.
+ * @param sock_id - index of the socket to receive data from.
+ * @param data - set to the lent data.
+ * @return number of lent bytes (0 if nothing was received) in the case of
+ * success, negative error code otherwise
+ */
+int32_t lwip_socket_recv_zc(struct lwip_network_desc *desc, uint32_t sock_id,
+			    const void **data)
+{
+	struct lwip_socket_desc *socket;
+
+	if (!desc || !data)
+		return -EINVAL;
+
+	socket = _get_sock(desc, sock_id);
+	if (!socket)
+		return -EINVAL;
+
+	if (socket->state != SOCKET_CONNECTED)
+		return -ENOTCONN;
+
+	if (!socket->p)
+		return 0;
+
+	*data = (uint8_t *)socket->p->payload + socket->p_idx;
+
+	return socket->p->len - socket->p_idx;
+}
+
+/**
+ * @brief Give back bytes lent by lwip_socket_recv_zc(), marking them as read.
+ * @param desc - lwip sockets layer specific descriptor.
+ * @param sock_id - index of the socket the data was received from.
+ * @param size - number of bytes to give back, at most the lent ones.
+ * @return 0 in the case of success, negative error code otherwise
+ */
+int32_t lwip_socket_recv_zc_release(struct lwip_network_desc *desc,
+				    uint32_t sock_id, uint32_t size)
+{
+	struct lwip_socket_desc *socket;
+
+	if (!desc)
+		return -EINVAL;
+
+	socket = _get_sock(desc, sock_id);
+	if (!socket)
+		return -EINVAL;
+
+	if (socket->state != SOCKET_CONNECTED)
+		return -ENOTCONN;
+
+	if (!size)
+		return 0;
+
+	if (!socket->p || size > socket->p->len - socket->p_idx)
+		return -EINVAL;
+
+	_advance_pbuf(socket, size);
+
+	return 0;
+}
+
 /**
  * @brief Bind a socket to a port.
  * @param net - lwip sockets layer specific descriptor.
@@ -887,6 +1117,56 @@ static int32_t lwip_socket_disconnect(void *net, uint32_t sock_id)
 	return lwip_socket_close(net, sock_id);
 }
 
+/**
+ * @brief Check the state of a set of sockets.
+ *
+ * The raw API is driven by no_os_lwip_step() from the same loop, so this
+ * never sleeps and timeout_ms is ignored.
+ * @param net - lwip sockets layer specific descriptor.
+ * @param entries - sockets and the requested events.
+ * @param nb_entries - number of entries.
+ * @param timeout_ms - unused.
+ * @return number of sockets with events.
+ */
+static int32_t lwip_socket_poll(void *net, struct socket_poll_entry *entries,
+				uint32_t nb_entries, uint32_t timeout_ms)
+{
+	struct lwip_network_desc *desc = net;
+	struct lwip_socket_desc *sock;
+	int32_t nb_ready = 0;
+	uint32_t i, j;
+
+	NO_OS_UNUSED_PARAM(timeout_ms);
+	for (i = 0; i < nb_entries; i++) {
+		entries[i].revents = 0;
+		sock = _get_sock(desc, entries[i].sock_id);
+		if (!sock || sock->state == SOCKET_CLOSED) {
+			entries[i].revents = SOCKET_POLL_ERR;
+		} else if (sock->state == SOCKET_LISTENING) {
+			/* Accepting is enabled by the first socket_accept call */
+			entries[i].revents = entries[i].events & SOCKET_POLL_IN;
+		} else if (sock->state == SOCKET_ACCEPTING) {
+			for (j = 0; j < NO_OS_MAX_SOCKETS; j++)
+				if (desc->sockets[j].state == SOCKET_WAITING_ACCEPT)
+					break;
+			if (j < NO_OS_MAX_SOCKETS)
+				entries[i].revents = entries[i].events &
+						     SOCKET_POLL_IN;
+		} else if (sock->state == SOCKET_CONNECTED) {
+			if (sock->p)
+				entries[i].revents |= entries[i].events &
+						      SOCKET_POLL_IN;
+			if (tcp_sndbuf(sock->pcb))
+				entries[i].revents |= entries[i].events &
+						      SOCKET_POLL_OUT;
+		}
+		if (entries[i].revents)
+			nb_ready++;
+	}
+
+	return nb_ready;
+}
+
 /**
  * @brief Get the time from system power-up (ms resolution).
  * @return Time in ms.
@@ -910,6 +1190,7 @@ struct network_interface lwip_socket_ops = {
 	.socket_bind = lwip_socket_bind,
 	.socket_listen = lwip_socket_listen,
 	.socket_accept = lwip_socket_accept,
+	.socket_poll = lwip_socket_poll,
 };
 
 /**
@@ -931,6 +1212,7 @@ static void lwip_config_if(struct lwip_network_desc *desc)
 	net->socket_bind = lwip_socket_bind;
 	net->socket_listen = lwip_socket_listen;
 	net->socket_accept = lwip_socket_accept;
+	net->socket_poll = lwip_socket_poll;
 
 	net->net = desc;
 }
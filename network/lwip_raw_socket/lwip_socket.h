@@ -52,8 +52,30 @@
 #define NO_OS_LWIP_INIT_ONETIME		0
 #endif
 
+/* Zero-copy sends a socket may have in flight */
+#ifndef NO_OS_LWIP_ZC_BUFS
+#define NO_OS_LWIP_ZC_BUFS		8
+#endif
+
 struct lwip_network_desc;
 
+/*
+ * Called once lwip no longer references a buffer passed to
+ * lwip_socket_send_zc(), either because the remote acknowledged it or
+ * because the connection was closed.
+ */
+typedef void (*lwip_socket_sent_cb)(void *arg, const void *data,
+				    uint32_t size);
+
+struct lwip_socket_zc_buf {
+	const void *data;
+	uint32_t size;
+	/* Value of snd_queued once the buffer was queued */
+	uint32_t end;
+	lwip_socket_sent_cb cb;
+	void *arg;
+};
+
 struct lwip_socket_desc {
 	/* Unique identifier */
 	uint32_t id;
@@ -76,6 +98,16 @@ struct lwip_socket_desc {
 	struct pbuf *p;
 	/* Index of the current read byte in the first pbuf of the chain */
 	uint32_t p_idx;
+	/* Number of bytes ever queued with tcp_write() */
+	uint32_t snd_queued;
+	/* Number of bytes ever acknowledged by the remote */
+	uint32_t snd_acked;
+	/* Zero-copy sends not acknowledged yet, oldest first */
+	struct lwip_socket_zc_buf zc[NO_OS_LWIP_ZC_BUFS];
+	uint32_t zc_first;
+	uint32_t zc_count;
+	/* Set when lwip_socket_close() had to abort the pcb */
+	bool aborted;
 	/* Reference to the parent network descriptor. */
 	struct lwip_network_desc *desc;
 };
@@ -117,6 +149,15 @@ int32_t no_os_lwip_remove(struct lwip_network_desc *);
  * it will call the necessary lwip timers.
  */
 int32_t no_os_lwip_step(struct lwip_network_desc *, void *);
+/* Send data without copying it, the buffer is lent to lwip until cb is called */
+int32_t lwip_socket_send_zc(struct lwip_network_desc *, uint32_t, const void *,
+			    uint32_t, lwip_socket_sent_cb, void *);
+/* Get the received data of a socket without copying it */
+int32_t lwip_socket_recv_zc(struct lwip_network_desc *, uint32_t,
+			    const void **);
+/* Give back bytes obtained with lwip_socket_recv_zc() */
+int32_t lwip_socket_recv_zc_release(struct lwip_network_desc *, uint32_t,
+				    uint32_t);
 
 extern struct network_interface lwip_socket_ops;
 
@@ -59,6 +59,26 @@ struct socket_address {
 	uint16_t	port;
 };
 
+/** Socket has data to be read or, for a server socket, a pending connection */
+#define SOCKET_POLL_IN		0x1
+/** Socket can accept data to be sent */
+#define SOCKET_POLL_OUT		0x2
+/** Socket was closed by the remote side or is in error */
+#define SOCKET_POLL_ERR		0x4
+
+/**
+ * @struct socket_poll_entry
+ * @brief Socket to be checked by \ref network_interface.socket_poll
+ */
+struct socket_poll_entry {
+	/** Socket id */
+	uint32_t	sock_id;
+	/** Requested events. Combination of SOCKET_POLL_IN and SOCKET_POLL_OUT */
+	uint8_t		events;
+	/** Returned events. SOCKET_POLL_ERR may be set even if not requested */
+	uint8_t		revents;
+};
+
 /**
  * @struct network_interface
  * @brief Interface that connect the data layer with the transport layer
@@ -204,6 +224,25 @@ struct network_interface {
 	 */
 	int32_t (*socket_accept)(void *net, uint32_t sock_id,
 				 uint32_t *client_socket_id);
+
+	/**
+	 * @brief Wait for events on a set of sockets.
+	 *
+	 * Optional. When not implemented, the sockets must be polled by
+	 * calling recv/send/accept.
+	 * @param net - Network interface
+	 * @param entries - Sockets and the events to wait for. revents is
+	 * updated for each entry.
+	 * @param nb_entries - Number of entries
+	 * @param timeout_ms - Maximum time to wait for an event. 0 returns
+	 * immediately. Implementations that can't sleep return immediately.
+	 * @return
+	 *  - Number of entries with revents set : On success
+	 *  - 0 : On timeout
+	 *  - \ref Negative error code on failure
+	 */
+	int32_t (*socket_poll)(void *net, struct socket_poll_entry *entries,
+			       uint32_t nb_entries, uint32_t timeout_ms);
 };
 
 #endif
@@ -439,3 +439,57 @@ int32_t socket_accept(struct tcp_socket_desc *desc,
 	return 0;
 }
 
+/**
+ * @brief Wait for events on a set of sockets of the same network interface.
+ * @param socks - Sockets to be checked
+ * @param entries - Requested events for each socket. sock_id is filled by
+ * this function and revents is updated with the returned events.
+ * @param nb_entries - Number of sockets
+ * @param timeout_ms - Maximum time to wait
+ * @return Number of sockets with events, 0 on timeout, -ENOSYS if the network
+ * interface doesn't support polling or other negative error code.
+ */
+int32_t socket_poll(struct tcp_socket_desc **socks,
+		    struct socket_poll_entry *entries, uint32_t nb_entries,
+		    uint32_t timeout_ms)
+{
+	struct network_interface *net;
+	uint32_t i;
+	int32_t ret;
+
+	if (!socks || !entries || !nb_entries)
+		return -EINVAL;
+
+	net = socks[0]->net;
+	if (!net->socket_poll)
+		return -ENOSYS;
+
+	for (i = 0; i < nb_entries; i++) {
+		entries[i].sock_id = socks[i]->id;
+		entries[i].revents = 0;
+#ifndef DISABLE_SECURE_SOCKET
+		/* Data already decrypted by mbedtls is not seen by the socket */
+		if (socks[i]->secure && (entries[i].events & SOCKET_POLL_IN) &&
+		    mbedtls_ssl_get_bytes_avail(&socks[i]->secure->ssl))
+			timeout_ms = 0;
+#endif /* DISABLE_SECURE_SOCKET */
+	}
+
+	ret = net->socket_poll(net->net, entries, nb_entries, timeout_ms);
+	if (NO_OS_IS_ERR_VALUE(ret))
+		return ret;
+
+#ifndef DISABLE_SECURE_SOCKET
+	for (i = 0; i < nb_entries; i++) {
+		if (socks[i]->secure && (entries[i].events & SOCKET_POLL_IN) &&
+		    mbedtls_ssl_get_bytes_avail(&socks[i]->secure->ssl)) {
+			if (!entries[i].revents)
+				ret++;
+			entries[i].revents |= SOCKET_POLL_IN;
+		}
+	}
+#endif /* DISABLE_SECURE_SOCKET */
+
+	return ret;
+}
+
@@ -153,4 +153,9 @@ int32_t socket_listen(struct tcp_socket_desc *desc, uint32_t back_log);
 int32_t socket_accept(struct tcp_socket_desc *desc,
 		      struct tcp_socket_desc **new_client);
 
+/* Socket poll */
+int32_t socket_poll(struct tcp_socket_desc **socks,
+		    struct socket_poll_entry *entries, uint32_t nb_entries,
+		    uint32_t timeout_ms);
+
 #endif
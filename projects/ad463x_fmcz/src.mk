@@ -28,6 +28,7 @@ SRCS += $(NO-OS)/util/no_os_util.c \
 	$(NO-OS)/util/no_os_circular_buffer.c \
 	$(NO-OS)/util/no_os_list.c \
 	$(NO-OS)/util/no_os_lf256fifo.c \
+	$(NO-OS)/util/no_os_unpack.c \
 	$(NO-OS)/util/no_os_fifo.c
 
 INCS +=	$(INCLUDE)/no_os_axi_io.h \
@@ -50,6 +51,7 @@ INCS +=	$(INCLUDE)/no_os_axi_io.h \
 	$(INCLUDE)/no_os_list.h \
 	$(INCLUDE)/no_os_lf256fifo.h \
 	$(INCLUDE)/no_os_irq.h \
+	$(INCLUDE)/no_os_unpack.h \
 	$(INCLUDE)/no_os_fifo.h
 
 SRCS +=	$(DRIVERS)/axi_core/axi_dmac/axi_dmac.c \
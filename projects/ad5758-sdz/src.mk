@@ -8,7 +8,8 @@ SRCS += $(DRIVERS)/api/no_os_gpio.c \
 	$(DRIVERS)/dac/ad5758/ad5758.c \
 	$(NO-OS)/util/no_os_util.c \
         $(NO-OS)/util/no_os_alloc.c \
-	$(NO-OS)/util/no_os_mutex.c
+	$(NO-OS)/util/no_os_mutex.c \
+	$(NO-OS)/util/no_os_crc8.c
 
 INCS += $(INCLUDE)/no_os_gpio.h \
 	$(INCLUDE)/no_os_spi.h \
@@ -18,6 +19,7 @@ INCS += $(INCLUDE)/no_os_gpio.h \
         $(INCLUDE)/no_os_util.h \
         $(INCLUDE)/no_os_alloc.h \
         $(INCLUDE)/no_os_mutex.h \
+        $(INCLUDE)/no_os_crc8.h \
         $(PLATFORM_DRIVERS)/$(PLATFORM)_gpio.h \
 	$(PLATFORM_DRIVERS)/$(PLATFORM)_spi.h	\
 	$(DRIVERS)/dac/ad5758/ad5758.h
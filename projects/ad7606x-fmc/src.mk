@@ -43,6 +43,7 @@ SRCS += $(DRIVERS)/api/no_os_uart.c     \
         $(NO-OS)/util/no_os_crc8.c      \
         $(NO-OS)/util/no_os_crc16.c     \
         $(NO-OS)/util/no_os_crc24.c     \
+        $(NO-OS)/util/no_os_unpack.c    \
         $(NO-OS)/util/no_os_util.c
 
 
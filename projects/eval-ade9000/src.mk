@@ -12,6 +12,7 @@ INCS += $(INCLUDE)/no_os_alloc.h			\
 	$(INCLUDE)/no_os_util.h				\
 	$(INCLUDE)/no_os_lf256fifo.h			\
 	$(INCLUDE)/no_os_list.h				\
+	$(INCLUDE)/no_os_regmap.h			\
 	$(INCLUDE)/no_os_irq.h				\
 	$(INCLUDE)/no_os_units.h 			\
 	$(INCLUDE)/no_os_init.h 			\
@@ -35,6 +36,7 @@ SRCS +=	$(NO-OS)/util/no_os_alloc.c			\
 	$(NO-OS)/util/no_os_mutex.c			\
 	$(NO-OS)/util/no_os_lf256fifo.c			\
 	$(NO-OS)/util/no_os_list.c			\
+	$(NO-OS)/util/no_os_regmap.c			\
 	$(NO-OS)/util/no_os_util.c			\
 	$(NO-OS)/util/no_os_crc8.c 			\
 	$(NO-OS)/util/no_os_crc16.c 			\
@@ -22,6 +22,7 @@ INCS += $(INCLUDE)/no_os_delay.h     \
 		$(INCLUDE)/no_os_dma.h      \
 		$(INCLUDE)/no_os_uart.h      \
 		$(INCLUDE)/no_os_lf256fifo.h \
+		$(INCLUDE)/no_os_regmap.h    \
 		$(INCLUDE)/no_os_util.h 	\
 		$(INCLUDE)/no_os_units.h	\
 		$(INCLUDE)/no_os_mutex.h
@@ -33,6 +34,7 @@ SRCS += $(DRIVERS)/api/no_os_gpio.c \
 		$(DRIVERS)/api/no_os_uart.c \
 		$(DRIVERS)/api/no_os_dma.c \
 		$(NO-OS)/util/no_os_list.c \
+		$(NO-OS)/util/no_os_regmap.c \
 		$(NO-OS)/util/no_os_util.c \
 		$(NO-OS)/util/no_os_alloc.c \
 		$(NO-OS)/util/no_os_mutex.c
@@ -35,6 +35,7 @@
 #include "common_data.h"
 #include "ltc2983.h"
 #include "no_os_delay.h"
+#include "no_os_error.h"
 #include "no_os_print_log.h"
 
 /*****************************************************************************
@@ -46,6 +47,8 @@
 int basic_example_main()
 {
 	struct ltc2983_desc *dev;
+	uint32_t raw[20], scale, scale2;
+	uint32_t mask, faults;
 	int ret, i;
 	int val;
 
@@ -60,14 +63,22 @@ int basic_example_main()
 	if (ret)
 		goto error;
 
+	mask = ltc2983_scan_mask(dev);
 	while (1) {
+		/* Convert all channels at once and read the results together */
+		ret = ltc2983_scan(dev, mask, raw, &faults);
+		if (ret && ret != -EIO)
+			goto free_dev;
+
 		for (i = 0; i < dev->max_channels_nr; i++) {
-			if (!dev->sensors[i] ||
-			    dev->sensors[i]->type == LTC2983_RSENSE)
+			if (!(mask & LTC2983_CHAN_MASK(i + 1)))
+				continue;
+			if (faults & LTC2983_CHAN_MASK(i + 1)) {
+				pr_info("Channel %d: fault\r\n", i + 1);
 				continue;
-			ret = ltc2983_chan_read(dev, i + 1, &val);
-			if (ret)
-				goto free_dev;
+			}
+			ltc2983_chan_read_scale(dev, i + 1, &scale, &scale2);
+			val = (int)raw[i] * (int)scale / (int)scale2;
 			pr_info("Channel %d: temperature: %d mC\r\n", i + 1,
 				val);
 		}
@@ -40,6 +40,10 @@ CFLAGS_MFLOAT_TYPE 	?= hard
 ifeq '$(NO_OS_USB_UART)' 'y'
 CFLAGS += -DNO_OS_USB_UART
 endif
+
+ifeq '$(NO_OS_ALLOC_POOL)' 'y'
+CFLAGS += -DNO_OS_ALLOC_POOL
+endif
 #------------------------------------------------------------------------------
 #                          EVALUATE PLATFORM
 #------------------------------------------------------------------------------
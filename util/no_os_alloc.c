@@ -33,6 +33,8 @@
 
 #include "no_os_alloc.h"
 
+#ifndef NO_OS_ALLOC_POOL
+
 /**
  * @brief Allocate memory and return a pointer to it.
  * @param size - Size of the memory block, in bytes.
@@ -65,3 +67,264 @@ __attribute__((weak)) void no_os_free(void *ptr)
 {
 	free(ptr);
 }
+
+#else /* NO_OS_ALLOC_POOL */
+
+#include <stdbool.h>
+#include <string.h>
+#include "no_os_error.h"
+#include "no_os_util.h"
+
+/*
+ * Fixed-size block pools as X(block_size, nb_blocks), sorted by block_size.
+ * Block sizes must be multiples of 8. Can be overridden from the build.
+ */
+#ifndef NO_OS_ALLOC_POOLS
+#define NO_OS_ALLOC_POOLS(X)	\
+	X(32, 64)		\
+	X(128, 32)		\
+	X(512, 16)		\
+	X(2048, 4)
+#endif
+
+/* Size of the arena used for allocations that don't fit in a pool */
+#ifndef NO_OS_ALLOC_ARENA_SIZE
+#define NO_OS_ALLOC_ARENA_SIZE	0x4000
+#endif
+
+#define NO_OS_ALLOC_ALIGN	8
+
+#define NO_OS_ALLOC_POOL_MEM(_size, _nb) \
+	static uint64_t no_os_pool_mem_##_size[(_size) * (_nb) / sizeof(uint64_t)];
+
+#define NO_OS_ALLOC_POOL_DESC(_size, _nb) \
+	{ \
+		.mem = (uint8_t *)no_os_pool_mem_##_size, \
+		.stats = { .block_size = (_size), .nb_blocks = (_nb) }, \
+	},
+
+struct no_os_alloc_pool {
+	/* Memory of the blocks */
+	uint8_t *mem;
+	/* Freed blocks, linked through their first word */
+	void *free_list;
+	/* Blocks from this index on were never allocated */
+	uint32_t nb_touched;
+	struct no_os_alloc_pool_stats stats;
+};
+
+NO_OS_ALLOC_POOLS(NO_OS_ALLOC_POOL_MEM)
+
+static struct no_os_alloc_pool no_os_pools[] = {
+	NO_OS_ALLOC_POOLS(NO_OS_ALLOC_POOL_DESC)
+};
+
+static uint64_t no_os_arena_mem[NO_OS_ALLOC_ARENA_SIZE / sizeof(uint64_t)];
+static struct no_os_alloc_arena_stats no_os_arena = {
+	.size = sizeof(no_os_arena_mem),
+};
+static bool no_os_arena_locked;
+
+/**
+ * @brief Take a block from a pool.
+ * @param pool - Pool descriptor.
+ * @return Pointer to the block, or NULL if the pool is empty.
+ */
+static void *no_os_pool_get(struct no_os_alloc_pool *pool)
+{
+	void *block;
+
+	if (pool->free_list) {
+		block = pool->free_list;
+		pool->free_list = *(void **)block;
+	} else if (pool->nb_touched < pool->stats.nb_blocks) {
+		block = pool->mem + pool->nb_touched * pool->stats.block_size;
+		pool->nb_touched++;
+	} else {
+		pool->stats.failures++;
+		return NULL;
+	}
+
+	pool->stats.used++;
+	if (pool->stats.used > pool->stats.high_water)
+		pool->stats.high_water = pool->stats.used;
+
+	return block;
+}
+
+/**
+ * @brief Find the pool a pointer belongs to.
+ * @param ptr - Pointer returned by no_os_malloc.
+ * @return Pool descriptor, or NULL if ptr is not from a pool.
+ */
+static struct no_os_alloc_pool *no_os_pool_find(void *ptr)
+{
+	struct no_os_alloc_pool *pool;
+	uint32_t i;
+
+	for (i = 0; i < NO_OS_ARRAY_SIZE(no_os_pools); i++) {
+		pool = &no_os_pools[i];
+		if ((uint8_t *)ptr >= pool->mem &&
+		    (uint8_t *)ptr < pool->mem + pool->stats.block_size *
+		    pool->stats.nb_blocks)
+			return pool;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Allocate from the arena.
+ * @param size - Size of the memory block, in bytes.
+ * @return Pointer to the allocated memory, or NULL if it doesn't fit.
+ */
+static void *no_os_arena_get(size_t size)
+{
+	void *ptr;
+
+	size = NO_OS_DIV_ROUND_UP(size, NO_OS_ALLOC_ALIGN) * NO_OS_ALLOC_ALIGN;
+	if (size > no_os_arena.size - no_os_arena.used) {
+		no_os_arena.failures++;
+		return NULL;
+	}
+
+	ptr = (uint8_t *)no_os_arena_mem + no_os_arena.used;
+	no_os_arena.used += size;
+
+	return ptr;
+}
+
+/**
+ * @brief Allocate memory and return a pointer to it.
+ *
+ * The smallest pool with a free block that fits size is used. Allocations
+ * larger than the biggest block, or made when the pools are exhausted, are
+ * served from the arena until no_os_alloc_arena_lock() is called. Afterwards,
+ * they fall back to the heap unless NO_OS_ALLOC_NO_HEAP is defined.
+ * @param size - Size of the memory block, in bytes.
+ * @return Pointer to the allocated memory, or NULL if the request fails.
+ */
+__attribute__((weak)) void *no_os_malloc(size_t size)
+{
+	void *ptr;
+	uint32_t i;
+
+	if (!size)
+		return NULL;
+
+	for (i = 0; i < NO_OS_ARRAY_SIZE(no_os_pools); i++) {
+		if (size > no_os_pools[i].stats.block_size)
+			continue;
+
+		ptr = no_os_pool_get(&no_os_pools[i]);
+		if (ptr)
+			return ptr;
+	}
+
+	if (!no_os_arena_locked) {
+		ptr = no_os_arena_get(size);
+		if (ptr)
+			return ptr;
+	}
+
+#ifdef NO_OS_ALLOC_NO_HEAP
+	return NULL;
+#else
+	return malloc(size);
+#endif
+}
+
+/**
+ * @brief Allocate memory and return a pointer to it, set memory to 0.
+ * @param nitems - Number of elements to be allocated.
+ * @param size - Size of elements.
+ * @return Pointer to the allocated memory, or NULL if the request fails.
+ */
+__attribute__((weak)) void *no_os_calloc(size_t nitems, size_t size)
+{
+	void *ptr;
+
+	if (size && nitems > SIZE_MAX / size)
+		return NULL;
+
+	ptr = no_os_malloc(nitems * size);
+	if (ptr)
+		memset(ptr, 0, nitems * size);
+
+	return ptr;
+}
+
+/**
+ * @brief Deallocate memory previously allocated by a call to no_os_calloc
+ * 		  or no_os_malloc.
+ *
+ * Blocks go back to their pool. Arena allocations are never released.
+ * @param ptr - Pointer to a memory block previously allocated by a call
+ * 		  to no_os_calloc or no_os_malloc.
+ * @return None.
+ */
+__attribute__((weak)) void no_os_free(void *ptr)
+{
+	struct no_os_alloc_pool *pool;
+
+	if (!ptr)
+		return;
+
+	pool = no_os_pool_find(ptr);
+	if (pool) {
+		*(void **)ptr = pool->free_list;
+		pool->free_list = ptr;
+		pool->stats.used--;
+		return;
+	}
+
+	if ((uint8_t *)ptr >= (uint8_t *)no_os_arena_mem &&
+	    (uint8_t *)ptr < (uint8_t *)no_os_arena_mem + no_os_arena.size)
+		return;
+
+#ifndef NO_OS_ALLOC_NO_HEAP
+	free(ptr);
+#endif
+}
+
+/**
+ * @brief Stop serving allocations from the arena.
+ *
+ * Memory freed after initialization can't be reused from the arena, so
+ * allocations made at runtime should only come from the pools.
+ * @return None.
+ */
+void no_os_alloc_arena_lock(void)
+{
+	no_os_arena_locked = true;
+}
+
+/**
+ * @brief Get the usage of a pool.
+ * @param idx - Index of the pool, in increasing block size order.
+ * @param stats - Filled with the usage of the pool.
+ * @return 0 in case of success, -EINVAL if there is no pool with index idx.
+ */
+int no_os_alloc_get_pool_stats(uint32_t idx,
+			       struct no_os_alloc_pool_stats *stats)
+{
+	if (!stats || idx >= NO_OS_ARRAY_SIZE(no_os_pools))
+		return -EINVAL;
+
+	*stats = no_os_pools[idx].stats;
+
+	return 0;
+}
+
+/**
+ * @brief Get the usage of the arena.
+ * @param stats - Filled with the usage of the arena.
+ * @return None.
+ */
+void no_os_alloc_get_arena_stats(struct no_os_alloc_arena_stats *stats)
+{
+	if (stats)
+		*stats = no_os_arena;
+}
+
+#endif /* NO_OS_ALLOC_POOL */
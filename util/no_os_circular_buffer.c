@@ -53,6 +53,37 @@ int32_t no_os_cb_cfg(struct no_os_circular_buffer *desc, int8_t *buff,
 	return 0;
 }
 
+/**
+ * @brief Configure a lock-free single producer single consumer circular
+ * buffer without memory allocation.
+ *
+ * @note In this mode the producer (write functions) and the consumer (read
+ * functions) can run in different contexts (e.g. interrupt and main loop)
+ * without any locking. Writes that do not fit in the free space are dropped
+ * and counted in the statistics instead of overwriting unread data.
+ *
+ * @param desc - Circular buffer reference
+ * @param buff - Buffer to be used
+ * @param size - Buffer size. Must be a power of 2.
+ * @return
+ *  - 0 : On success
+ *  - -EINVAL : Wrong parameters used
+ */
+int32_t no_os_cb_cfg_lf(struct no_os_circular_buffer *desc, int8_t *buff,
+			uint32_t size)
+{
+	if (!desc || !buff || !size || (size & (size - 1)))
+		return -EINVAL;
+
+	memset(desc, 0, sizeof(*desc));
+	desc->size = size;
+	desc->mask = size - 1;
+	desc->buff = buff;
+	desc->lock_free = true;
+
+	return 0;
+}
+
 /**
  * @brief Create circular buffer structure.
  *
@@ -110,6 +141,158 @@ int32_t no_os_cb_remove(struct no_os_circular_buffer *desc)
 	return 0;
 }
 
+/**
+ * @brief Get the statistics of a lock-free circular buffer.
+ * @param desc - Circular buffer reference
+ * @param stats - Where to store the statistics
+ * @return
+ *  - 0   - No errors
+ *  - -EINVAL   - Wrong parameters used
+ */
+int32_t no_os_cb_get_stats(struct no_os_circular_buffer *desc,
+			   struct no_os_cb_stats *stats)
+{
+	if (!desc || !stats)
+		return -EINVAL;
+
+	stats->overruns = __atomic_load_n(&desc->stats.overruns,
+					  __ATOMIC_RELAXED);
+	stats->high_water = __atomic_load_n(&desc->stats.high_water,
+					    __ATOMIC_RELAXED);
+
+	return 0;
+}
+
+/*
+ * Lock-free mode helpers.
+ * Each side only writes its own free running counter. The producer publishes
+ * data with a release store on write.idx which the consumer loads with
+ * acquire, and the consumer frees space the same way with read.idx.
+ */
+static inline uint32_t no_os_cb_lf_used(struct no_os_circular_buffer *desc)
+{
+	return __atomic_load_n(&desc->write.idx, __ATOMIC_ACQUIRE) -
+	       __atomic_load_n(&desc->read.idx, __ATOMIC_ACQUIRE);
+}
+
+static inline void no_os_cb_lf_count_overrun(struct no_os_circular_buffer *desc)
+{
+	__atomic_store_n(&desc->stats.overruns, desc->stats.overruns + 1,
+			 __ATOMIC_RELAXED);
+}
+
+/* Called by the producer after publishing new data */
+static inline void no_os_cb_lf_update_hwm(struct no_os_circular_buffer *desc)
+{
+	uint32_t used = no_os_cb_lf_used(desc);
+
+	if (used > desc->stats.high_water)
+		__atomic_store_n(&desc->stats.high_water, used,
+				 __ATOMIC_RELAXED);
+}
+
+static int32_t no_os_cb_lf_prepare_async(struct no_os_circular_buffer *desc,
+		uint32_t requested_size,
+		void **buff,
+		uint32_t *raw_size_available,
+		bool is_read)
+{
+	struct no_os_cb_ptr	*ptr;
+	uint32_t	available_size;
+	uint32_t	idx;
+
+	ptr = is_read ? &desc->read : &desc->write;
+	if (ptr->async_started)
+		return -EBUSY;
+
+	available_size = no_os_cb_lf_used(desc);
+	if (!is_read)
+		available_size = desc->size - available_size;
+
+	*raw_size_available = 0;
+	if (!available_size) {
+		if (!is_read)
+			no_os_cb_lf_count_overrun(desc);
+		return -EAGAIN;
+	}
+
+	idx = ptr->idx & desc->mask;
+	ptr->async_size = no_os_min(requested_size, available_size);
+	ptr->async_size = no_os_min(ptr->async_size, desc->size - idx);
+	if (!ptr->async_size)
+		return -EAGAIN;
+
+	*raw_size_available = ptr->async_size;
+	*buff = (void *)(desc->buff + idx);
+	ptr->async_started = true;
+
+	return 0;
+}
+
+static int32_t no_os_cb_lf_end_async(struct no_os_circular_buffer *desc,
+				     bool is_read)
+{
+	struct no_os_cb_ptr	*ptr;
+
+	ptr = is_read ? &desc->read : &desc->write;
+	if (!ptr->async_started)
+		return -1;
+
+	__atomic_store_n(&ptr->idx, ptr->idx + ptr->async_size,
+			 __ATOMIC_RELEASE);
+	ptr->async_size = 0;
+	ptr->async_started = false;
+	if (!is_read)
+		no_os_cb_lf_update_hwm(desc);
+
+	return 0;
+}
+
+/*
+ * Copy all data or nothing, so that elements of a fixed size (e.g. scans)
+ * are never split by a full or empty buffer.
+ */
+static int32_t no_os_cb_lf_operation(struct no_os_circular_buffer *desc,
+				     void *data, uint32_t size, bool is_read)
+{
+	struct no_os_cb_ptr	*ptr;
+	uint32_t	available_size;
+	uint32_t	idx, first;
+	uint8_t		*buff = (uint8_t *)desc->buff;
+
+	ptr = is_read ? &desc->read : &desc->write;
+	if (ptr->async_started)
+		return -EBUSY;
+
+	available_size = no_os_cb_lf_used(desc);
+	if (!is_read)
+		available_size = desc->size - available_size;
+
+	if (available_size < size) {
+		if (is_read)
+			return -EAGAIN;
+		no_os_cb_lf_count_overrun(desc);
+
+		return -NO_OS_EOVERRUN;
+	}
+
+	idx = ptr->idx & desc->mask;
+	first = no_os_min(size, desc->size - idx);
+	if (is_read) {
+		memcpy(data, buff + idx, first);
+		memcpy((uint8_t *)data + first, buff, size - first);
+	} else {
+		memcpy(buff + idx, data, first);
+		memcpy(buff, (uint8_t *)data + first, size - first);
+	}
+
+	__atomic_store_n(&ptr->idx, ptr->idx + size, __ATOMIC_RELEASE);
+	if (!is_read)
+		no_os_cb_lf_update_hwm(desc);
+
+	return 0;
+}
+
 /**
  * @brief Get the number of elements in the buffer.
  * @param desc - Circular buffer reference
@@ -126,6 +309,11 @@ int32_t no_os_cb_size(struct no_os_circular_buffer *desc, uint32_t *size)
 	if (!desc || !size)
 		return -EINVAL;
 
+	if (desc->lock_free) {
+		*size = no_os_cb_lf_used(desc);
+		return 0;
+	}
+
 	if (desc->write.spin_count > desc->read.spin_count)
 		nb_spins = desc->write.spin_count - desc->read.spin_count;
 	else
@@ -164,6 +352,10 @@ static int32_t no_os_cb_prepare_async_operation(struct no_os_circular_buffer
 	if (!desc || !buff || !raw_size_available)
 		return -EINVAL;
 
+	if (desc->lock_free)
+		return no_os_cb_lf_prepare_async(desc, requested_size, buff,
+						 raw_size_available, is_read);
+
 	ret = 0;
 	/* Select if read or write index will be updated */
 	ptr = is_read ? &desc->read : &desc->write;
@@ -218,6 +410,9 @@ static int32_t no_os_cb_end_async_operation(struct no_os_circular_buffer *desc,
 	if (!desc)
 		return -EINVAL;
 
+	if (desc->lock_free)
+		return no_os_cb_lf_end_async(desc, is_read);
+
 	/* Select if read or write index will be updated */
 	ptr = is_read ? &desc->read : &desc->write;
 
@@ -255,6 +450,9 @@ static int32_t no_os_cb_operation(struct no_os_circular_buffer *desc,
 	if (!desc || !data || !size)
 		return -EINVAL;
 
+	if (desc->lock_free)
+		return no_os_cb_lf_operation(desc, data, size, is_read);
+
 	sticky_overrun = 0;
 	i = 0;
 	while (i < size) {
@@ -300,6 +498,7 @@ static int32_t no_os_cb_operation(struct no_os_circular_buffer *desc,
  *  - 0   - No errors
  *  - -EINVAL   - Wrong parameters used
  *  - -EBUSY    - Asynchronous transaction already started
+ *  - -EAGAIN   - Buffer is full (lock-free mode only)
  */
 int32_t no_os_cb_prepare_async_write(struct no_os_circular_buffer *desc,
 				     uint32_t size_to_write,
@@ -358,6 +557,37 @@ int32_t no_os_cb_end_async_read(struct no_os_circular_buffer *desc)
 }
 /** @} */
 
+/**
+ * @brief End asynchronous write keeping only part of the prepared space.
+ *
+ * Used when the producer reserves space before knowing how much data it will
+ * write. Ending with size 0 cancels the transaction.
+ *
+ * @param desc - Circular buffer reference
+ * @param size - Number of bytes written, at most the size returned by
+ * no_os_cb_prepare_async_write()
+ * @return
+ *  - 0   - No errors
+ *  - -1   - Asynchronous transaction not started
+ *  - -EINVAL        - Wrong parameters used
+ */
+int32_t no_os_cb_end_async_write_partial(struct no_os_circular_buffer *desc,
+		uint32_t size)
+{
+	if (!desc)
+		return -EINVAL;
+
+	if (!desc->write.async_started)
+		return -1;
+
+	if (size > desc->write.async_size)
+		return -EINVAL;
+
+	desc->write.async_size = size;
+
+	return no_os_cb_end_async_operation(desc, 0);
+}
+
 /**
  * @brief Write data to the buffer (Blocking).
  * @param desc - Circular buffer reference
@@ -366,6 +596,8 @@ int32_t no_os_cb_end_async_read(struct no_os_circular_buffer *desc)
  * @return
  *  - 0 - No errors
  *  - -EINVAL      - Wrong parameters used
+ *  - -NO_OS_EOVERRUN - Not enough free space. Nothing was written (lock-free
+ *  mode only)
  */
 int32_t no_os_cb_write(struct no_os_circular_buffer *desc, const void *data,
 		       uint32_t size)
@@ -382,6 +614,7 @@ int32_t no_os_cb_write(struct no_os_circular_buffer *desc, const void *data,
  *  - 0   - No errors
  *  - -EINVAL   - Wrong parameters used
  *  - -NO_OS_EOVERRUN - An overrun occurred and some data have been overwritten
+ *  - -EAGAIN   - Less than size bytes available (lock-free mode only)
  */
 int32_t no_os_cb_read(struct no_os_circular_buffer *desc, void *data,
 		      uint32_t size)
@@ -95,3 +95,74 @@ uint16_t no_os_crc16(const uint16_t * table, const uint8_t *pdata,
 
 	return crc;
 }
+
+/***************************************************************************//**
+ * @brief Creates the CRC-16 slice-by-N lookup tables for a given polynomial.
+ *
+ * Table k holds the CRC-16 of a byte followed by k zero bytes. Table 0 is the
+ * table created by no_os_crc16_populate_msb().
+ *
+ * @param tables     - Pointer to nb_slices consecutive CRC-16 lookup tables.
+ * @param nb_slices  - Number of tables, at least 2. Usually 4 or 8.
+ * @param polynomial - Msb-first representation of desired polynomial.
+ *
+ * @return None.
+*******************************************************************************/
+void no_os_crc16_populate_slices_msb(uint16_t *tables, uint8_t nb_slices,
+				     const uint16_t polynomial)
+{
+	uint16_t *prev;
+	uint8_t k;
+
+	if (!tables || !nb_slices)
+		return;
+
+	no_os_crc16_populate_msb(tables, polynomial);
+	for (k = 1; k < nb_slices; k++) {
+		prev = tables + (k - 1) * NO_OS_CRC16_TABLE_SIZE;
+		for (int16_t n = 0; n < NO_OS_CRC16_TABLE_SIZE; n++)
+			tables[k * NO_OS_CRC16_TABLE_SIZE + n] =
+				(tables[prev[n] >> 8] ^ (prev[n] << 8)) & 0xffff;
+	}
+}
+
+/***************************************************************************//**
+ * @brief Computes the CRC-16 over a buffer of data, nb_slices bytes at a time.
+ *
+ * Gives the same result as no_os_crc16(), with one table lookup per byte but
+ * without the dependency between consecutive lookups.
+ *
+ * @param tables    - Tables created by no_os_crc16_populate_slices_msb().
+ * @param nb_slices - Number of tables. Below 2 the CRC-16 is computed byte by
+ *                    byte.
+ * @param pdata     - Pointer to data buffer.
+ * @param nbytes    - Number of bytes to compute the CRC-16 over.
+ * @param crc       - Initial value for the CRC-16 computation.
+ *
+ * @return crc      - Computed CRC-16 value.
+*******************************************************************************/
+uint16_t no_os_crc16_slice(const uint16_t *tables, uint8_t nb_slices,
+			   const uint8_t *pdata, size_t nbytes, uint16_t crc)
+{
+	const uint16_t *table;
+	uint8_t k;
+
+	if (nb_slices < 2)
+		return no_os_crc16(tables, pdata, nbytes, crc);
+
+	while (nbytes >= nb_slices) {
+		crc ^= (pdata[0] << 8) | pdata[1];
+		table = tables + (nb_slices - 2) * NO_OS_CRC16_TABLE_SIZE;
+		crc = table[NO_OS_CRC16_TABLE_SIZE + (crc >> 8)] ^
+		      table[crc & 0xff];
+		for (k = 2; k < nb_slices; k++) {
+			table -= NO_OS_CRC16_TABLE_SIZE;
+			crc ^= table[pdata[k]];
+		}
+		pdata += nb_slices;
+		nbytes -= nb_slices;
+	}
+
+	return no_os_crc16(tables, pdata, nbytes, crc);
+}
+
@@ -36,91 +36,254 @@
 #include "no_os_fifo.h"
 #include "no_os_error.h"
 #include "no_os_alloc.h"
+#include "no_os_util.h"
+
+/*
+ * The producer publishes data with a release store on head which the consumer
+ * loads with acquire, and the consumer frees space the same way with tail.
+ */
+static inline uint32_t no_os_fifo_used(struct no_os_fifo *fifo)
+{
+	return __atomic_load_n(&fifo->head, __ATOMIC_ACQUIRE) -
+	       __atomic_load_n(&fifo->tail, __ATOMIC_ACQUIRE);
+}
 
 /**
- * @brief Create new fifo element
- * @param buff - Data to be saved in fifo.
+ * @brief Copy data into the fifo storage, starting at counter pos.
+ * @param fifo - Pointer to fifo.
+ * @param pos - Free running counter of the first byte.
+ * @param buff - Data to be copied.
  * @param len - Length of the data.
- * @return fifo element in case of success, NULL otherwise
  */
-static struct no_os_fifo_element * fifo_new_element(char *buff, uint32_t len)
+static void no_os_fifo_copy_in(struct no_os_fifo *fifo, uint32_t pos,
+			       const uint8_t *buff, uint32_t len)
 {
-	struct no_os_fifo_element *q = no_os_calloc(1,
-				       sizeof(struct no_os_fifo_element));
-	if (!q)
-		return NULL;
-
-	q->len = len;
-	q->data = no_os_calloc(1, len);
-	if (!(q->data)) {
-		no_os_free(q);
-		return NULL;
-	}
-	memcpy(q->data, buff, len);
+	uint32_t idx = pos & (fifo->size - 1);
+	uint32_t first = no_os_min(len, fifo->size - idx);
+
+	memcpy(fifo->buff + idx, buff, first);
+	memcpy(fifo->buff, buff + first, len - first);
+}
+
+/**
+ * @brief Copy data out of the fifo storage, starting at counter pos.
+ * @param fifo - Pointer to fifo.
+ * @param pos - Free running counter of the first byte.
+ * @param buff - Where to copy the data.
+ * @param len - Length of the data.
+ */
+static void no_os_fifo_copy_out(struct no_os_fifo *fifo, uint32_t pos,
+				uint8_t *buff, uint32_t len)
+{
+	uint32_t idx = pos & (fifo->size - 1);
+	uint32_t first = no_os_min(len, fifo->size - idx);
 
-	return q;
+	memcpy(buff, fifo->buff + idx, first);
+	memcpy(buff + first, fifo->buff, len - first);
 }
 
 /**
- * @brief Get last element in fifo
- * @param p_fifo - pointer to fifo
- * @return fifo last element if exists, NULL otherwise
+ * @brief Configure a fifo over a user provided buffer.
+ * @param fifo - Pointer to fifo.
+ * @param buff - Storage of the fifo.
+ * @param size - Size of buff. Must be a power of 2.
+ * @return 0 in case of success, -EINVAL otherwise.
  */
-static struct no_os_fifo_element *no_os_fifo_get_last(struct no_os_fifo_element
-		*p_fifo)
+int32_t no_os_fifo_cfg(struct no_os_fifo *fifo, uint8_t *buff, uint32_t size)
 {
-	if (p_fifo == NULL)
-		return NULL;
-	while (p_fifo->next) {
-		p_fifo = p_fifo->next;
+	if (!fifo || !buff || !size || (size & (size - 1)))
+		return -EINVAL;
+
+	memset(fifo, 0, sizeof(*fifo));
+	fifo->buff = buff;
+	fifo->size = size;
+
+	return 0;
+}
+
+/**
+ * @brief Allocate a fifo.
+ * @param fifo - Where to store the fifo reference.
+ * @param size - Size of the fifo in bytes. Must be a power of 2.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int32_t no_os_fifo_init(struct no_os_fifo **fifo, uint32_t size)
+{
+	struct no_os_fifo *p;
+	uint8_t *buff;
+	int32_t ret;
+
+	if (!fifo)
+		return -EINVAL;
+
+	p = no_os_calloc(1, sizeof(*p));
+	if (!p)
+		return -ENOMEM;
+
+	buff = no_os_calloc(1, size);
+	if (!buff) {
+		ret = -ENOMEM;
+		goto free_fifo;
 	}
 
-	return p_fifo;
+	ret = no_os_fifo_cfg(p, buff, size);
+	if (ret)
+		goto free_buff;
+
+	p->alloc_buff = true;
+	*fifo = p;
+
+	return 0;
+
+free_buff:
+	no_os_free(buff);
+free_fifo:
+	no_os_free(p);
+
+	return ret;
+}
+
+/**
+ * @brief Free the resources allocated by no_os_fifo_init.
+ * @param fifo - Pointer to fifo.
+ * @return 0 in case of success, -EINVAL otherwise.
+ */
+int32_t no_os_fifo_remove(struct no_os_fifo *fifo)
+{
+	if (!fifo)
+		return -EINVAL;
+
+	if (fifo->alloc_buff)
+		no_os_free(fifo->buff);
+	no_os_free(fifo);
+
+	return 0;
+}
+
+/**
+ * @brief Get the number of bytes available to read.
+ * @param fifo - Pointer to fifo.
+ * @return Number of bytes in the fifo.
+ */
+uint32_t no_os_fifo_len(struct no_os_fifo *fifo)
+{
+	return no_os_fifo_used(fifo);
+}
+
+/**
+ * @brief Get the number of bytes that can be written.
+ * @param fifo - Pointer to fifo.
+ * @return Free space in the fifo.
+ */
+uint32_t no_os_fifo_space(struct no_os_fifo *fifo)
+{
+	return fifo->size - no_os_fifo_used(fifo);
 }
 
 /**
- * @brief Insert element to fifo, in the last position.
- * @param p_fifo - Pointer to fifo.
+ * @brief Insert data at the fifo tail.
+ *
+ * Producer side. Safe to call from interrupt context.
+ * @param fifo - Pointer to fifo.
  * @param buff - Data to be saved in fifo.
  * @param len - Length of the data.
- * @return 0 in case of success, -1 otherwise
+ * @return Number of bytes inserted. Less than len if the fifo got full, in
+ * which case the overrun counter is incremented.
  */
-int32_t no_os_fifo_insert(struct no_os_fifo_element **p_fifo, char *buff,
-			  uint32_t len)
+uint32_t no_os_fifo_insert(struct no_os_fifo *fifo, const void *buff,
+			   uint32_t len)
 {
-	struct no_os_fifo_element *p, *q;
+	uint32_t head = fifo->head;
+	uint32_t space = no_os_fifo_space(fifo);
 
-	if (len <= 0)
-		return -1;
+	if (len > space) {
+		fifo->overruns++;
+		len = space;
+	}
 
-	q = fifo_new_element(buff, len);
-	if (!q)
-		return -1;
+	no_os_fifo_copy_in(fifo, head, buff, len);
+	__atomic_store_n(&fifo->head, head + len, __ATOMIC_RELEASE);
 
-	if (!(*p_fifo)) {
-		*p_fifo = q;
-	} else {
-		p = no_os_fifo_get_last(*p_fifo);
-		p->next = q;
+	return len;
+}
+
+/**
+ * @brief Remove data from the fifo head.
+ *
+ * Consumer side.
+ * @param fifo - Pointer to fifo.
+ * @param buff - Where to copy the data.
+ * @param len - Maximum number of bytes to remove.
+ * @return Number of bytes removed.
+ */
+uint32_t no_os_fifo_read(struct no_os_fifo *fifo, void *buff, uint32_t len)
+{
+	uint32_t tail = fifo->tail;
+
+	len = no_os_min(len, no_os_fifo_used(fifo));
+	no_os_fifo_copy_out(fifo, tail, buff, len);
+	__atomic_store_n(&fifo->tail, tail + len, __ATOMIC_RELEASE);
+
+	return len;
+}
+
+/**
+ * @brief Insert a packet at the fifo tail.
+ *
+ * Producer side. The packet is stored with a 2 byte length header so that
+ * no_os_fifo_read_pkt() returns it whole.
+ * @param fifo - Pointer to fifo.
+ * @param buff - Packet data.
+ * @param len - Length of the packet.
+ * @return 0 in case of success, -EINVAL for an empty packet,
+ * -NO_OS_EOVERRUN if the packet doesn't fit.
+ */
+int32_t no_os_fifo_insert_pkt(struct no_os_fifo *fifo, const void *buff,
+			      uint16_t len)
+{
+	uint32_t head = fifo->head;
+
+	if (!len)
+		return -EINVAL;
+
+	if (no_os_fifo_space(fifo) < sizeof(len) + len) {
+		fifo->overruns++;
+		return -NO_OS_EOVERRUN;
 	}
 
+	no_os_fifo_copy_in(fifo, head, (uint8_t *)&len, sizeof(len));
+	no_os_fifo_copy_in(fifo, head + sizeof(len), buff, len);
+	__atomic_store_n(&fifo->head, head + sizeof(len) + len, __ATOMIC_RELEASE);
+
 	return 0;
 }
 
 /**
- * @brief Remove fifo head
- * @param p_fifo - Pointer to fifo.
- * @return next element in fifo if exists, NULL otherwise.
+ * @brief Remove the packet at the fifo head.
+ *
+ * Consumer side. Only use on fifos filled with no_os_fifo_insert_pkt().
+ * @param fifo - Pointer to fifo.
+ * @param buff - Where to copy the packet.
+ * @param max_len - Size of buff.
+ * @return Length of the packet in case of success, -EAGAIN if the fifo is
+ * empty, -ENOBUFS if the packet is larger than max_len. In this case the
+ * packet is left in the fifo.
  */
-struct no_os_fifo_element * no_os_fifo_remove(struct no_os_fifo_element *p_fifo)
+int32_t no_os_fifo_read_pkt(struct no_os_fifo *fifo, void *buff,
+			    uint16_t max_len)
 {
-	struct no_os_fifo_element *p = p_fifo;
+	uint32_t tail = fifo->tail;
+	uint16_t len;
 
-	if (p_fifo != NULL) {
-		p_fifo = p_fifo->next;
-		no_os_free(p->data);
-		no_os_free(p);
-	}
+	if (!no_os_fifo_used(fifo))
+		return -EAGAIN;
+
+	no_os_fifo_copy_out(fifo, tail, (uint8_t *)&len, sizeof(len));
+	if (len > max_len)
+		return -ENOBUFS;
+
+	no_os_fifo_copy_out(fifo, tail + sizeof(len), buff, len);
+	__atomic_store_n(&fifo->tail, tail + sizeof(len) + len, __ATOMIC_RELEASE);
 
-	return p_fifo;
+	return len;
 }
@@ -1,6 +1,6 @@
 /***************************************************************************//**
  *   @file   no_os_lf256fifo.c
- *   @brief  SPSC lock-free fifo of fixed size (256), specialized for UART.
+ *   @brief  SPSC lock-free byte fifo with a power of 2 size.
  *   @author Darius Berghe (darius.berghe@analog.com)
 ********************************************************************************
  *   @copyright
@@ -32,44 +32,114 @@
  * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *******************************************************************************/
 #include <errno.h>
+#include <string.h>
 #include "no_os_lf256fifo.h"
 #include "no_os_alloc.h"
+#include "no_os_util.h"
+
+/*
+ * Each side only writes its own free running counter. The producer publishes
+ * data with a release store on fempty which the consumer loads with acquire,
+ * and the consumer frees space the same way with ffilled.
+ */
+static inline uint32_t lf256fifo_used(struct lf256fifo *fifo)
+{
+	return __atomic_load_n(&fifo->fempty, __ATOMIC_ACQUIRE) -
+	       __atomic_load_n(&fifo->ffilled, __ATOMIC_ACQUIRE);
+}
 
 /**
- * @struct lf256fifo
- * @brief Structure holding the fifo element parameters.
+ * @brief Configure a fifo over a buffer provided by the caller, without any
+ * memory allocation.
+ * @param fifo - pointer to fifo descriptor.
+ * @param buf - memory area of the fifo.
+ * @param size - size of buf, must be a power of 2.
+ * @return 0 if successful, negative error code otherwise.
  */
-struct lf256fifo {
-	uint8_t * data; // pointer to memory area where the buffer will be allocated
-	uint8_t ffilled; // the index where the data starts
-	uint8_t fempty; // the index where empty/non-used area starts
-};
+int lf256fifo_cfg(struct lf256fifo *fifo, uint8_t *buf, uint32_t size)
+{
+	if (!fifo || !buf || !size || (size & (size - 1)) || size > 0x80000000)
+		return -EINVAL;
+
+	memset(fifo, 0, sizeof(*fifo));
+	fifo->data = buf;
+	fifo->size = size;
+
+	return 0;
+}
 
 /**
- * @brief Initialize and allocate a lock-free 256 FIFO.
+ * @brief Initialize and allocate a lock-free FIFO of a given size.
  * @param fifo - pointer to a fifo descriptor pointer.
+ * @param size - size of the fifo in bytes, must be a power of 2. 0 selects
+ * LF256FIFO_DEFAULT_SIZE.
  * @return 0 if successful, negative error code otherwise.
  */
-int lf256fifo_init(struct lf256fifo **fifo)
+int lf256fifo_init_size(struct lf256fifo **fifo, uint32_t size)
 {
-	if (fifo == NULL)
+	struct lf256fifo *b;
+	uint8_t *data;
+	int ret;
+
+	if (fifo == NULL || (size & (size - 1)))
 		return -EINVAL;
 
-	struct lf256fifo *b = no_os_calloc(1, sizeof(struct lf256fifo));
+	if (!size)
+		size = LF256FIFO_DEFAULT_SIZE;
+
+	b = no_os_calloc(1, sizeof(struct lf256fifo));
 	if (b == NULL)
 		return -ENOMEM;
 
-	b->data = no_os_calloc(1, 256);
-	if (b->data == NULL) {
+	data = no_os_calloc(1, size);
+	if (data == NULL) {
 		no_os_free(b);
 		return -ENOMEM;
 	}
 
+	ret = lf256fifo_cfg(b, data, size);
+	if (ret) {
+		no_os_free(data);
+		no_os_free(b);
+		return ret;
+	}
+	b->allocated = true;
+
 	*fifo = b;
 
 	return 0;
 }
 
+/**
+ * @brief Initialize and allocate a lock-free 256 FIFO.
+ * @param fifo - pointer to a fifo descriptor pointer.
+ * @return 0 if successful, negative error code otherwise.
+ */
+int lf256fifo_init(struct lf256fifo **fifo)
+{
+	return lf256fifo_init_size(fifo, LF256FIFO_DEFAULT_SIZE);
+}
+
+/**
+ * @brief Get the number of bytes stored in the fifo.
+ * @param fifo - pointer to fifo descriptor.
+ * @return number of bytes that can be read.
+ */
+uint32_t lf256fifo_count(struct lf256fifo *fifo)
+{
+	return lf256fifo_used(fifo);
+}
+
+/**
+ * @brief Get the free space of the fifo.
+ * @param fifo - pointer to fifo descriptor.
+ * @return number of bytes that can be written.
+ */
+uint32_t lf256fifo_space(struct lf256fifo *fifo)
+{
+	return fifo->size - lf256fifo_used(fifo);
+}
+
 /**
  * @brief Test whether fifo is full.
  * @param fifo - pointer to fifo descriptor.
@@ -77,8 +147,7 @@ int lf256fifo_init(struct lf256fifo **fifo)
  */
 bool lf256fifo_is_full(struct lf256fifo *fifo)
 {
-	return (fifo->fempty + 1) ==
-	       fifo->ffilled; // intended overflow at 256 (data size is 256)
+	return lf256fifo_used(fifo) == fifo->size;
 }
 
 /**
@@ -88,7 +157,99 @@ bool lf256fifo_is_full(struct lf256fifo *fifo)
 */
 bool lf256fifo_is_empty(struct lf256fifo *fifo)
 {
-	return fifo->fempty == fifo->ffilled;
+	return !lf256fifo_used(fifo);
+}
+
+/**
+* @brief Copy data from the fifo without consuming it.
+* @param fifo - pointer to fifo descriptor.
+* @param buf - where the data is copied.
+* @param len - maximum number of bytes to copy.
+* @return number of bytes copied.
+*/
+uint32_t lf256fifo_peek(struct lf256fifo *fifo, uint8_t *buf, uint32_t len)
+{
+	uint32_t used = lf256fifo_used(fifo);
+	uint32_t idx, first;
+
+	len = no_os_min(len, used);
+	idx = fifo->ffilled & (fifo->size - 1);
+	first = no_os_min(len, fifo->size - idx);
+
+	memcpy(buf, fifo->data + idx, first);
+	memcpy(buf + first, fifo->data, len - first);
+
+	return len;
+}
+
+/**
+* @brief Read data from the fifo.
+* @param fifo - pointer to fifo descriptor.
+* @param buf - where the data is read.
+* @param len - maximum number of bytes to read.
+* @return number of bytes read, 0 if the fifo is empty.
+*/
+uint32_t lf256fifo_read_bulk(struct lf256fifo *fifo, uint8_t *buf,
+			     uint32_t len)
+{
+	len = lf256fifo_peek(fifo, buf, len);
+	__atomic_store_n(&fifo->ffilled, fifo->ffilled + len, __ATOMIC_RELEASE);
+
+	return len;
+}
+
+/**
+* @brief Write data to the fifo. Data that doesn't fit is not written.
+* @param fifo - pointer to fifo descriptor.
+* @param buf - data to write.
+* @param len - number of bytes to write.
+* @return number of bytes written.
+*/
+uint32_t lf256fifo_write_bulk(struct lf256fifo *fifo, const uint8_t *buf,
+			      uint32_t len)
+{
+	uint32_t space = lf256fifo_space(fifo);
+	uint32_t idx, first;
+
+	len = no_os_min(len, space);
+	idx = fifo->fempty & (fifo->size - 1);
+	first = no_os_min(len, fifo->size - idx);
+
+	memcpy(fifo->data + idx, buf, first);
+	memcpy(fifo->data, buf + first, len - first);
+	__atomic_store_n(&fifo->fempty, fifo->fempty + len, __ATOMIC_RELEASE);
+
+	return len;
+}
+
+/**
+* @brief Get the contiguous free space at the write position, so the producer
+* (e.g. a DMA transfer) can write in place. The data is published with
+* lf256fifo_write_commit().
+* @param fifo - pointer to fifo descriptor.
+* @param buf - where the address of the free space is stored.
+* @return number of contiguous bytes available.
+*/
+uint32_t lf256fifo_write_prepare(struct lf256fifo *fifo, uint8_t **buf)
+{
+	uint32_t space = lf256fifo_space(fifo);
+	uint32_t idx = fifo->fempty & (fifo->size - 1);
+
+	*buf = fifo->data + idx;
+
+	return no_os_min(space, fifo->size - idx);
+}
+
+/**
+* @brief Publish data written in the space returned by
+* lf256fifo_write_prepare().
+* @param fifo - pointer to fifo descriptor.
+* @param len - number of bytes written.
+* @return void
+*/
+void lf256fifo_write_commit(struct lf256fifo *fifo, uint32_t len)
+{
+	__atomic_store_n(&fifo->fempty, fifo->fempty + len, __ATOMIC_RELEASE);
 }
 
 /**
@@ -102,8 +263,8 @@ int lf256fifo_read(struct lf256fifo * fifo, uint8_t *c)
 	if (lf256fifo_is_empty(fifo))
 		return -1; // buffer empty
 
-	*c = fifo->data[fifo->ffilled];
-	fifo->ffilled++; // intended overflow at 256 (data size is 256)
+	*c = fifo->data[fifo->ffilled & (fifo->size - 1)];
+	__atomic_store_n(&fifo->ffilled, fifo->ffilled + 1, __ATOMIC_RELEASE);
 
 	return 0;
 }
@@ -119,30 +280,35 @@ int lf256fifo_write(struct lf256fifo *fifo, uint8_t c)
 	if (lf256fifo_is_full(fifo))
 		return -1; // buffer full
 
-	fifo->data[fifo->fempty] = c;
-	fifo->fempty++; // intended overflow at 256 (data size is 256)
+	fifo->data[fifo->fempty & (fifo->size - 1)] = c;
+	__atomic_store_n(&fifo->fempty, fifo->fempty + 1, __ATOMIC_RELEASE);
 
 	return 0; // return success
 }
 
 /**
-* @brief Flush the fifo.
+* @brief Flush the fifo. Must be called by the consumer.
 * @param fifo - pointer to fifo descriptor.
 * @return void
 */
 void lf256fifo_flush(struct lf256fifo *fifo)
 {
-	fifo->ffilled = fifo->fempty;
+	__atomic_store_n(&fifo->ffilled,
+			 __atomic_load_n(&fifo->fempty, __ATOMIC_ACQUIRE),
+			 __ATOMIC_RELEASE);
 }
 
 /**
-* @brief Remove the fifo
+* @brief Remove the fifo. Fifos configured with lf256fifo_cfg() or
+* LF256FIFO_DEFINE() are not freed.
 * @param fifo - pointer to fifo descriptor.
 * @return void
 */
 void lf256fifo_remove(struct lf256fifo *fifo)
 {
-	if (fifo && fifo->data)
-		no_os_free(fifo->data);
-}
+	if (!fifo || !fifo->allocated)
+		return;
 
+	no_os_free(fifo->data);
+	no_os_free(fifo);
+}
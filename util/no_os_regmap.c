@@ -0,0 +1,457 @@
+/***************************************************************************//**
+ *   @file   no_os_regmap.c
+ *   @brief  Register map cache shared by device drivers.
+ *   @author Analog Devices Inc.
+********************************************************************************
+ *   @copyright
+ * Copyright 2024(c) Analog Devices, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Analog Devices, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ANALOG DEVICES, INC. “AS IS” AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL ANALOG DEVICES, INC. BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <errno.h>
+#include "no_os_regmap.h"
+#include "no_os_alloc.h"
+
+/**
+ * @struct no_os_regmap_cache
+ * @brief Cache of one register range.
+ */
+struct no_os_regmap_cache {
+	/** Cached range */
+	struct no_os_regmap_range range;
+	/** Register values, NULL for volatile ranges */
+	uint32_t *vals;
+	/** Bitmap of the registers with a known value */
+	uint32_t *valid;
+	/** Bitmap of the registers written only to the cache */
+	uint32_t *dirty;
+};
+
+/**
+ * @struct no_os_regmap
+ * @brief Register map descriptor.
+ */
+struct no_os_regmap {
+	/** Device descriptor passed to the access functions */
+	void *ctx;
+	/** Read one register from the device */
+	int (*reg_read)(void *ctx, uint32_t reg, uint32_t *val);
+	/** Write one register to the device */
+	int (*reg_write)(void *ctx, uint32_t reg, uint32_t val);
+	/** Write consecutive registers to the device */
+	int (*bulk_write)(void *ctx, uint32_t reg, const uint32_t *vals,
+			  uint32_t cnt);
+	/** One cache per range */
+	struct no_os_regmap_cache *caches;
+	/** Number of caches */
+	uint32_t nb_caches;
+	/** Set when writes are kept in the cache until a sync */
+	bool cache_only;
+};
+
+static inline bool regmap_bit(const uint32_t *bitmap, uint32_t idx)
+{
+	return bitmap[idx / 32] & (1u << (idx % 32));
+}
+
+static inline void regmap_set_bit(uint32_t *bitmap, uint32_t idx)
+{
+	bitmap[idx / 32] |= 1u << (idx % 32);
+}
+
+static inline void regmap_clear_bit(uint32_t *bitmap, uint32_t idx)
+{
+	bitmap[idx / 32] &= ~(1u << (idx % 32));
+}
+
+/**
+ * @brief Find the cache of a register.
+ * @param map - The register map.
+ * @param reg - Register address.
+ * @return The cache or NULL if the register is volatile.
+ */
+static struct no_os_regmap_cache *regmap_find(struct no_os_regmap *map,
+		uint32_t reg)
+{
+	uint32_t i;
+
+	for (i = 0; i < map->nb_caches; i++)
+		if (reg >= map->caches[i].range.first &&
+		    reg <= map->caches[i].range.last)
+			return map->caches[i].vals ? &map->caches[i] : NULL;
+
+	return NULL;
+}
+
+/**
+ * @brief Initialize a register map.
+ * @param map - The register map.
+ * @param param - Access functions and register ranges.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int no_os_regmap_init(struct no_os_regmap **map,
+		      const struct no_os_regmap_init_param *param)
+{
+	struct no_os_regmap_cache *cache;
+	struct no_os_regmap *m;
+	uint32_t words;
+	uint32_t size;
+	uint32_t i;
+
+	if (!map || !param || !param->reg_read || !param->reg_write ||
+	    (param->nb_ranges && !param->ranges))
+		return -EINVAL;
+
+	m = no_os_calloc(1, sizeof(*m));
+	if (!m)
+		return -ENOMEM;
+
+	m->ctx = param->ctx;
+	m->reg_read = param->reg_read;
+	m->reg_write = param->reg_write;
+	m->bulk_write = param->bulk_write;
+
+	if (param->nb_ranges) {
+		m->caches = no_os_calloc(param->nb_ranges, sizeof(*m->caches));
+		if (!m->caches)
+			goto error;
+	}
+	m->nb_caches = param->nb_ranges;
+
+	for (i = 0; i < m->nb_caches; i++) {
+		cache = &m->caches[i];
+		cache->range = param->ranges[i];
+		if (cache->range.last < cache->range.first)
+			goto error;
+		if (cache->range.policy == NO_OS_REGMAP_VOLATILE)
+			continue;
+
+		/* Values and both bitmaps in a single allocation */
+		size = cache->range.last - cache->range.first + 1;
+		words = (size + 31) / 32;
+		cache->vals = no_os_calloc(size + 2 * words, sizeof(uint32_t));
+		if (!cache->vals)
+			goto error;
+		cache->valid = cache->vals + size;
+		cache->dirty = cache->valid + words;
+	}
+
+	*map = m;
+
+	return 0;
+error:
+	no_os_regmap_remove(m);
+
+	return -ENOMEM;
+}
+
+/**
+ * @brief Free the resources allocated by no_os_regmap_init(). Dirty registers
+ * are not written to the device.
+ * @param map - The register map.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int no_os_regmap_remove(struct no_os_regmap *map)
+{
+	uint32_t i;
+
+	if (!map)
+		return -EINVAL;
+
+	for (i = 0; i < map->nb_caches; i++)
+		no_os_free(map->caches[i].vals);
+	no_os_free(map->caches);
+	no_os_free(map);
+
+	return 0;
+}
+
+/**
+ * @brief Read a register. Cached registers are read from the device only if
+ * their value is not known yet.
+ * @param map - The register map.
+ * @param reg - Register address.
+ * @param val - Register value.
+ * @return 0 in case of success, -ENODATA for a write-only register that was
+ * not written yet, negative error code otherwise.
+ */
+int no_os_regmap_read(struct no_os_regmap *map, uint32_t reg, uint32_t *val)
+{
+	struct no_os_regmap_cache *cache;
+	uint32_t idx;
+	int ret;
+
+	if (!map || !val)
+		return -EINVAL;
+
+	cache = regmap_find(map, reg);
+	if (!cache)
+		return map->reg_read(map->ctx, reg, val);
+
+	idx = reg - cache->range.first;
+	if (regmap_bit(cache->valid, idx)) {
+		*val = cache->vals[idx];
+		return 0;
+	}
+
+	if (cache->range.policy == NO_OS_REGMAP_WRITE_ONLY)
+		return -ENODATA;
+
+	ret = map->reg_read(map->ctx, reg, val);
+	if (ret)
+		return ret;
+
+	cache->vals[idx] = *val;
+	regmap_set_bit(cache->valid, idx);
+
+	return 0;
+}
+
+/**
+ * @brief Write a register. Writing a cached register with the value it
+ * already holds doesn't access the device. In cache only mode, cached
+ * registers are only marked dirty.
+ * @param map - The register map.
+ * @param reg - Register address.
+ * @param val - Register value.
+ * @return 0 in case of success, -EBUSY for a volatile register in cache only
+ * mode, negative error code otherwise.
+ */
+int no_os_regmap_write(struct no_os_regmap *map, uint32_t reg, uint32_t val)
+{
+	struct no_os_regmap_cache *cache;
+	uint32_t idx;
+	int ret;
+
+	if (!map)
+		return -EINVAL;
+
+	cache = regmap_find(map, reg);
+	if (!cache) {
+		if (map->cache_only)
+			return -EBUSY;
+		return map->reg_write(map->ctx, reg, val);
+	}
+
+	idx = reg - cache->range.first;
+	if (regmap_bit(cache->valid, idx) && cache->vals[idx] == val)
+		return 0;
+
+	cache->vals[idx] = val;
+	regmap_set_bit(cache->valid, idx);
+	if (map->cache_only) {
+		regmap_set_bit(cache->dirty, idx);
+		return 0;
+	}
+
+	ret = map->reg_write(map->ctx, reg, val);
+	if (ret) {
+		/* The device state is unknown */
+		regmap_clear_bit(cache->valid, idx);
+		regmap_clear_bit(cache->dirty, idx);
+		return ret;
+	}
+	regmap_clear_bit(cache->dirty, idx);
+
+	return 0;
+}
+
+/**
+ * @brief Update bits of a register. For cached registers, the read is served
+ * from the cache and the write is skipped if the value doesn't change.
+ * @param map - The register map.
+ * @param reg - Register address.
+ * @param mask - Bits to be updated.
+ * @param val - New value of the bits, in register position.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int no_os_regmap_update_bits(struct no_os_regmap *map, uint32_t reg,
+			     uint32_t mask, uint32_t val)
+{
+	uint32_t data;
+	int ret;
+
+	ret = no_os_regmap_read(map, reg, &data);
+	if (ret)
+		return ret;
+
+	return no_os_regmap_write(map, reg, (data & ~mask) | (val & mask));
+}
+
+/**
+ * @brief Enable or disable cache only mode. While enabled, writes to cached
+ * registers only update the cache and are sent with no_os_regmap_sync().
+ * Disabling the mode doesn't sync.
+ * @param map - The register map.
+ * @param enable - true to enable the mode.
+ */
+void no_os_regmap_cache_only(struct no_os_regmap *map, bool enable)
+{
+	if (map)
+		map->cache_only = enable;
+}
+
+/**
+ * @brief Write the dirty registers of one cache in an address range.
+ * Consecutive dirty registers are written with bulk_write, if available.
+ * @param map - The register map.
+ * @param cache - The cache.
+ * @param first - First register address.
+ * @param last - Last register address, included.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+static int regmap_sync_cache(struct no_os_regmap *map,
+			     struct no_os_regmap_cache *cache,
+			     uint32_t first, uint32_t last)
+{
+	uint32_t start = first - cache->range.first;
+	uint32_t end = last - cache->range.first;
+	uint32_t i, j, k;
+	int ret;
+
+	for (i = start; i <= end; i = j) {
+		j = i + 1;
+		if (!regmap_bit(cache->dirty, i))
+			continue;
+
+		while (j <= end && regmap_bit(cache->dirty, j))
+			j++;
+
+		if (map->bulk_write && j - i > 1) {
+			ret = map->bulk_write(map->ctx, cache->range.first + i,
+					      &cache->vals[i], j - i);
+			if (ret)
+				return ret;
+		} else {
+			for (k = i; k < j; k++) {
+				ret = map->reg_write(map->ctx, cache->range.first + k,
+						     cache->vals[k]);
+				if (ret)
+					return ret;
+			}
+		}
+
+		for (k = i; k < j; k++)
+			regmap_clear_bit(cache->dirty, k);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Write the dirty registers in an address range to the device.
+ * @param map - The register map.
+ * @param first - First register address.
+ * @param last - Last register address, included.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int no_os_regmap_sync_range(struct no_os_regmap *map, uint32_t first,
+			    uint32_t last)
+{
+	struct no_os_regmap_cache *cache;
+	uint32_t i;
+	int ret;
+
+	if (!map || last < first)
+		return -EINVAL;
+
+	for (i = 0; i < map->nb_caches; i++) {
+		cache = &map->caches[i];
+		if (!cache->vals || cache->range.last < first ||
+		    cache->range.first > last)
+			continue;
+
+		ret = regmap_sync_cache(map, cache,
+					first > cache->range.first ?
+					first : cache->range.first,
+					last < cache->range.last ?
+					last : cache->range.last);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Write all the dirty registers to the device.
+ * @param map - The register map.
+ * @return 0 in case of success, negative error code otherwise.
+ */
+int no_os_regmap_sync(struct no_os_regmap *map)
+{
+	return no_os_regmap_sync_range(map, 0, UINT32_MAX);
+}
+
+/**
+ * @brief Mark all the known registers as dirty, so the next sync writes them.
+ * Used to restore the configuration after the device lost it, e.g. on reset.
+ * @param map - The register map.
+ */
+void no_os_regmap_mark_dirty(struct no_os_regmap *map)
+{
+	struct no_os_regmap_cache *cache;
+	uint32_t words;
+	uint32_t i, j;
+
+	if (!map)
+		return;
+
+	for (i = 0; i < map->nb_caches; i++) {
+		cache = &map->caches[i];
+		if (!cache->vals)
+			continue;
+		words = (cache->range.last - cache->range.first + 32) / 32;
+		for (j = 0; j < words; j++)
+			cache->dirty[j] = cache->valid[j];
+	}
+}
+
+/**
+ * @brief Forget all the cached values, e.g. after a device reset.
+ * @param map - The register map.
+ */
+void no_os_regmap_cache_drop(struct no_os_regmap *map)
+{
+	struct no_os_regmap_cache *cache;
+	uint32_t words;
+	uint32_t i, j;
+
+	if (!map)
+		return;
+
+	for (i = 0; i < map->nb_caches; i++) {
+		cache = &map->caches[i];
+		if (!cache->vals)
+			continue;
+		words = (cache->range.last - cache->range.first + 32) / 32;
+		for (j = 0; j < words; j++) {
+			cache->valid[j] = 0;
+			cache->dirty[j] = 0;
+		}
+	}
+}
@@ -0,0 +1,345 @@
+/***************************************************************************//**
+ *   @file   no_os_unpack.c
+ *   @brief  Unpacking of packed sample streams, as captured from converters.
+ *   @author Analog Devices Inc.
+********************************************************************************
+ *   @copyright
+ * Copyright 2024(c) Analog Devices, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of Analog Devices, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ANALOG DEVICES, INC. “AS IS” AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL ANALOG DEVICES, INC. BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include <errno.h>
+#include "no_os_unpack.h"
+
+/*
+ * The unpackers work a word at a time: each sample is extracted from a 64-bit
+ * load starting at the byte holding its first bit, which always covers a
+ * sample of up to 32 bits wide. Samples are handled in groups of 8, taking a
+ * whole number of bytes, and the common widths get a group loop of their own
+ * in which every offset and shift is a constant. The loops carry no state
+ * from one sample to the next, leaving them open to the compiler's
+ * vectorizer.
+ */
+
+static inline uint64_t no_os_unpack_load_be64(const uint8_t *p)
+{
+	return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+	       ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+	       ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+	       ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+
+static inline uint64_t no_os_unpack_load_le64(const uint8_t *p)
+{
+	return ((uint64_t)p[7] << 56) | ((uint64_t)p[6] << 48) |
+	       ((uint64_t)p[5] << 40) | ((uint64_t)p[4] << 32) |
+	       ((uint64_t)p[3] << 24) | ((uint64_t)p[2] << 16) |
+	       ((uint64_t)p[1] << 8) | (uint64_t)p[0];
+}
+
+/**
+ * @brief Load up to 8 bytes, the missing ones being read as 0. Used for the
+ * last samples of a stream, so that no byte past its end is touched.
+ * @param p - Address of the first byte.
+ * @param len - Number of bytes that may be read.
+ * @param order - Bit order of the stream.
+ * @return The loaded word.
+ */
+static uint64_t no_os_unpack_load_tail(const uint8_t *p, uint32_t len,
+				       enum no_os_unpack_order order)
+{
+	uint8_t tmp[8] = {0};
+	uint32_t i;
+
+	for (i = 0; i < len && i < 8; i++)
+		tmp[i] = p[i];
+
+	if (order == NO_OS_UNPACK_BE)
+		return no_os_unpack_load_be64(tmp);
+
+	return no_os_unpack_load_le64(tmp);
+}
+
+/* Extract the sample starting at bit bitpos of a MSB first stream. */
+static inline uint32_t no_os_unpack_one_be(const uint8_t *src, uint32_t bitpos,
+		uint8_t bits)
+{
+	uint64_t word = no_os_unpack_load_be64(src + (bitpos >> 3));
+
+	return (word << (bitpos & 7)) >> (64 - bits);
+}
+
+/* Extract the sample starting at bit bitpos of a LSB first stream. */
+static inline uint32_t no_os_unpack_one_le(const uint8_t *src, uint32_t bitpos,
+		uint8_t bits)
+{
+	uint64_t word = no_os_unpack_load_le64(src + (bitpos >> 3));
+
+	return (word >> (bitpos & 7)) & ((1ULL << bits) - 1);
+}
+
+/*
+ * Unpack nb_groups groups of 8 samples, a group taking exactly bits bytes.
+ * Expanded with a constant width, all the offsets and shifts of a group are
+ * known at build time.
+ */
+#define NO_OS_UNPACK_GROUPS(_src, _dst, _nb_groups, _bits, _order)		\
+	do {									\
+		const uint8_t *_s = (_src);					\
+		uint32_t *_d = (_dst);						\
+		uint32_t _g;							\
+		if ((_order) == NO_OS_UNPACK_BE) {				\
+			for (_g = 0; _g < (_nb_groups); _g++) {			\
+				_d[0] = no_os_unpack_one_be(_s, 0 * (_bits), (_bits)); \
+				_d[1] = no_os_unpack_one_be(_s, 1 * (_bits), (_bits)); \
+				_d[2] = no_os_unpack_one_be(_s, 2 * (_bits), (_bits)); \
+				_d[3] = no_os_unpack_one_be(_s, 3 * (_bits), (_bits)); \
+				_d[4] = no_os_unpack_one_be(_s, 4 * (_bits), (_bits)); \
+				_d[5] = no_os_unpack_one_be(_s, 5 * (_bits), (_bits)); \
+				_d[6] = no_os_unpack_one_be(_s, 6 * (_bits), (_bits)); \
+				_d[7] = no_os_unpack_one_be(_s, 7 * (_bits), (_bits)); \
+				_s += (_bits);					\
+				_d += 8;					\
+			}							\
+		} else {							\
+			for (_g = 0; _g < (_nb_groups); _g++) {			\
+				_d[0] = no_os_unpack_one_le(_s, 0 * (_bits), (_bits)); \
+				_d[1] = no_os_unpack_one_le(_s, 1 * (_bits), (_bits)); \
+				_d[2] = no_os_unpack_one_le(_s, 2 * (_bits), (_bits)); \
+				_d[3] = no_os_unpack_one_le(_s, 3 * (_bits), (_bits)); \
+				_d[4] = no_os_unpack_one_le(_s, 4 * (_bits), (_bits)); \
+				_d[5] = no_os_unpack_one_le(_s, 5 * (_bits), (_bits)); \
+				_d[6] = no_os_unpack_one_le(_s, 6 * (_bits), (_bits)); \
+				_d[7] = no_os_unpack_one_le(_s, 7 * (_bits), (_bits)); \
+				_s += (_bits);					\
+				_d += 8;					\
+			}							\
+		}								\
+	} while (0)
+
+/**
+ * @brief Unpack samples one at a time, whatever their alignment.
+ * @param src - Packed stream.
+ * @param src_len - Size of the packed stream, in bytes.
+ * @param dst - Unpacked samples.
+ * @param first - Index of the first sample to unpack.
+ * @param nb_samples - Index of the last sample to unpack + 1.
+ * @param bits - Width of a sample.
+ * @param order - Bit order of the stream.
+ */
+static void no_os_unpack_samples(const uint8_t *src, uint32_t src_len,
+				 uint32_t *dst, uint32_t first,
+				 uint32_t nb_samples, uint8_t bits,
+				 enum no_os_unpack_order order)
+{
+	uint64_t bitpos, word;
+	uint32_t i;
+
+	/* Same as no_os_unpack_one_be/le(), without reading past the stream. */
+	for (i = first; i < nb_samples; i++) {
+		bitpos = (uint64_t)i * bits;
+		word = no_os_unpack_load_tail(src + (bitpos >> 3),
+					      src_len - (bitpos >> 3), order);
+		if (order == NO_OS_UNPACK_BE)
+			dst[i] = (word << (bitpos & 7)) >> (64 - bits);
+		else
+			dst[i] = (word >> (bitpos & 7)) & ((1ULL << bits) - 1);
+	}
+}
+
+/**
+ * @brief Unpack a stream of bits wide samples into 32-bit words.
+ * @param src - Packed stream, holding nb_samples * bits bits, rounded up to
+ * 		a whole number of bytes.
+ * @param dst - Unpacked samples, right aligned and zero extended. Must not
+ * 		overlap with src.
+ * @param nb_samples - Number of samples.
+ * @param bits - Width of a sample, 1 to 32 bits.
+ * @param order - Bit order of the stream.
+ * @return 0 in case of success, -EINVAL otherwise.
+ */
+int no_os_unpack(const uint8_t *src, uint32_t *dst, uint32_t nb_samples,
+		 uint8_t bits, enum no_os_unpack_order order)
+{
+	uint32_t src_len, nb_groups, tail, i;
+
+	if (!src || !dst || !bits || bits > 32)
+		return -EINVAL;
+
+	src_len = ((uint64_t)nb_samples * bits + 7) / 8;
+
+	switch (bits) {
+	case 8:
+		for (i = 0; i < nb_samples; i++)
+			dst[i] = src[i];
+		return 0;
+	case 16:
+		if (order == NO_OS_UNPACK_BE)
+			for (i = 0; i < nb_samples; i++)
+				dst[i] = ((uint32_t)src[2 * i] << 8) | src[2 * i + 1];
+		else
+			for (i = 0; i < nb_samples; i++)
+				dst[i] = ((uint32_t)src[2 * i + 1] << 8) | src[2 * i];
+		return 0;
+	case 24:
+		if (order == NO_OS_UNPACK_BE)
+			for (i = 0; i < nb_samples; i++)
+				dst[i] = ((uint32_t)src[3 * i] << 16) |
+					 ((uint32_t)src[3 * i + 1] << 8) | src[3 * i + 2];
+		else
+			for (i = 0; i < nb_samples; i++)
+				dst[i] = ((uint32_t)src[3 * i + 2] << 16) |
+					 ((uint32_t)src[3 * i + 1] << 8) | src[3 * i];
+		return 0;
+	case 32:
+		if (order == NO_OS_UNPACK_BE)
+			for (i = 0; i < nb_samples; i++)
+				dst[i] = ((uint32_t)src[4 * i] << 24) |
+					 ((uint32_t)src[4 * i + 1] << 16) |
+					 ((uint32_t)src[4 * i + 2] << 8) | src[4 * i + 3];
+		else
+			for (i = 0; i < nb_samples; i++)
+				dst[i] = ((uint32_t)src[4 * i + 3] << 24) |
+					 ((uint32_t)src[4 * i + 2] << 16) |
+					 ((uint32_t)src[4 * i + 1] << 8) | src[4 * i];
+		return 0;
+	default:
+		break;
+	}
+
+	/*
+	 * The load of the last sample of a group reads up to 8 bytes past its
+	 * first byte, so the groups too close to the end of the stream are
+	 * left to the tail loop.
+	 */
+	tail = (7 * bits) / 8 + 8;
+	nb_groups = (src_len < tail) ? 0 : (src_len - tail) / bits + 1;
+	if (nb_groups > nb_samples / 8)
+		nb_groups = nb_samples / 8;
+
+	switch (bits) {
+	case 12:
+		NO_OS_UNPACK_GROUPS(src, dst, nb_groups, 12, order);
+		break;
+	case 14:
+		NO_OS_UNPACK_GROUPS(src, dst, nb_groups, 14, order);
+		break;
+	case 18:
+		NO_OS_UNPACK_GROUPS(src, dst, nb_groups, 18, order);
+		break;
+	case 20:
+		NO_OS_UNPACK_GROUPS(src, dst, nb_groups, 20, order);
+		break;
+	case 26:
+		NO_OS_UNPACK_GROUPS(src, dst, nb_groups, 26, order);
+		break;
+	default:
+		NO_OS_UNPACK_GROUPS(src, dst, nb_groups, bits, order);
+		break;
+	}
+
+	no_os_unpack_samples(src, src_len, dst, nb_groups * 8, nb_samples, bits,
+			     order);
+
+	return 0;
+}
+
+/**
+ * @brief Sign extend bits wide samples stored in 32-bit words, in place.
+ * @param buf - Samples, right aligned. The bits above the sample are ignored.
+ * @param nb_samples - Number of samples.
+ * @param bits - Width of a sample, 1 to 32 bits.
+ * @return 0 in case of success, -EINVAL otherwise.
+ */
+int no_os_unpack_sign_extend(uint32_t *buf, uint32_t nb_samples, uint8_t bits)
+{
+	uint32_t sign, mask, i;
+
+	if (!buf || !bits || bits > 32)
+		return -EINVAL;
+
+	if (bits == 32)
+		return 0;
+
+	/* (x ^ sign) - sign, with x masked to the sample width */
+	sign = 1UL << (bits - 1);
+	mask = (1UL << bits) - 1;
+	for (i = 0; i < nb_samples; i++)
+		buf[i] = ((buf[i] & mask) ^ sign) - sign;
+
+	return 0;
+}
+
+/**
+ * @brief Gather the odd bits of each 16-bit lane of a word in the low byte of
+ * the lane.
+ * @param x - Four 16-bit lanes.
+ * @return Four 16-bit lanes, holding the gathered bits in their low byte.
+ */
+static inline uint64_t no_os_unpack_gather_odd(uint64_t x)
+{
+	x = (x >> 1) & 0x5555555555555555ULL;
+	x = (x | (x >> 1)) & 0x3333333333333333ULL;
+	x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+	x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+
+	return x;
+}
+
+/**
+ * @brief Split a stream of two bit interleaved lanes into one stream per lane,
+ * as produced by converters sharing a single data line between two channels.
+ * Each pair of bytes holds one byte of each lane, the first lane owning the
+ * most significant bit.
+ * @param src - Interleaved stream, of 2 * nb_pairs bytes.
+ * @param nb_pairs - Number of byte pairs.
+ * @param dst0 - Bytes of the first lane.
+ * @param dst1 - Bytes of the second lane.
+ */
+void no_os_unpack_deinterleave2(const uint8_t *src, uint32_t nb_pairs,
+				uint8_t *dst0, uint8_t *dst1)
+{
+	uint64_t word, lane0, lane1;
+	uint32_t i, j;
+
+	/* Four byte pairs at a time, one in each 16-bit lane of a word. */
+	for (i = 0; i + 4 <= nb_pairs; i += 4) {
+		word = no_os_unpack_load_be64(src + 2 * i);
+		lane0 = no_os_unpack_gather_odd(word);
+		lane1 = no_os_unpack_gather_odd(word << 1);
+		for (j = 0; j < 4; j++) {
+			dst0[i + j] = lane0 >> (48 - 16 * j);
+			dst1[i + j] = lane1 >> (48 - 16 * j);
+		}
+	}
+
+	for (; i < nb_pairs; i++) {
+		word = ((uint64_t)src[2 * i] << 8) | src[2 * i + 1];
+		dst0[i] = no_os_unpack_gather_odd(word);
+		dst1[i] = no_os_unpack_gather_odd(word << 1);
+	}
+}